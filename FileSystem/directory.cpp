@@ -1,12 +1,7 @@
-// 
-// TODO: empty directories? specifically related to the endOfDir var
-// 
-
 #include "directory.h"
-#include "wx/log.h"
-#include "wx/tokenzr.h"
 
 #include <stdio.h>
+#include <string.h>
 
 Directory::Directory(const char *rom)
 {
@@ -17,6 +12,13 @@ Directory::Directory(const char *rom)
 
 	memset(&directoryHeader, 0, sizeof(directoryHeader));
 
+	directoryBlock = 0;
+	directoryBlocks = 0;
+	block = NULL;
+	blockIndex = 0;
+	blocksLoaded = 0;
+	entryOffset = 0;
+
 	// 
 	// seems like a decent thing to do.  keeps you from
 	// enumerating with no directory open at least
@@ -43,10 +45,9 @@ Directory::~Directory()
 
 bool Directory::openDirectory(const char *path)
 {
-	bool              ret;
-	wxString          separator(_T("/"));
-	wxString          token;
-	wxStringTokenizer tokenizer(reinterpret_cast<const wxChar *>(path), separator);
+	bool              ret = true;
+	std::string       token;
+	const char        *start, *end;
 	VolumeHeader      volumeHeader;
 	DirectoryEntry    dirEntry, *newEntry, *oldEntry;
 
@@ -55,7 +56,7 @@ bool Directory::openDirectory(const char *path)
 	// 
 	if (strlen(path) <= 0)
 	{
-		wxLogMessage(_T("openDirectory(): path is empty"));
+		logMessage("openDirectory(): path is empty");
 		return false;
 	}
 
@@ -64,16 +65,7 @@ bool Directory::openDirectory(const char *path)
 	// 
 	if (path[0] != '/')
 	{
-		wxLogMessage(_T("openDirectory(): path is not absolute, openDirectory only takes absolute paths"));
-		return false;
-	}
-
-	// 
-	// check if our path is somewhat sane
-	// 
-	if (!tokenizer.HasMoreTokens())
-	{
-		wxLogMessage(_T("openDirectory(): couldn't find any /'s in the path"));
+		logMessage("openDirectory(): path is not absolute, openDirectory only takes absolute paths");
 		return false;
 	}
 
@@ -84,7 +76,7 @@ bool Directory::openDirectory(const char *path)
 
 	if (!ret)
 	{
-		wxLogMessage(_T("openDirectory(): could not seek to the beginning of the filesystem"));
+		logMessage("openDirectory(): could not seek to the beginning of the filesystem");
 		return false;
 	}
 
@@ -102,18 +94,7 @@ bool Directory::openDirectory(const char *path)
 
 	if (!ret)
 	{
-		wxLogMessage(_T("openDirectory(): could not read volume header from the filesystem"));
-		return false;
-	}
-
-	// 
-	// read the root directory's header
-	// 
-	ret = fileSystem.readDirectoryHeader(&directoryHeader);
-
-	if (!ret)
-	{
-		wxLogMessage(_T("openDirectory(): could not read directory header from the filesystem"));
+		logMessage("openDirectory(): could not read volume header from the filesystem");
 		return false;
 	}
 
@@ -130,25 +111,43 @@ bool Directory::openDirectory(const char *path)
 	newEntry->copies = volumeHeader.rootDirCopies[0];
 
 	dirTree.push_front(newEntry);
-	
+
+	// 
+	// read the root directory's first block
+	// 
+	ret = loadDirectory(newEntry);
+
+	if (!ret)
+	{
+		logMessage("openDirectory(): could not read directory header from the filesystem");
+		return false;
+	}
+
 	// 
 	// our current path
 	// 
-	this->path = _T("/");
+	this->path = "/";
 
-	while (tokenizer.HasMoreTokens())
+	for (start = path; *start; start = end)
 	{
-		token = tokenizer.GetNextToken();
+		while (*start == '/')
+			start++;
+
+		end = strchr(start, '/');
+		if (!end)
+			end = start + strlen(start);
 
-		if (token.IsEmpty())
+		if (end == start)
 			continue;
 
-		ret = findInCurrentDirectory(reinterpret_cast<const char *>(token.c_str()), &dirEntry);
+		token.assign(start, end - start);
+
+		ret = findInCurrentDirectory(token.c_str(), &dirEntry);
 
 		if (!ret)
 		{
-			wxLogMessage(
-				_T("openDirectory(): findInCurrentDirectory failed for path element %s"),
+			logMessage(
+				"openDirectory(): findInCurrentDirectory failed for path element %s",
 				token.c_str());
 			break;
 		}
@@ -169,99 +168,109 @@ bool Directory::closeDirectory()
 bool Directory::changeDirectory(const char *path)
 {
 	DirectoryEntry dirEntry;
-	wxString       pathString(reinterpret_cast<const wxChar *>(path)), token;
+	std::string    pathString(path), token;
+	size_t         separator;
 	bool           ret;
 
-	if (pathString.IsEmpty())
+	if (pathString.empty())
 		return false;
 
 	// 
 	// if our path start with /, then it's an absolute
 	// path and we'll just call openDirectory
 	// 
-	if (pathString.StartsWith(_T("/")))
+	if (pathString[0] == '/')
 	{
-		wxLogMessage(_T("changeDirectory(): path starts with '/'. calling openDirectory"));
+		logMessage("changeDirectory(): path starts with '/'. calling openDirectory");
 		return openDirectory(path);
 	}
 
 	do
 	{
-		token = pathString.BeforeFirst('/');
+		separator = pathString.find('/');
+		token = pathString.substr(0, separator);
 
-		ret = findInCurrentDirectory(reinterpret_cast<const char *>(token.c_str()), &dirEntry);
+		ret = findInCurrentDirectory(token.c_str(), &dirEntry);
 
 		if (!ret)
 		{
-			wxLogMessage(_T("changeDirectory(): findInCurrentDirectory failed for token %s"), token.c_str());
+			logMessage("changeDirectory(): findInCurrentDirectory failed for token %s", token.c_str());
 			return false;
 		}
 
-		pathString = pathString.AfterFirst('/');
-	} while (pathString.Length());
+		pathString = (separator == std::string::npos) ? "" : pathString.substr(separator + 1);
+	} while (pathString.length());
 
 	return true;
 }
 
 const char *Directory::getPath()
 {
-	return reinterpret_cast<const char *>(path.c_str());
+	return path.c_str();
 }
 
 bool Directory::enumerateDirectory(DirectoryEntry *de)
 {
-	bool ret;
+	uint32_t length;
 
 	// 
 	// this is only set if enumerateDirectory has previously seen
 	// a directory entry with with a DirectoryEntryPosLastInDir mask
 	// 
 	if (endOfDir)
+		return false;
+
+	// 
+	// the entries of a block end at its first unused byte.  this also
+	// takes care of empty directories
+	// 
+	if (entryOffset >= directoryHeader.unusedOffset)
 	{
-		wxLogMessage(_T("enumerateDirectory(): no more directories left to enumerate."));
+		endOfDir = true;
 		return false;
 	}
 
-	ret = fileSystem.readDirectoryEntry(de);
+	length = FileSystem::parseDirectoryEntry(
+		block + entryOffset,
+		fileSystem.getBlockSize() - entryOffset,
+		de);
 
-	if (!ret)
+	if (!length)
 	{
-		wxLogMessage(_T("enumerateDirectory(): readDirectoryEntry failed."));
+		logMessage("enumerateDirectory(): directory entry runs past the end of the block.");
+		endOfDir = true;
 		return false;
 	}
-	else if ((de->flags & DirectoryEntryPosMask) == DirectoryEntryPosLastInBlock)
-	{
-		wxLogMessage(
-			_T("enumerateDirectory(): found last entry in block, block size is %d, unused offset is %d"),
-			fileSystem.getBlockSize(),
-			directoryHeader.unusedOffset);
 
+	entryOffset += length;
+
+	if ((de->flags & DirectoryEntryPosMask) == DirectoryEntryPosLastInBlock)
+	{
 		// 
-		// move to the beginning of the next directory header
+		// move on to the next block of the directory, if there is one
 		// 
-		ret = fileSystem.seekToByte(
-			fileSystem.getBlockSize() - directoryHeader.unusedOffset, 
-			true);
-
-		if (!ret)
+		if (directoryHeader.nextBlock < 0 || (uint32_t)directoryHeader.nextBlock >= directoryBlocks)
 		{
-			wxLogMessage(_T("enumerateDirectory(): failed to seek to beginning of new directory header"));
-			return false;
+			logMessage("enumerateDirectory(): last entry in block, but no next block.");
+			endOfDir = true;
 		}
-
-		ret = fileSystem.readDirectoryHeader(&directoryHeader);
-
-		if (!ret)
+		else if (blocksLoaded >= directoryBlocks)
 		{
-			wxLogMessage(_T("enumerateDirectory(): failed to read the next directory header"));
-			return false;
+			// 
+			// a directory has no more blocks than its entry says, so
+			// a next block past that count links back to one already seen
+			// 
+			logMessage("enumerateDirectory(): directory blocks link back to an earlier block.");
+			endOfDir = true;
+		}
+		else if (!loadBlock(directoryHeader.nextBlock))
+		{
+			logMessage("enumerateDirectory(): failed to read the next directory block");
+			endOfDir = true;
 		}
-
-		return true;
 	}
 	else if ((de->flags & DirectoryEntryPosMask) == DirectoryEntryPosLastInDir)
 	{
-		wxLogMessage(_T("enumerateDirectory(): found last directory entry in the directory."));
 		endOfDir = true;
 	}
 
@@ -278,7 +287,7 @@ bool Directory::findInCurrentDirectory(const char *item, DirectoryEntry *dirEntr
 	// 
 	if (dirTree.empty())
 	{
-		wxLogMessage(_T("findInCurrentDirectory(): find anything without an open directory"));
+		logMessage("findInCurrentDirectory(): find anything without an open directory");
 		return false;
 	}
 
@@ -289,34 +298,28 @@ bool Directory::findInCurrentDirectory(const char *item, DirectoryEntry *dirEntr
 
 	if (strcmp(item, "..") == 0)
 	{
-		DirectoryEntry *currentEntry = dirTree.front();
+		// the root has no parent
+		if (dirTree.size() < 2)
+			return false;
+
+		currentEntry = dirTree.front();
 		dirTree.pop_front();
 		newEntry = dirTree.front();
 
-		ret = fileSystem.seekToBlock(newEntry->copies, false);
-
-		if (!ret)
-		{
-			wxLogMessage(_T("changeDirectory(): couldn't seek to directory %s"), (char *)newEntry->fileName);
-			dirTree.push_front(currentEntry);
-			return false;
-		}
-
-		ret = fileSystem.readDirectoryHeader(&directoryHeader);
+		ret = loadDirectory(newEntry);
 
 		if (!ret)
 		{
-			wxLogMessage(_T("changeDirectory: found directory %s but failed to read it's header"), (char *)newEntry->fileName);
+			logMessage("changeDirectory(): couldn't read directory %s", (char *)newEntry->fileName);
 			dirTree.push_front(currentEntry);
 			return false;
 		}
 
 		// remove the rightmost path element from our current path
-		path = path.Left(path.Length() - (strlen((char *)currentEntry->fileName) + 1));
+		path.erase(path.length() - (strlen((char *)currentEntry->fileName) + 1));
 
 		// cleanup
-		if (currentEntry)
-			delete currentEntry;
+		delete currentEntry;
 
 		endOfDir = false;
 
@@ -324,55 +327,35 @@ bool Directory::findInCurrentDirectory(const char *item, DirectoryEntry *dirEntr
 	}
 
 	// 
-	// move the filesystem fp to the beginning of the dir and reset
-	// the end of directory indicator so we can enumerate
+	// move to the beginning of the dir and reset the end of
+	// directory indicator so we can enumerate
 	// 
 
 	currentEntry = dirTree.front();
-	ret = fileSystem.seekToBlock(currentEntry->copies, false);
-
-	if (!ret)
-	{
-		wxLogMessage(
-			_T("findInCurrentDirectory(): couldn't move to beginning of directory %s"), 
-			(char *)currentEntry->fileName);
-		return false;
-	}
-
-	ret = fileSystem.readDirectoryHeader(&directoryHeader);
+	ret = loadDirectory(currentEntry);
 
 	if (!ret)
 	{
-		wxLogMessage(
-			_T("findInCurrentDirectory(): couldn't read directory header for %s"),
+		logMessage(
+			"findInCurrentDirectory(): couldn't read directory %s",
 			(char *)currentEntry->fileName);
 		return false;
 	}
 
-	endOfDir = false;
-
 	while (enumerateDirectory(dirEntry))
 	{
-		if (strcmp((char *)dirEntry->fileName, item) == 0)
+		if (strncmp((char *)dirEntry->fileName, item, sizeof(dirEntry->fileName)) == 0)
 		{
 			// 
 			// we found what we wanted.
 			// move to the beginning of the directory and read the header
 			// 
 
-			ret = fileSystem.seekToBlock(dirEntry->copies, false);
+			ret = loadDirectory(dirEntry);
 
 			if (!ret)
 			{
-				wxLogMessage(_T("changeDirectory(): couldn't seek to directory %s"), item);
-				break;
-			}
-
-			ret = fileSystem.readDirectoryHeader(&directoryHeader);
-
-			if (!ret)
-			{
-				wxLogMessage(_T("changeDirectory: found directory %s but failed to read it's header"), item);
+				logMessage("changeDirectory: found directory %s but failed to read it", item);
 				break;
 			}
 
@@ -383,8 +366,8 @@ bool Directory::findInCurrentDirectory(const char *item, DirectoryEntry *dirEntr
 			dirTree.push_front(newEntry);
 
 			// update our current path
-			path.Append(reinterpret_cast<const wxChar *>(item));
-			path.Append(_T("/"));
+			path.append(item);
+			path.append("/");
 
 			found = true;
 			break;
@@ -396,3 +379,39 @@ bool Directory::findInCurrentDirectory(const char *item, DirectoryEntry *dirEntr
 
 	return found;
 }
+
+bool Directory::loadBlock(const int32_t blockIndex)
+{
+	block = fileSystem.readBlock(directoryBlock + blockIndex);
+
+	if (!block)
+		return false;
+
+	FileSystem::parseDirectoryHeader(block, &directoryHeader);
+
+	// 
+	// keep the entries inside the block, whatever the header says
+	// 
+	if (directoryHeader.unusedOffset > fileSystem.getBlockSize())
+		directoryHeader.unusedOffset = fileSystem.getBlockSize();
+
+	this->blockIndex = blockIndex;
+	blocksLoaded++;
+	entryOffset = directoryHeader.directoryOffset;
+
+	return true;
+}
+
+bool Directory::loadDirectory(const DirectoryEntry *dirEntry)
+{
+	directoryBlock = dirEntry->copies;
+	directoryBlocks = dirEntry->entryLengthBlocks;
+	blocksLoaded = 0;
+
+	if (!loadBlock(0))
+		return false;
+
+	endOfDir = false;
+
+	return true;
+}
@@ -3,6 +3,7 @@
 
 #include "filesystem.h"
 #include <list>
+#include <string>
 
 class Directory
 {
@@ -98,6 +99,33 @@ class Directory
 		// 
 		bool findInCurrentDirectory(const char *item, DirectoryEntry *dirEntry);
 	private:
+		// 
+		// loadBlock:
+		//     reads one block of the current directory and gets ready to
+		//     enumerate the entries in it
+		// 
+		// arguments:
+		//     1) const int32_t blockIndex (IN): the block within the 
+		//         directory, counting from 0
+		// 
+		// return value:
+		//     true on success, false otherwise
+		// 
+		bool loadBlock(const int32_t blockIndex);
+
+		// 
+		// loadDirectory:
+		//     makes the directory described by dirEntry the current one
+		//     and loads its first block
+		// 
+		// arguments:
+		//     1) const DirectoryEntry *dirEntry (IN): the directory's entry
+		// 
+		// return value:
+		//     true on success, false otherwise
+		// 
+		bool loadDirectory(const DirectoryEntry *dirEntry);
+
 		// 
 		// the file system.
 		// 
@@ -105,10 +133,27 @@ class Directory
 
 		// 
 		// this will be initialized to the directory found 
-		// after openDirectory was called.  basically the current directory
+		// after openDirectory was called.  basically the current directory.
+		// it is the header of the block being enumerated
 		// 
 		DirectoryHeader directoryHeader;
 
+		// 
+		// where the current directory is on disc, and how many blocks it has
+		// 
+		uint32_t directoryBlock;
+		uint32_t directoryBlocks;
+
+		// 
+		// the block being enumerated, which block of the directory it is,
+		// how many blocks of the directory have been loaded so far,
+		// and the offset of the next entry in it
+		// 
+		const uint8_t *block;
+		int32_t blockIndex;
+		uint32_t blocksLoaded;
+		uint32_t entryOffset;
+
 		// 
 		// the directory hierarchy.  used for searching based on relative paths
 		// 
@@ -117,7 +162,7 @@ class Directory
 		// 
 		// our current directory path
 		// 
-		wxString path;
+		std::string path;
 
 		// 
 		// used in enumerateDirectory so we know when we've seen the last
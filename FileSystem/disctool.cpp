@@ -0,0 +1,464 @@
+//
+// disctool: catalogues 3do disc images.  for each image it records the
+// checksum and game id 4DO knows the game by, then the size, crc-32 and
+// sha-1 of every file on the disc, and can extract the files as well.
+//
+// usage:
+//     disctool [-j threads] [-x directory] [-o manifest] image...
+//
+//     -j  number of worker threads (default: one per processor)
+//     -x  extract every image's files to directory/<image name>/.  when
+//         two images have the same name, the later ones get -2, -3, ...
+//     -o  write the manifest to a file instead of standard output
+//
+// images can be isos (2048 byte sectors) or raw 2352 byte bins.  the
+// manifest is tab separated, one line per image and one per file:
+//
+//     image <tab> image path <tab> checksum <tab> game id
+//     file  <tab> disc path <tab> size <tab> crc-32 <tab> sha-1
+//     error <tab> image or disc path <tab> what went wrong
+//
+// the checksum is the one GameRegistrar uses: the md5 of the first two
+// sectors.  the game id is its first 8 digits, which is what 4DO uses
+// unless the game database says otherwise.
+//
+// build:
+//     g++ -O2 -std=c++11 -pthread disctool.cpp filesystem.cpp directory.cpp hash.cpp -o disctool
+//
+
+#include "directory.h"
+#include "hash.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <list>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+	#include <direct.h>
+	#define makeDirectory(path) _mkdir(path)
+#else
+	#define makeDirectory(path) mkdir(path, 0777)
+#endif
+
+//
+// files are read and hashed this much at a time
+//
+const uint32_t chunkSize = 1024 * 1024;
+
+//
+// the sectors GameRegistrar reads to identify a game.  this must match
+// INITIAL_SECTORS_TO_READ there
+//
+const uint32_t checkSumSectors = 2;
+
+struct DiscImage
+{
+	std::string path;
+	std::string name;
+	std::string error;
+	char        checkSum[md5DigestSize * 2 + 1];
+	char        gameId[9];
+};
+
+struct DiscFile
+{
+	size_t      image;
+	std::string path;
+	uint64_t    start;
+	uint32_t    size;
+	uint32_t    crc;
+	char        sha1[sha1DigestSize * 2 + 1];
+	std::string error;
+};
+
+static std::vector<DiscImage> images;
+static std::vector<DiscFile> files;
+static std::string extractDirectory;
+
+//
+// runWorkers:
+//     calls work(0) ... work(count - 1) from the given number of
+//     threads, each index exactly once
+//
+template <typename Work>
+static void runWorkers(const size_t count, const unsigned int threads, Work work)
+{
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+
+	for (unsigned int i = 0; i < threads; i++)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			for (size_t job; (job = next++) < count; )
+				work(job);
+		}));
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+static std::string getImageName(const std::string &path)
+{
+	size_t start = path.find_last_of("/\\");
+	std::string name = path.substr(start == std::string::npos ? 0 : start + 1);
+	size_t dot = name.rfind('.');
+
+	if (dot != std::string::npos && dot > 0)
+		name.erase(dot);
+
+	return name;
+}
+
+//
+// makeUniqueName:
+//     returns name, or name with -2, -3, ... added if an earlier image
+//     already took it.  case is ignored, as it is on windows
+//
+static std::string makeUniqueName(const std::string &name, std::set<std::string> &taken)
+{
+	std::string unique = name;
+	char        suffix[16];
+
+	for (int n = 2; ; n++)
+	{
+		std::string key = unique;
+
+		for (size_t i = 0; i < key.length(); i++)
+			key[i] = (char)tolower((unsigned char)key[i]);
+
+		if (taken.insert(key).second)
+			return unique;
+
+		sprintf(suffix, "-%d", n);
+		unique = name + suffix;
+	}
+}
+
+//
+// a name from the disc is safe to use as part of a host path if it can't
+// name the directory it is in, its parent, or another directory
+//
+static bool isSafeName(const std::string &name)
+{
+	return !name.empty() && name != "." && name != ".." && name.find_first_of("/\\") == std::string::npos;
+}
+
+//
+// makes every directory leading up to the file at path
+//
+static void makeParentDirectories(const std::string &path)
+{
+	for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+		makeDirectory(path.substr(0, slash).c_str());
+}
+
+//
+// scanImage:
+//     works out the image's checksum and lists every file on it
+//
+static void scanImage(const size_t index, std::vector<DiscFile> &found)
+{
+	DiscImage       &image = images[index];
+	FileSystem      fileSystem;
+	VolumeHeader    volumeHeader;
+	uint8_t         sectors[checkSumSectors * sectorSizeCooked];
+	uint8_t         digest[md5DigestSize];
+	uint32_t        bytesRead;
+	Md5             md5;
+
+	if (!fileSystem.mount(image.path.c_str()))
+	{
+		image.error = "couldn't open the image";
+		return;
+	}
+
+	if (!fileSystem.readAt(0, sectors, sizeof(sectors), &bytesRead))
+	{
+		image.error = "the image is too small";
+		return;
+	}
+
+	md5.update(sectors, sizeof(sectors));
+	md5.finish(digest);
+	toHex(digest, md5DigestSize, image.checkSum, true);
+	memcpy(image.gameId, image.checkSum, 8);
+	image.gameId[8] = 0;
+
+	if (!fileSystem.seekToByte(0, false) || !fileSystem.readVolumeHeader(&volumeHeader))
+	{
+		image.error = "couldn't read the volume header";
+		return;
+	}
+
+	//
+	// walk the directories breadth first with a single Directory object
+	//
+	Directory              directory(image.path.c_str());
+	DirectoryEntry         entry;
+	std::list<std::string> pending;
+
+	pending.push_back("/");
+
+	while (!pending.empty())
+	{
+		std::string path = pending.front();
+		pending.pop_front();
+
+		if (!directory.openDirectory(path.c_str()) || directory.getPath() != path)
+		{
+			DiscFile missing;
+			missing.image = index;
+			missing.path = path;
+			missing.error = "couldn't open the directory";
+			found.push_back(missing);
+			continue;
+		}
+
+		while (directory.enumerateDirectory(&entry))
+		{
+			std::string name((const char *)entry.fileName, strnlen((const char *)entry.fileName, sizeof(entry.fileName)));
+
+			if (!isSafeName(name))
+			{
+				DiscFile unsafe;
+				unsafe.image = index;
+				unsafe.path = path + name;
+				unsafe.error = "the name can't be used as a path";
+				found.push_back(unsafe);
+				continue;
+			}
+
+			if ((entry.flags & DirectoryEntryTypeMask) == DirectoryEntryTypeFolder)
+			{
+				pending.push_back(path + name + "/");
+				continue;
+			}
+
+			DiscFile file;
+			file.image = index;
+			file.path = path + name;
+			file.start = (uint64_t)fileSystem.getBlockSize() * entry.copies;
+			file.size = entry.entryLengthBytes;
+			file.crc = 0;
+			file.sha1[0] = 0;
+			found.push_back(file);
+		}
+	}
+}
+
+//
+// processFile:
+//     hashes one file, and extracts it if asked to, streaming it in
+//     large chunks.  each worker keeps the last image it used mounted
+//
+static void processFile(DiscFile &file, FileSystem &fileSystem, size_t &mountedImage, uint8_t *chunk)
+{
+	DiscImage &image = images[file.image];
+	FILE      *out = NULL;
+	Crc32     crc;
+	Sha1      sha1;
+	uint8_t   digest[sha1DigestSize];
+	uint32_t  done, bytesRead;
+
+	if (!file.error.empty())
+		return;
+
+	if (mountedImage != file.image)
+	{
+		mountedImage = (size_t)-1;
+
+		if (!fileSystem.mount(image.path.c_str()))
+		{
+			file.error = "couldn't open the image";
+			return;
+		}
+
+		mountedImage = file.image;
+	}
+
+	//
+	// scanImage turned away every name that could leave the image's
+	// directory, so the disc path can be joined on as it is
+	//
+	if (!extractDirectory.empty())
+	{
+		std::string outPath = extractDirectory + "/" + image.name + file.path;
+
+		makeParentDirectories(outPath);
+		out = fopen(outPath.c_str(), "wb");
+
+		if (!out)
+		{
+			file.error = "couldn't create " + outPath;
+			return;
+		}
+	}
+
+	for (done = 0; done < file.size; done += bytesRead)
+	{
+		uint32_t length = file.size - done;
+
+		if (length > chunkSize)
+			length = chunkSize;
+
+		if (!fileSystem.readAt(file.start + done, chunk, length, &bytesRead))
+		{
+			file.error = "the file runs past the end of the image";
+			break;
+		}
+
+		crc.update(chunk, length);
+		sha1.update(chunk, length);
+
+		if (out && fwrite(chunk, 1, length, out) != length)
+		{
+			file.error = "couldn't write the extracted file";
+			break;
+		}
+	}
+
+	if (out && fclose(out) != 0 && file.error.empty())
+		file.error = "couldn't write the extracted file";
+
+	file.crc = crc.getValue();
+	sha1.finish(digest);
+	toHex(digest, sha1DigestSize, file.sha1, false);
+}
+
+static void writeManifest(FILE *manifest)
+{
+	size_t fileIndex = 0;
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const DiscImage &image = images[i];
+
+		if (!image.error.empty())
+			fprintf(manifest, "error\t%s\t%s\n", image.path.c_str(), image.error.c_str());
+		else
+			fprintf(manifest, "image\t%s\t%s\t%s\n", image.path.c_str(), image.checkSum, image.gameId);
+
+		for (; fileIndex < files.size() && files[fileIndex].image == i; fileIndex++)
+		{
+			const DiscFile &file = files[fileIndex];
+
+			if (!file.error.empty())
+				fprintf(manifest, "error\t%s\t%s\n", file.path.c_str(), file.error.c_str());
+			else
+				fprintf(manifest, "file\t%s\t%u\t%08x\t%s\n", file.path.c_str(), file.size, file.crc, file.sha1);
+		}
+	}
+}
+
+static void printUsage()
+{
+	fprintf(stderr, "usage: disctool [-j threads] [-x directory] [-o manifest] image...\n");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int          threads = std::thread::hardware_concurrency();
+	const char            *manifestPath = NULL;
+	FILE                  *manifest = stdout;
+	bool                  failed = false;
+	std::set<std::string> names;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc)
+			extractDirectory = argv[++i];
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			manifestPath = argv[++i];
+		else if (argv[i][0] == '-')
+		{
+			printUsage();
+			return 2;
+		}
+		else
+		{
+			DiscImage image;
+			image.path = argv[i];
+			image.name = makeUniqueName(getImageName(image.path), names);
+			image.checkSum[0] = 0;
+			image.gameId[0] = 0;
+			images.push_back(image);
+		}
+	}
+
+	if (images.empty())
+	{
+		printUsage();
+		return 2;
+	}
+
+	if (threads < 1)
+		threads = 1;
+
+	//
+	// first list the files on every image, then hash them all, so a
+	// single big image is spread over every thread too
+	//
+	std::vector<std::vector<DiscFile> > found(images.size());
+
+	runWorkers(images.size(), threads, [&](size_t image)
+	{
+		scanImage(image, found[image]);
+	});
+
+	for (size_t i = 0; i < found.size(); i++)
+		files.insert(files.end(), found[i].begin(), found[i].end());
+
+	//
+	// each thread handles its own slice of files, in disc order, so it
+	// reads its images sequentially and rarely has to mount another
+	//
+	unsigned int slices = threads;
+
+	runWorkers(slices, threads, [&](size_t slice)
+	{
+		FileSystem           fileSystem;
+		size_t               mountedImage = (size_t)-1;
+		std::vector<uint8_t> chunk(chunkSize);
+		size_t               first = files.size() * slice / slices;
+		size_t               last = files.size() * (slice + 1) / slices;
+
+		for (size_t i = first; i < last; i++)
+			processFile(files[i], fileSystem, mountedImage, &chunk[0]);
+	});
+
+	if (manifestPath)
+	{
+		manifest = fopen(manifestPath, "w");
+
+		if (!manifest)
+		{
+			fprintf(stderr, "disctool: couldn't create %s\n", manifestPath);
+			return 1;
+		}
+	}
+
+	writeManifest(manifest);
+
+	if (manifest != stdout)
+		fclose(manifest);
+
+	for (size_t i = 0; i < images.size(); i++)
+		failed |= !images[i].error.empty();
+	for (size_t i = 0; i < files.size(); i++)
+		failed |= !files[i].error.empty();
+
+	return failed ? 1 : 0;
+}
@@ -1,11 +1,7 @@
 #include "file.h"
-#include "wx/log.h"
 
 #include <stdio.h>
-
-#ifdef GENRE_UNIX
-	#define _strdup strdup
-#endif
+#include <string.h>
 
 File::File(const char *rom)
 {
@@ -24,9 +20,11 @@ File::File(const char *rom)
 	memset(&dirEntry, 0, sizeof(dirEntry));
 
 	// 
-	// seems like a decent thing to do. 
+	// seems like a decent thing to do.
 	// 
 	endOfFile = true;
+	currBytes = 0;
+	fileStart = 0;
 }
 
 File::~File()
@@ -37,98 +35,77 @@ File::~File()
 
 bool File::openFile(const char *path)
 {
-	bool       ret;
-	char       *fileName, *filePath, *fileNameStart;
+	bool        ret = false;
+	std::string filePath(path), fileName;
+	size_t      fileNameStart;
 	// TODO: make separator a member of the filesystem?
-	char       separator = '/';
-	Directory  dir(fileSystem.getImageName());
+	char        separator = '/';
+	Directory   dir(fileSystem.getImageName());
+
+	endOfFile = true;
 
-	filePath = _strdup(path);
+	// 
+	// find the last / in the path.  we will split the string based
+	// on this.  we will then have '/path/to/file/dir/' and 'file_name'
+	// 
+	fileNameStart = filePath.rfind(separator);
 
-	if (!filePath)
+	// 
+	// only absolute paths are taken, so a path with no / in it, or
+	// one that ends in /, has nothing to open
+	// 
+	if (filePath.empty() || filePath[0] != separator ||
+		fileNameStart + 1 == filePath.length())
 	{
-		wxLogMessage(_T("openFile(): _strdup failed to allocate memory"));
+		logMessage("openFile(): path is not absolute or has no file name");
 		return false;
 	}
 
-	for (;;)
-	{
-		//
-		// find the last / in the path.  we will split the string based
-		// on this.  we will then have '/path/to/file/dir' and 'file_name'
-		// 
-		fileNameStart = strrchr(filePath, separator);
+	// the + 1 is to move past the last /
+	fileName = filePath.substr(fileNameStart + 1);
 
-		// TODO: file in / and relative paths
-		if (!fileNameStart || !strlen(fileNameStart))
-		{
-			wxLogMessage(_T("openFile(): didn't find any /'s in the path or no filename in the path"));
-			ret = false;
-			break;
-		}
-
-		// the ++ is to move past the last /
-		fileName = _strdup(++fileNameStart);
+	// 
+	// shorten the filepath down to whatever is before the actual
+	// file name.
+	// 
+	filePath.erase(fileNameStart + 1);
 
-		if (!fileName)
-		{
-			wxLogMessage(_T("openFile(): _strdup failed to allocate memory"));
-			ret = false;
-			break;
-		}
+	// 
+	// open the directory that contains our file
+	// 
 
-		// 
-		// shorten the filepath down to whatever is before the actual
-		// file name. 
-		// 
-		*fileNameStart = 0;
+	if (!dir.openDirectory(filePath.c_str()))
+	{
+		logMessage("openFile(): openDirectory failed");
+		return false;
+	}
 
+	// 
+	// enumerate through the directory contents to find our file
+	// 
+	while (dir.enumerateDirectory(&dirEntry))
+	{
 		// 
-		// open the directory that contains our file
+		// we found the file we're looking for.  remember where it
+		// starts in the filesystem and we're ready to start reading
 		// 
-
-		ret = dir.openDirectory(filePath);
-
-		if (!ret)
+		if (strncmp((char *)dirEntry.fileName, fileName.c_str(), sizeof(dirEntry.fileName)) == 0)
 		{
-			wxLogMessage(_T("openFile(): openDirectory failed"));
-			break;
-		}
+			fileStart = (uint64_t)fileSystem.getBlockSize() * dirEntry.copies;
+			currBytes = 0;
 
-		// 
-		// enumerate through the directory contents to find our file
-		// 
-		while (dir.enumerateDirectory(&dirEntry))
-		{
 			// 
-			// we found the file we're looking for, seek to the file
-			// location in the filesystem and then we should be ready
-			// to start reading from the file
+			// we're ready to read from the file
 			// 
-			if (strcmp((char *)dirEntry.fileName, fileName) == 0)
-			{
-				ret = fileSystem.seekToBlock(dirEntry.copies, false);
-
-				if (!ret)
-				{
-					wxLogMessage(_T("openFile(): could not seek to block %08x to open file"), dirEntry.copies);
-					break;
-				}
-
-				// 
-				// we're ready to read from the file
-				// 
-				endOfFile = false;
-				break;
-			}
+			endOfFile = false;
+			ret = true;
+			break;
 		}
-
-		break;
 	}
 
-	if (filePath)
-		delete[] filePath;
-	
+	if (!ret)
+		logMessage("openFile(): couldn't find %s", fileName.c_str());
+
 	return ret;
 }
 
@@ -140,10 +117,11 @@ bool File::closeFile()
 bool File::read(uint8_t *buf, const uint32_t bufLength, uint32_t *bytesRead)
 {
 	uint32_t bytesToRead = bufLength;
+	bool     ret;
 
 	if (endOfFile)
 	{
-		wxLogMessage(_T("read(): end of file"));
+		logMessage("read(): end of file");
 		return false;
 	}
 
@@ -153,14 +131,20 @@ bool File::read(uint8_t *buf, const uint32_t bufLength, uint32_t *bytesRead)
 	if (bytesToRead > (dirEntry.entryLengthBytes - currBytes))
 		bytesToRead = (dirEntry.entryLengthBytes - currBytes);
 
-	return fileSystem.read(buf, bytesToRead, bytesRead);
+	ret = fileSystem.readAt(fileStart + currBytes, buf, bytesToRead, bytesRead);
+	currBytes += *bytesRead;
+
+	if (currBytes >= dirEntry.entryLengthBytes)
+		endOfFile = true;
+
+	return ret;
 }
 
 bool File::readLine(uint8_t *buf, const uint32_t bufLength, uint32_t *bytesRead)
 {
 	if (endOfFile)
 	{
-		wxLogMessage(_T("read(): end of file"));
+		logMessage("read(): end of file");
 		return false;
 	}
 
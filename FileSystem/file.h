@@ -16,7 +16,8 @@ class File
 		// 
 		// arguments:
 		//     1) const char *path (IN): the 3do filesystem path 
-		//         to the file to be opened
+		//         to the file to be opened.  it must be absolute,
+		//         starting with /; relative paths are not supported
 		// 
 		// return value:
 		//     true on success, false otherwise
@@ -124,6 +125,11 @@ class File
 		// currently read bytes
 		// 
 		uint32_t currBytes;
+
+		// 
+		// where the file's data starts in the image
+		// 
+		uint64_t fileStart;
 };
 
 #endif // #ifndef _FILE_H_
@@ -3,53 +3,182 @@
 // 
 
 #include "filesystem.h"
-#include "wx/log.h"
 
 #include <stdio.h>
-
-#ifdef GENRE_UNIX
-	#define _strdup strdup
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#define O_BINARY 0
 #endif
 
+// 
+// small reads through a file descriptor are served from a buffer of
+// this size, so enumerating a directory entry by entry costs one read
+// per buffer instead of one per structure.  must be a power of two
+// 
+const uint32_t readBufferSize = 64 * 1024;
+
+// 
+// raw sectors are read through a file descriptor this many at a time
+// 
+const uint32_t rawBufferSectors = 32;
+
+// 
+// the sync pattern every raw sector starts with
+// 
+static const uint8_t rawSectorSync[12] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+
 FileSystem::FileSystem()
 {
-	imageName = NULL;
+	fd = -1;
+	ownsFd = false;
+	image = NULL;
+	ownsMapping = false;
+	fileSize = 0;
+	sectorSize = sectorSizeCooked;
+	imageSize = 0;
+	position = 0;
+
+	readBuffer = NULL;
+	readBufferOffset = 0;
+	readBufferLength = 0;
+
+	blockBuffer = NULL;
+	blockBufferSize = 0;
+
+	rawBuffer = NULL;
 
 	memset(&volumeHeader, 0, sizeof(volumeHeader));
 }
 
 FileSystem::~FileSystem()
 {
-	if (imageName)
-		delete imageName;
+	unmount();
+
+	delete[] readBuffer;
+	delete[] blockBuffer;
+	delete[] rawBuffer;
 }
 
 bool FileSystem::mount(const char *path)
 {
-	bool ret;
+	int pathFd;
 
-	ret = file.Open((const wxChar *)path);
+	unmount();
 
-	if (!ret)
+	pathFd = open(path, O_RDONLY | O_BINARY);
+
+	if (pathFd < 0)
+	{
+		logMessage("FileSystem::mount(): couldn't open iso located at %s", path);
+		return false;
+	}
+
+	if (!mount(pathFd))
+	{
+		close(pathFd);
+		return false;
+	}
+
+	ownsFd = true;
+	imageName = path;
+
+#ifndef _WIN32
+	// 
+	// map the image if we can; the page cache then does all the work.
+	// without a mapping (say, no room in a 32 bit address space) we
+	// just keep reading through the descriptor
+	// 
+	if (fileSize > 0 && fileSize == (size_t)fileSize)
 	{
-		wxLogMessage(_T("FileSystem::mount(): couldn't open iso located at %s"), path);
+		void *mapping = mmap(NULL, (size_t)fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (mapping != MAP_FAILED)
+		{
+			image = (const uint8_t *)mapping;
+			ownsMapping = true;
+
+			close(fd);
+			fd = -1;
+			ownsFd = false;
+		}
+	}
+#endif
+
+	return true;
+}
+
+bool FileSystem::mount(int fd)
+{
+	unmount();
+
+#ifdef _WIN32
+	struct _stati64 info;
+	if (_fstati64(fd, &info) != 0)
+#else
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+#endif
+	{
+		logMessage("FileSystem::mount(): couldn't get the size of the image");
 		return false;
 	}
 
-	imageName = _strdup(path);
+	this->fd = fd;
+	fileSize = info.st_size;
+	detectSectorSize();
+
+	return true;
+}
+
+bool FileSystem::mount(const void *image, const uint64_t imageSize)
+{
+	unmount();
 
-	if (!imageName)
+	if (!image)
 	{
-		wxLogMessage(_T("FileSystem::mount(): could not allocate memory for a copy of the image name"));
+		logMessage("FileSystem::mount(): no image given");
 		return false;
 	}
 
+	this->image = (const uint8_t *)image;
+	fileSize = imageSize;
+	detectSectorSize();
+
 	return true;
 }
 
 void FileSystem::unmount()
 {
-	file.Close();
+#ifndef _WIN32
+	if (ownsMapping)
+		munmap((void *)image, (size_t)fileSize);
+#endif
+
+	if (ownsFd)
+		close(fd);
+
+	fd = -1;
+	ownsFd = false;
+	image = NULL;
+	ownsMapping = false;
+	fileSize = 0;
+	sectorSize = sectorSizeCooked;
+	imageSize = 0;
+	position = 0;
+	readBufferLength = 0;
+	imageName.clear();
+
+	memset(&volumeHeader, 0, sizeof(volumeHeader));
 }
 
 bool FileSystem::readVolumeHeader(VolumeHeader *vh)
@@ -61,29 +190,22 @@ bool FileSystem::readVolumeHeader(VolumeHeader *vh)
 
 	if (!ret)
 	{
-		wxLogMessage(_T("FileSystem::readVolumeHeader: couldn't read volume header"));
+		logMessage("FileSystem::readVolumeHeader: couldn't read volume header");
 		return false;
 	}
 
 	// 
-	// make all relevant fields little endian
+	// make all relevant fields little endian.  everything from the id
+	// to the end of the root directory copies is a 32 bit word
 	// 
 
-	endianSwap(vh->id);
-	endianSwap(vh->blockSize);
-	endianSwap(vh->blockCount);
-	endianSwap(vh->rootDirId);
-	endianSwap(vh->rootDirBlocks);
-	endianSwap(vh->rootDirBlockSize);
-	endianSwap(vh->lastRootDirCopy);
-	for (int i = 0; i < 8; i++)
-		endianSwap(vh->rootDirCopies[i]);
-	
+	endianSwap(&vh->id, 7 + 8);
+
 	// 
 	// keep a local copy for ourselves
 	// 
 	memcpy(&volumeHeader, vh, sizeof(VolumeHeader));
-	
+
 	// 
 	// go ahead and move the fp forward to the root dir location
 	// 
@@ -98,98 +220,337 @@ bool FileSystem::readVolumeHeader(VolumeHeader *vh)
 
 bool FileSystem::readDirectoryHeader(DirectoryHeader *dh)
 {
+	uint8_t  buf[directoryHeaderSize];
 	uint32_t bytesRead;
 	bool     ret;
 
-	ret = read(dh, directoryHeaderSize, &bytesRead);
+	ret = read(buf, directoryHeaderSize, &bytesRead);
 
 	if (!ret)
 	{
-		wxLogMessage(_T("FileSystem::readDirectoryHeader(): couldn't read directory header"));
+		logMessage("FileSystem::readDirectoryHeader(): couldn't read directory header");
 		return false;
 	}
 
+	parseDirectoryHeader(buf, dh);
+
+	return true;
+}
+
+bool FileSystem::readDirectoryEntry(DirectoryEntry *de)
+{
+	uint8_t  buf[directoryEntrySize];
+	uint32_t bytesRead;
+	bool     ret;
+
+	ret = read(buf, directoryEntrySize, &bytesRead);
+
+	if (!ret)
+	{
+		logMessage("FileSystem::readDirectoryEntry(): couldn't read directory entry");
+		return false;
+	}
+
+	parseDirectoryEntry(buf, directoryEntrySize, de);
+
+	// 
+	// we may need to move the file pointer a little further along.
+	// this is due to the fact that the copies field is actually of
+	// variable length, but we always only read in 4 bytes of it
+	// because we don't really need more than one copy of anything.
+	// 
+
+	if (de->lastCopy)
+	{
+		ret = seekToByte(de->lastCopy * 4, true);
+
+		if (!ret)
+			return false;
+	}
+
+	return true;
+}
+
+void FileSystem::parseDirectoryHeader(const uint8_t *src, DirectoryHeader *dh)
+{
+	memcpy(dh, src, directoryHeaderSize);
+
 	// 
 	// make all relevant fields little endian
 	// 
 
-	endianSwap(dh->nextBlock);
-	endianSwap(dh->prevBlock);
-	endianSwap(dh->flags);
-	endianSwap(dh->unusedOffset);
-	endianSwap(dh->directoryOffset);
+	endianSwap((uint32_t *)dh, directoryHeaderSize / 4);
+}
+
+uint32_t FileSystem::parseDirectoryEntry(const uint8_t *src, const uint32_t available, DirectoryEntry *de)
+{
+	uint32_t length;
+
+	if (available < directoryEntrySize)
+		return 0;
+
+	memcpy(de, src, directoryEntrySize);
+
+	// 
+	// make all relevant fields little endian: flags and id, blockSize
+	// through gap, then lastCopy and the first copy
+	// 
+
+	endianSwap(&de->flags, 2);
+	endianSwap(&de->blockSize, 5);
+	endianSwap(&de->lastCopy, 2);
+
+	// 
+	// the copies run on for lastCopy more words
+	// 
+	if (de->lastCopy > (available - directoryEntrySize) / 4)
+		return 0;
+
+	length = directoryEntrySize + de->lastCopy * 4;
+
+	return length;
+}
+
+bool FileSystem::read(void *buf, const uint32_t bufLength, uint32_t *bytesRead)
+{
+	bool ret;
+
+	if (!bufLength)
+	{
+		logMessage("FileSystem::read(): bufLength size of %d is invalid", bufLength);
+		return false;
+	}
+
+	ret = readAt(position, buf, bufLength, bytesRead);
+	position += *bytesRead;
+
+	if (!ret)
+	{
+		logMessage("FileSystem::read(): failed to read %d bytes from filesystem", bufLength);
+		return false;
+	}
 
 	return true;
 }
 
-bool FileSystem::readDirectoryEntry(DirectoryEntry *de)
+bool FileSystem::readAt(const uint64_t offset, void *buf, const uint32_t bufLength, uint32_t *bytesRead)
 {
-		uint32_t bytesRead;
-		bool     ret;
+	uint8_t  *dest = (uint8_t *)buf;
+	uint64_t current = offset;
+	uint32_t remaining = bufLength;
 
-		ret = read(de, directoryEntrySize, &bytesRead);
+	*bytesRead = 0;
 
-		if (!ret)
-		{
-			wxLogMessage(_T("FileSystem::readDirectoryEntry(): couldn't read directory entry"));
+	// 
+	// nothing to gain from buffering a mapping or a big read
+	// 
+	if (image || bufLength >= readBufferSize)
+	{
+		if (!readImage(offset, buf, bufLength, bytesRead))
 			return false;
-		}
 
-		// 
-		// make all relevant fields little endian
-		//
-
-		endianSwap(de->flags);
-		endianSwap(de->id);
-		endianSwap(de->blockSize);
-		endianSwap(de->entryLengthBytes);
-		endianSwap(de->entryLengthBlocks);
-		endianSwap(de->burst);
-		endianSwap(de->gap);
-		endianSwap(de->lastCopy);
-		endianSwap(de->copies);
+		return *bytesRead == bufLength;
+	}
 
-		// 
-		// we may need to move the file pointer a little further along.
-		// this is due to the fact that the copies field is actually of 
-		// variable length, but we always only read in 4 bytes of it
-		// because we don't really need more than one copy of anything.
-		// 
+	if (!readBuffer)
+		readBuffer = new uint8_t[readBufferSize];
+
+	while (remaining)
+	{
+		uint32_t copyLength;
 
-		if (de->lastCopy)
+		if (current < readBufferOffset || current >= readBufferOffset + readBufferLength)
 		{
-			int32_t pos = de->lastCopy * 4;
+			readBufferOffset = current & ~(uint64_t)(readBufferSize - 1);
+			readBufferLength = 0;
 
-			ret = seekToByte(pos, true);
+			if (!readImage(readBufferOffset, readBuffer, readBufferSize, &readBufferLength))
+				return false;
 
-			if (!ret)
+			// past the end of the image
+			if (current >= readBufferOffset + readBufferLength)
 				return false;
 		}
 
-		return true;
+		copyLength = (uint32_t)(readBufferOffset + readBufferLength - current);
+		if (copyLength > remaining)
+			copyLength = remaining;
+
+		memcpy(dest, readBuffer + (current - readBufferOffset), copyLength);
+
+		dest += copyLength;
+		current += copyLength;
+		remaining -= copyLength;
+		*bytesRead += copyLength;
+	}
+
+	return true;
 }
 
-bool FileSystem::read(void *buf, const uint32_t bufLength, uint32_t *bytesRead)
+bool FileSystem::readImage(const uint64_t offset, void *buf, const uint32_t bufLength, uint32_t *bytesRead)
 {
-	size_t ret;
+	uint8_t  *dest = (uint8_t *)buf;
+	uint32_t length = bufLength;
 
-	if (!bufLength)
+	*bytesRead = 0;
+
+	if (offset >= imageSize)
+		return true;
+
+	if (length > imageSize - offset)
+		length = (uint32_t)(imageSize - offset);
+
+	if (sectorSize == sectorSizeCooked)
 	{
-		wxLogMessage(_T("FileSystem::read(): bufLength size of %d is invalid"), bufLength);
-		return false;
+		if (!readFile(offset, buf, length))
+			return false;
+
+		*bytesRead = length;
+		return true;
+	}
+
+	// 
+	// raw sectors: gather the user data of each one, reading runs of
+	// whole sectors at a time when there is no mapping
+	// 
+	while (*bytesRead < length)
+	{
+		uint64_t current = offset + *bytesRead;
+		uint64_t sector = current / sectorSizeCooked;
+		uint32_t within = (uint32_t)(current % sectorSizeCooked);
+		uint32_t sectors = (within + (length - *bytesRead) + sectorSizeCooked - 1) / sectorSizeCooked;
+		const uint8_t *raw;
+
+		if (image)
+		{
+			raw = image + sector * sectorSizeRaw;
+		}
+		else
+		{
+			if (sectors > rawBufferSectors)
+				sectors = rawBufferSectors;
+
+			if (!rawBuffer)
+				rawBuffer = new uint8_t[rawBufferSectors * sectorSizeRaw];
+
+			if (!readFile(sector * sectorSizeRaw, rawBuffer, sectors * sectorSizeRaw))
+				return false;
+
+			raw = rawBuffer;
+		}
+
+		for (uint32_t i = 0; i < sectors && *bytesRead < length; i++)
+		{
+			uint32_t copyLength = sectorSizeCooked - within;
+
+			if (copyLength > length - *bytesRead)
+				copyLength = length - *bytesRead;
+
+			memcpy(dest + *bytesRead, raw + i * sectorSizeRaw + sectorDataOffsetRaw + within, copyLength);
+
+			*bytesRead += copyLength;
+			within = 0;
+		}
 	}
 
-	ret = file.Read(buf, bufLength);
+	return true;
+}
+
+bool FileSystem::readFile(const uint64_t offset, void *buf, const uint32_t bufLength)
+{
+	uint32_t bytesRead = 0;
+
+	if (offset > fileSize || bufLength > fileSize - offset)
+		return false;
 
-	if (ret == wxInvalidOffset)
+	if (image)
 	{
-		wxLogMessage(_T("FileSystem::read(): failed to read from filesystem: %d"), ret);
+		memcpy(buf, image + offset, bufLength);
+		return true;
+	}
+
+	if (fd < 0)
 		return false;
+
+#ifdef _WIN32
+	if (_lseeki64(fd, offset, SEEK_SET) != (__int64)offset)
+		return false;
+#endif
+
+	while (bytesRead < bufLength)
+	{
+#ifdef _WIN32
+		int ret = _read(fd, (uint8_t *)buf + bytesRead, bufLength - bytesRead);
+#else
+		ssize_t ret = pread(fd, (uint8_t *)buf + bytesRead, bufLength - bytesRead, (off_t)(offset + bytesRead));
+#endif
+
+		if (ret <= 0)
+			return false;
+
+		bytesRead += (uint32_t)ret;
 	}
 
 	return true;
 }
 
+void FileSystem::detectSectorSize()
+{
+	uint8_t sync[sizeof(rawSectorSync)];
+
+	sectorSize = sectorSizeCooked;
+
+	if (fileSize >= sectorSizeRaw
+		&& readFile(0, sync, sizeof(sync))
+		&& memcmp(sync, rawSectorSync, sizeof(sync)) == 0)
+		sectorSize = sectorSizeRaw;
+
+	// 
+	// only whole raw sectors hold user data
+	// 
+	if (sectorSize == sectorSizeRaw)
+		imageSize = fileSize / sectorSizeRaw * sectorSizeCooked;
+	else
+		imageSize = fileSize;
+}
+
+const uint8_t *FileSystem::readBlock(const uint32_t block)
+{
+	uint32_t blockSize = getBlockSize();
+	uint64_t offset = (uint64_t)blockSize * block;
+	uint32_t bytesRead;
+
+	if (!blockSize)
+	{
+		logMessage("FileSystem::readBlock(): no volume header has been read");
+		return NULL;
+	}
+
+	if (offset >= imageSize || imageSize - offset < blockSize)
+	{
+		logMessage("FileSystem::readBlock(): block %d is past the end of the image", block);
+		return NULL;
+	}
+
+	if (image && sectorSize == sectorSizeCooked)
+		return image + offset;
+
+	if (blockBufferSize < blockSize)
+	{
+		delete[] blockBuffer;
+		blockBuffer = new uint8_t[blockSize];
+		blockBufferSize = blockSize;
+	}
+
+	if (!readImage(offset, blockBuffer, blockSize, &bytesRead) || bytesRead != blockSize)
+	{
+		logMessage("FileSystem::readBlock(): couldn't read block %d", block);
+		return NULL;
+	}
+
+	return blockBuffer;
+}
+
 bool FileSystem::seekToBlock(const uint32_t block, const bool relative)
 {
 	bool ret;
@@ -199,9 +560,7 @@ bool FileSystem::seekToBlock(const uint32_t block, const bool relative)
 
 	if (!ret)
 	{
-		wxLogMessage(
-			_T("FileSystem::seekToBlock(): couldn't set file pointer position of %d"), 
-			pos);
+		logMessage("FileSystem::seekToBlock(): couldn't set file pointer position of %d", pos);
 		return false;
 	}
 
@@ -210,23 +569,16 @@ bool FileSystem::seekToBlock(const uint32_t block, const bool relative)
 
 bool FileSystem::seekToByte(const uint32_t byte, const bool relative)
 {
-	wxFileOffset ret, pos = byte;
-	
-	wxLogDebug(
-		"FileSystem::seekToByte(): setting fp to position %d, relative = %d", 
-		pos, 
-		(relative ? 1 : 0));
+	uint64_t pos = relative ? position + byte : byte;
 
-	ret = file.Seek(pos, (relative ? wxFromCurrent : wxFromStart));
-
-	if (ret == wxInvalidOffset)
+	if (pos > imageSize)
 	{
-		wxLogMessage(
-			_T("FileSystem::seekToBlock(): couldn't set file pointer position of %d"), 
-			pos);
+		logMessage("FileSystem::seekToByte(): couldn't set file pointer position of %d", (uint32_t)pos);
 		return false;
 	}
 
+	position = pos;
+
 	return true;
 }
 
@@ -238,72 +590,70 @@ uint32_t FileSystem::getBlockSize()
 
 const char *FileSystem::getImageName()
 {
-	return imageName;
+	return imageName.empty() ? NULL : imageName.c_str();
+}
+
+uint64_t FileSystem::getImageSize()
+{
+	return imageSize;
+}
+
+uint32_t FileSystem::getSectorSize()
+{
+	return sectorSize;
 }
 
 void FileSystem::printVolumeHeader(const VolumeHeader *vh)
 {
-	wxLogMessage(_T("recordType       = %02x"), vh->recordType);
-	wxLogMessage(_T("syncBytes        = "));
+	printf("recordType       = %02x\n", vh->recordType);
+	printf("syncBytes        = ");
 	for (int i = 0; i < 5; i++)
-		wxLogMessage(_T("%02x"), vh->syncBytes[i]);
-	wxLogMessage(_T(""));
-	wxLogMessage(_T("recordVersion    = %02x"), vh->recordVersion);
-	wxLogMessage(_T("volumeFlags      = %02x"), vh->flags);
-	wxLogMessage(_T("volumeComment    = "));
-	for (int i = 0; i < 32; i++)
-		wxLogMessage(_T("%c"), vh->comment[i]);
-	wxLogMessage(_T(""));
-	wxLogMessage(_T("volumeLabel      = "));
-	for (int i = 0; i < 32; i++)
-		wxLogMessage(_T("%c"), vh->label[i]);
-	wxLogMessage(_T(""));
-	wxLogMessage(_T("volumeId         = %08x"), vh->id);
-	wxLogMessage(_T("blockSize        = %08x (%d bytes)"), vh->blockSize, vh->blockSize);
-	wxLogMessage(_T("blockCount       = %08x (%d KB in volume)"), vh->blockCount, (vh->blockCount * vh->blockSize) / 1024);
-	wxLogMessage(_T("rootDirId        = %08x"), vh->rootDirId);
-	wxLogMessage(_T("rootDirBlocks    = %08x (%d blocks)"), vh->rootDirBlocks, vh->rootDirBlocks);
-	wxLogMessage(_T("rootDirBlockSize = %08x (%d bytes)"), vh->rootDirBlockSize, vh->rootDirBlockSize);
-	wxLogMessage(_T("lastRootDirCopy  = %08x"), vh->lastRootDirCopy);
-	wxLogMessage(_T("rootDirCopies    = "));
+		printf("%02x", vh->syncBytes[i]);
+	printf("\n");
+	printf("recordVersion    = %02x\n", vh->recordVersion);
+	printf("volumeFlags      = %02x\n", vh->flags);
+	printf("volumeComment    = %.32s\n", (const char *)vh->comment);
+	printf("volumeLabel      = %.32s\n", (const char *)vh->label);
+	printf("volumeId         = %08x\n", vh->id);
+	printf("blockSize        = %08x (%d bytes)\n", vh->blockSize, vh->blockSize);
+	printf("blockCount       = %08x (%d KB in volume)\n", vh->blockCount, (vh->blockCount * vh->blockSize) / 1024);
+	printf("rootDirId        = %08x\n", vh->rootDirId);
+	printf("rootDirBlocks    = %08x (%d blocks)\n", vh->rootDirBlocks, vh->rootDirBlocks);
+	printf("rootDirBlockSize = %08x (%d bytes)\n", vh->rootDirBlockSize, vh->rootDirBlockSize);
+	printf("lastRootDirCopy  = %08x\n", vh->lastRootDirCopy);
+	printf("rootDirCopies    = ");
 	for (int i = 0; i < 8; i++)
 	{
-		wxLogMessage(_T("%08x"), vh->rootDirCopies[i]);
+		printf("%08x", vh->rootDirCopies[i]);
 
 		if (i + 1 < 8)
-			wxLogMessage(_T(" "));
+			printf(" ");
 	}
-	wxLogMessage(_T(""));
+	printf("\n");
 }
 
 void FileSystem::printDirectoryHeader(const DirectoryHeader *dh)
 {
-	wxLogMessage(_T("nextBlock       = %08x"), dh->nextBlock);
-	wxLogMessage(_T("prevBlock       = %08x"), dh->prevBlock);
-	wxLogMessage(_T("flags           = %08x"), dh->flags);
-	wxLogMessage(_T("unusedOffset    = %08x"), dh->unusedOffset);
-	wxLogMessage(_T("directoryOffset = %08x"), dh->directoryOffset);
+	printf("nextBlock       = %08x\n", dh->nextBlock);
+	printf("prevBlock       = %08x\n", dh->prevBlock);
+	printf("flags           = %08x\n", dh->flags);
+	printf("unusedOffset    = %08x\n", dh->unusedOffset);
+	printf("directoryOffset = %08x\n", dh->directoryOffset);
 }
 
 void FileSystem::printDirectoryEntry(const DirectoryEntry *de)
 {
-	wxLogMessage(_T("flags             = %08x"), de->flags);
-	wxLogMessage(_T("id                = %08x"), de->id);
-	wxLogMessage(_T("ext               = "));
-	for (int i = 0; i < 4; i++)
-		wxLogMessage(_T("%c"), de->ext[i]);
-	wxLogMessage(_T(""));
-	wxLogMessage(_T("blockSize         = %08x"), de->blockSize);
-	wxLogMessage(_T("entryLengthBytes  = %08x"), de->entryLengthBytes);
-	wxLogMessage(_T("entryLengthBlocks = %08x"), de->entryLengthBlocks);
-	wxLogMessage(_T("burst             = %08x"), de->burst);
-	wxLogMessage(_T("gap               = %08x"), de->gap);
-	wxLogMessage(_T("fileName          = "));
-	for (int i = 0; i < 32; i++)
-		wxLogMessage(_T("%c"), de->fileName[i]);
-	wxLogMessage(_T(""));
-	wxLogMessage(_T("lastCopy          = %08x"), de->lastCopy);
-	wxLogMessage(_T("copies            = %08x"), de->copies);
+	printf("flags             = %08x\n", de->flags);
+	printf("id                = %08x\n", de->id);
+	printf("ext               = %.4s\n", (const char *)de->ext);
+	printf("blockSize         = %08x\n", de->blockSize);
+	printf("entryLengthBytes  = %08x\n", de->entryLengthBytes);
+	printf("entryLengthBlocks = %08x\n", de->entryLengthBlocks);
+	printf("burst             = %08x\n", de->burst);
+	printf("gap               = %08x\n", de->gap);
+	printf("fileName          = %.32s\n", (const char *)de->fileName);
+	printf("lastCopy          = %08x\n", de->lastCopy);
+	printf("copies            = %08x\n", de->copies);
 }
 
 void FileSystem::printString(const char *str)
@@ -313,7 +663,7 @@ void FileSystem::printString(const char *str)
 
 void FileSystem::printString(const uint8_t *str, const uint32_t strLength)
 {
-	for (int i = 0; i < strLength; i++)
+	for (uint32_t i = 0; i < strLength; i++)
 	{
 		// 
 		// files in the opera filesystem don't have line feeds, just
@@ -321,17 +671,18 @@ void FileSystem::printString(const uint8_t *str, const uint32_t strLength)
 		// a line feed before every carriage return
 		// 
 		if (str[i] == 0x0D)
-			wxLogMessage(_T(""));
+			putchar('\n');
 
-		wxLogMessage(_T("%c"), str[i]);
+		putchar(str[i]);
 	}
 
-	wxLogMessage(_T(""));
+	putchar('\n');
 }
 
-void FileSystem::endianSwap(uint16_t &x)
+void FileSystem::endianSwap(uint32_t *words, const uint32_t count)
 {
-	x = (x >> 8) | (x << 8);
+	for (uint32_t i = 0; i < count; i++)
+		endianSwap(words[i]);
 }
 
 void FileSystem::endianSwap(uint32_t &x)
@@ -342,10 +693,13 @@ void FileSystem::endianSwap(uint32_t &x)
 	    (x << 24);
 }
 
-void FileSystem::endianSwap(int32_t &x)
+void logMessage(const char *format, ...)
 {
-	x = (x >> 24) | 
-	    ((x >> 8) & 0x0000FF00) | 
-	    ((x << 8) & 0x00FF0000) | 
-	    (x << 24);
+	va_list args;
+
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+
+	fputc('\n', stderr);
 }
@@ -1,22 +1,28 @@
 // 
 // TODO: put this in a namespace?
-// TODO: throw the current directory in a member so we can 
-//       know the block size we're dealing with.  this also
-//       makes reading directories easier, as we can read them
-//       a block at a time since we know the block size
+// 
+// the filesystem only needs the c runtime.  an image is read either
+// through a file descriptor or straight out of memory (a mapping of
+// the image file, or an image the caller already has in memory).
+// small reads are served from a read-ahead buffer, and whole blocks
+// can be fetched with a single read so directories can be parsed
+// from memory.
 // 
 
 #ifndef _FILESYSTEM_H_
 #define _FILESYSTEM_H_
 
-#include "wx/file.h"
+#include <string>
 
-#ifndef GENRE_UNIX
-typedef unsigned char  uint8_t;
-typedef unsigned short uint16_t;
-typedef unsigned int   uint32_t;
-typedef __int32        int32_t;
-#endif
+#if defined(_MSC_VER) && _MSC_VER < 1600
+typedef unsigned char    uint8_t;
+typedef unsigned short   uint16_t;
+typedef unsigned int     uint32_t;
+typedef __int32          int32_t;
+typedef unsigned __int64 uint64_t;
+#else
+#include <stdint.h>
+#endif
 
 // 
 // filesystem object sizes
@@ -25,6 +31,15 @@ const uint8_t volumeHeaderSize    = 132;
 const uint8_t directoryHeaderSize = 20;
 const uint8_t directoryEntrySize  = 72;
 
+// 
+// sector layouts.  an iso holds just the 2048 bytes of user data of each
+// sector; a raw (bin) image holds whole 2352 byte MODE1 sectors, with the
+// user data after a 16 byte sync pattern and header
+// 
+const uint32_t sectorSizeCooked    = 2048;
+const uint32_t sectorSizeRaw       = 2352;
+const uint32_t sectorDataOffsetRaw = 16;
+
 // 
 // directory header constants
 // 
@@ -99,9 +114,11 @@ class FileSystem
 
 		// 
 		// mount: 
-		//     will open a handle to the file at path, read the 
-		//     volume header, and position the file handle at the 
-		//     root directory
+		//     will open the file at path and position the read pointer
+		//     at the beginning of the image.  where the platform allows,
+		//     the whole image is mapped into memory and read from there.
+		//     every mount recognizes raw images by their sync pattern, and
+		//     from then on only their user data is seen
 		// 
 		// arguments:
 		//     1) const char *path (IN): the filesystem path where a 3do iso resides
@@ -111,9 +128,36 @@ class FileSystem
 		// 
 		bool mount(const char *path);
 
+		// 
+		// mount: 
+		//     reads the image through a file descriptor that is already
+		//     open.  the descriptor is not closed by unmount
+		// 
+		// arguments:
+		//     1) int fd (IN): an open, readable file descriptor
+		// 
+		// return value:
+		//     true on success, false otherwise
+		// 
+		bool mount(int fd);
+
+		// 
+		// mount: 
+		//     reads the image from memory, such as a mapping the caller
+		//     made.  the memory must stay valid until unmount
+		// 
+		// arguments:
+		//     1) const void *image (IN): the first byte of the image
+		//     2) const uint64_t imageSize (IN): the size of the image in bytes
+		// 
+		// return value:
+		//     true on success, false otherwise
+		// 
+		bool mount(const void *image, const uint64_t imageSize);
+
 		// 
 		// unmount:
-		//     closes the file handle to the 3do iso opened with mount
+		//     closes the file handle or mapping of the 3do iso opened with mount
 		// 
 		// arguments:
 		//     none
@@ -186,10 +230,72 @@ class FileSystem
 		//     3) uint32_t *bytesRead (OUT): the number of bytes actually read
 		// 
 		// return value:
-		//     true on success, false otherwise
+		//     true on success, false on an error or when the image ends 
+		//     before bufLength bytes could be read
 		// 
 		bool read(void *buf, const uint32_t bufLength, uint32_t *bytesRead);
 
+		// 
+		// readAt:
+		//     reads bytes from anywhere in the image without moving the 
+		//     current position.  large reads go straight to the file (or
+		//     the mapping) instead of through the read-ahead buffer
+		// 
+		// arguments:
+		//     1) const uint64_t offset (IN): the byte in the image to start at
+		//     2) void *buf (OUT): will be filled with the bytes read
+		//     3) const uint32_t bufLength (IN): the number of bytes to read
+		//     4) uint32_t *bytesRead (OUT): the number of bytes actually read
+		// 
+		// return value:
+		//     true on success, false on an error or when the image ends 
+		//     before bufLength bytes could be read
+		// 
+		bool readAt(const uint64_t offset, void *buf, const uint32_t bufLength, uint32_t *bytesRead);
+
+		// 
+		// readBlock:
+		//     reads one whole block of the volume, in a single read
+		// 
+		// arguments:
+		//     1) const uint32_t block (IN): the block to read
+		// 
+		// return value:
+		//     the block's bytes, as they are on disc, or NULL on failure.
+		//     they stay valid until the next call to readBlock or unmount
+		// 
+		const uint8_t *readBlock(const uint32_t block);
+
+		// 
+		// parseDirectoryHeader:
+		//     decodes a directory header from the bytes of a block, such
+		//     as those returned by readBlock
+		// 
+		// arguments:
+		//     1) const uint8_t *src (IN): the first byte of the header
+		//     2) DirectoryHeader *dh (OUT): the decoded header
+		// 
+		// return value:
+		//     none
+		// 
+		static void parseDirectoryHeader(const uint8_t *src, DirectoryHeader *dh);
+
+		// 
+		// parseDirectoryEntry:
+		//     decodes a directory entry from the bytes of a block
+		// 
+		// arguments:
+		//     1) const uint8_t *src (IN): the first byte of the entry
+		//     2) const uint32_t available (IN): the number of bytes left in the 
+		//         block from src on
+		//     3) DirectoryEntry *de (OUT): the decoded entry
+		// 
+		// return value:
+		//     the number of bytes the entry takes up, including all of its
+		//     copies, or 0 if it does not fit in the bytes available
+		// 
+		static uint32_t parseDirectoryEntry(const uint8_t *src, const uint32_t available, DirectoryEntry *de);
+
 		// 
 		// seekToBlock: 
 		//    seeks the current read position to the block specified
@@ -245,6 +351,30 @@ class FileSystem
 		// 
 		const char *getImageName();
 
+		// 
+		// getImageSize:
+		//     gets the size of the currently mounted image
+		// 
+		// arguments:
+		//     none
+		// 
+		// return value:
+		//     the size of the image in bytes, or 0 if nothing is mounted
+		// 
+		uint64_t getImageSize();
+
+		// 
+		// getSectorSize:
+		//     gets the size of the sectors stored in the image
+		// 
+		// arguments:
+		//     none
+		// 
+		// return value:
+		//     sectorSizeCooked or sectorSizeRaw
+		// 
+		uint32_t getSectorSize();
+
 		// 
 		// logging operations
 		// 
@@ -258,27 +388,82 @@ class FileSystem
 
 	private:
 		// 
-		// endian swappers
+		// endian swappers.  the structures are all made of 32 bit words 
+		// apart from the name fields, so they are swapped a run of words
+		// at a time
 		// 
 
-		void endianSwap(uint16_t &x);
-		void endianSwap(uint32_t &x);
-		void endianSwap(int32_t &x);
+		static void endianSwap(uint32_t *words, const uint32_t count);
+		static void endianSwap(uint32_t &x);
 
-		// file handle to the iso/rom we're mounting
-		wxFile file;
+		// 
+		// reads user data from the file or the mapping, without any buffering
+		// 
+		bool readImage(const uint64_t offset, void *buf, const uint32_t bufLength, uint32_t *bytesRead);
 
-		VolumeHeader volumeHeader;
+		// 
+		// reads bytes of the file itself, whatever its sector layout
+		// 
+		bool readFile(const uint64_t offset, void *buf, const uint32_t bufLength);
 
 		// 
-		// the block size of the volume
+		// sets up the sector layout once an image is mounted
 		// 
-		uint32_t blockSize;
+		void detectSectorSize();
+
+		// file descriptor of the iso/rom we're mounting, -1 if reading from memory
+		int fd;
+		bool ownsFd;
+
+		// 
+		// the image in memory, if it is read from there.  ownsMapping is 
+		// set when we mapped it ourselves and have to unmap it
+		// 
+		const uint8_t *image;
+		bool ownsMapping;
+		uint64_t fileSize;
+
+		// 
+		// the sector layout, and the size of the user data in the image
+		// 
+		uint32_t sectorSize;
+		uint64_t imageSize;
+
+		// 
+		// the current read position
+		// 
+		uint64_t position;
+
+		// 
+		// read-ahead for small reads through a file descriptor
+		// 
+		uint8_t *readBuffer;
+		uint64_t readBufferOffset;
+		uint32_t readBufferLength;
+
+		// 
+		// the last block read with readBlock, when it is not mapped
+		// 
+		uint8_t *blockBuffer;
+		uint32_t blockBufferSize;
+
+		// 
+		// whole raw sectors read through a file descriptor
+		// 
+		uint8_t *rawBuffer;
+
+		VolumeHeader volumeHeader;
 
 		// 
 		// the path on disk to the image we loaded the filesystem from
 		// 
-		const char *imageName;
+		std::string imageName;
 };
 
+// 
+// logMessage:
+//     printf-style logging of filesystem problems to stderr
+// 
+void logMessage(const char *format, ...);
+
 #endif // #ifndef _FILESYSTEM_H_
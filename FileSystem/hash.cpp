@@ -0,0 +1,332 @@
+#include "hash.h"
+
+#include <string.h>
+
+//
+// built before main runs, so threads can share it
+//
+static struct CrcTable
+{
+	uint32_t entries[256];
+
+	CrcTable()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+
+			entries[i] = c;
+		}
+	}
+} crcTable;
+
+static uint32_t rotateLeft(const uint32_t x, const int bits)
+{
+	return (x << bits) | (x >> (32 - bits));
+}
+
+//
+// crc-32
+//
+
+Crc32::Crc32()
+{
+	crc = 0xFFFFFFFF;
+}
+
+void Crc32::update(const void *data, const uint32_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint32_t c = crc;
+
+	for (uint32_t i = 0; i < length; i++)
+		c = crcTable.entries[(c ^ bytes[i]) & 0xFF] ^ (c >> 8);
+
+	crc = c;
+}
+
+uint32_t Crc32::getValue()
+{
+	return crc ^ 0xFFFFFFFF;
+}
+
+//
+// sha-1
+//
+
+Sha1::Sha1()
+{
+	state[0] = 0x67452301;
+	state[1] = 0xEFCDAB89;
+	state[2] = 0x98BADCFE;
+	state[3] = 0x10325476;
+	state[4] = 0xC3D2E1F0;
+
+	length = 0;
+	bufferLength = 0;
+}
+
+void Sha1::update(const void *data, const uint32_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint32_t remaining = length;
+
+	this->length += length;
+
+	if (bufferLength)
+	{
+		uint32_t copyLength = 64 - bufferLength;
+
+		if (copyLength > remaining)
+			copyLength = remaining;
+
+		memcpy(buffer + bufferLength, bytes, copyLength);
+		bufferLength += copyLength;
+		bytes += copyLength;
+		remaining -= copyLength;
+
+		if (bufferLength < 64)
+			return;
+
+		processBlock(buffer);
+		bufferLength = 0;
+	}
+
+	for (; remaining >= 64; remaining -= 64, bytes += 64)
+		processBlock(bytes);
+
+	memcpy(buffer, bytes, remaining);
+	bufferLength = remaining;
+}
+
+void Sha1::finish(uint8_t *digest)
+{
+	uint64_t bits = length * 8;
+	uint8_t  padding[72];
+	uint32_t paddingLength = ((bufferLength < 56) ? 56 : 120) - bufferLength;
+
+	memset(padding, 0, sizeof(padding));
+	padding[0] = 0x80;
+
+	for (int i = 0; i < 8; i++)
+		padding[paddingLength + i] = (uint8_t)(bits >> (56 - i * 8));
+
+	update(padding, paddingLength + 8);
+
+	for (int i = 0; i < 20; i++)
+		digest[i] = (uint8_t)(state[i / 4] >> (24 - (i % 4) * 8));
+}
+
+void Sha1::processBlock(const uint8_t *block)
+{
+	uint32_t w[80];
+	uint32_t a, b, c, d, e;
+
+	for (int i = 0; i < 16; i++)
+		w[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+
+	for (int i = 16; i < 80; i++)
+		w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+
+	for (int i = 0; i < 80; i++)
+	{
+		uint32_t f, k, temp;
+
+		if (i < 20)
+		{
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		}
+		else if (i < 40)
+		{
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		}
+		else if (i < 60)
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+
+		temp = rotateLeft(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = rotateLeft(b, 30);
+		b = a;
+		a = temp;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+//
+// md5
+//
+
+static const uint32_t md5Constants[64] =
+{
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const int md5Shifts[64] =
+{
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+Md5::Md5()
+{
+	state[0] = 0x67452301;
+	state[1] = 0xefcdab89;
+	state[2] = 0x98badcfe;
+	state[3] = 0x10325476;
+
+	length = 0;
+	bufferLength = 0;
+}
+
+void Md5::update(const void *data, const uint32_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint32_t remaining = length;
+
+	this->length += length;
+
+	if (bufferLength)
+	{
+		uint32_t copyLength = 64 - bufferLength;
+
+		if (copyLength > remaining)
+			copyLength = remaining;
+
+		memcpy(buffer + bufferLength, bytes, copyLength);
+		bufferLength += copyLength;
+		bytes += copyLength;
+		remaining -= copyLength;
+
+		if (bufferLength < 64)
+			return;
+
+		processBlock(buffer);
+		bufferLength = 0;
+	}
+
+	for (; remaining >= 64; remaining -= 64, bytes += 64)
+		processBlock(bytes);
+
+	memcpy(buffer, bytes, remaining);
+	bufferLength = remaining;
+}
+
+void Md5::finish(uint8_t *digest)
+{
+	uint64_t bits = length * 8;
+	uint8_t  padding[72];
+	uint32_t paddingLength = ((bufferLength < 56) ? 56 : 120) - bufferLength;
+
+	memset(padding, 0, sizeof(padding));
+	padding[0] = 0x80;
+
+	//
+	// md5 is little endian throughout
+	//
+	for (int i = 0; i < 8; i++)
+		padding[paddingLength + i] = (uint8_t)(bits >> (i * 8));
+
+	update(padding, paddingLength + 8);
+
+	for (int i = 0; i < 16; i++)
+		digest[i] = (uint8_t)(state[i / 4] >> ((i % 4) * 8));
+}
+
+void Md5::processBlock(const uint8_t *block)
+{
+	uint32_t m[16];
+	uint32_t a, b, c, d;
+
+	for (int i = 0; i < 16; i++)
+		m[i] = block[i * 4] | (block[i * 4 + 1] << 8) | (block[i * 4 + 2] << 16) | (block[i * 4 + 3] << 24);
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+
+	for (int i = 0; i < 64; i++)
+	{
+		uint32_t f;
+		int g;
+
+		if (i < 16)
+		{
+			f = (b & c) | (~b & d);
+			g = i;
+		}
+		else if (i < 32)
+		{
+			f = (d & b) | (~d & c);
+			g = (5 * i + 1) % 16;
+		}
+		else if (i < 48)
+		{
+			f = b ^ c ^ d;
+			g = (3 * i + 5) % 16;
+		}
+		else
+		{
+			f = c ^ (b | ~d);
+			g = (7 * i) % 16;
+		}
+
+		f += a + md5Constants[i] + m[g];
+		a = d;
+		d = c;
+		c = b;
+		b += rotateLeft(f, md5Shifts[i]);
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+}
+
+void toHex(const uint8_t *data, const uint32_t length, char *out, const bool upperCase)
+{
+	const char *digits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+
+	for (uint32_t i = 0; i < length; i++)
+	{
+		out[i * 2] = digits[data[i] >> 4];
+		out[i * 2 + 1] = digits[data[i] & 0x0F];
+	}
+
+	out[length * 2] = 0;
+}
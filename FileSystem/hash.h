@@ -0,0 +1,105 @@
+//
+// checksums used to catalogue disc images.  each one is fed data in
+// pieces with update and then gives its result once
+//
+
+#ifndef _HASH_H_
+#define _HASH_H_
+
+#include "filesystem.h"
+
+const uint32_t sha1DigestSize = 20;
+const uint32_t md5DigestSize  = 16;
+
+//
+// crc-32 as zip and png use it
+//
+class Crc32
+{
+	public:
+		Crc32();
+
+		void update(const void *data, const uint32_t length);
+		uint32_t getValue();
+
+	private:
+		uint32_t crc;
+};
+
+class Sha1
+{
+	public:
+		Sha1();
+
+		void update(const void *data, const uint32_t length);
+
+		//
+		// finish:
+		//     pads the message and writes out the digest.  the object
+		//     can't be used again afterwards
+		//
+		// arguments:
+		//     1) uint8_t *digest (OUT): sha1DigestSize bytes
+		//
+		// return value:
+		//     none
+		//
+		void finish(uint8_t *digest);
+
+	private:
+		void processBlock(const uint8_t *block);
+
+		uint32_t state[5];
+		uint64_t length;
+		uint8_t  buffer[64];
+		uint32_t bufferLength;
+};
+
+//
+// md5 is only here because 4DO's game database is keyed on it
+//
+class Md5
+{
+	public:
+		Md5();
+
+		void update(const void *data, const uint32_t length);
+
+		//
+		// finish:
+		//     pads the message and writes out the digest.  the object
+		//     can't be used again afterwards
+		//
+		// arguments:
+		//     1) uint8_t *digest (OUT): md5DigestSize bytes
+		//
+		// return value:
+		//     none
+		//
+		void finish(uint8_t *digest);
+
+	private:
+		void processBlock(const uint8_t *block);
+
+		uint32_t state[4];
+		uint64_t length;
+		uint8_t  buffer[64];
+		uint32_t bufferLength;
+};
+
+//
+// toHex:
+//     writes bytes out as hex digits followed by a terminating 0
+//
+// arguments:
+//     1) const uint8_t *data (IN): the bytes
+//     2) const uint32_t length (IN): the number of bytes
+//     3) char *out (OUT): room for length * 2 + 1 characters
+//     4) const bool upperCase (IN): whether to use A-F rather than a-f
+//
+// return value:
+//     none
+//
+void toHex(const uint8_t *data, const uint32_t length, char *out, const bool upperCase);
+
+#endif // #ifndef _HASH_H_
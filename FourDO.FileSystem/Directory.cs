@@ -111,6 +111,9 @@ namespace FourDO.FileSystem
 
 		private List<IItem> FetchItems()
 		{
+			if (_fileSystem.Index != null)
+				return FetchIndexedItems();
+
 			var returnValue = new List<IItem>();
 
 			var coreFileSystem = _fileSystem.CoreFileSystem;
@@ -156,5 +159,22 @@ namespace FourDO.FileSystem
 
 			return returnValue;
 		}
+
+		private List<IItem> FetchIndexedItems()
+		{
+			var returnValue = new List<IItem>();
+			var blockSize = _fileSystem.CoreFileSystem.GetBlockSize();
+
+			foreach (var entry in _fileSystem.Index.GetChildren(this.GetFullPath()))
+			{
+				// Indexed directories never read their own header; their children come from the index too.
+				if (entry.ItemType == ItemType.Directory)
+					returnValue.Add(new Directory(entry.FirstCopy * blockSize, _fileSystem, new CoreDirectoryHeader(), entry.CoreDirectoryEntry, this));
+				else
+					returnValue.Add(new File(0, _fileSystem, entry.CoreDirectoryEntry, this));
+			}
+
+			return returnValue;
+		}
 	}
 }
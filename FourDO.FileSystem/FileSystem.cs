@@ -15,6 +15,7 @@ namespace FourDO.FileSystem
 
 		private VolumeHeader _rootVolumeHeader;
 		private Directory _rootDirectory;
+		private FileSystemIndex _index;
 
 
 		internal CoreFileSystem CoreFileSystem
@@ -32,6 +33,17 @@ namespace FourDO.FileSystem
 			get { return _rootDirectory; }
 		}
 
+		// When set, directories list their items from the index instead of reading the disc.
+		public FileSystemIndex Index
+		{
+			get { return _index; }
+		}
+
+		public FileSystem(IFileReader fileReader, FileSystemIndex index) : this(fileReader)
+		{
+			_index = index;
+		}
+
 		public FileSystem(IFileReader fileReader)
 		{
 			_fileReader = fileReader;
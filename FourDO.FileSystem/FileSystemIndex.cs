@@ -0,0 +1,429 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.InteropServices;
+using FourDO.FileSystem.Core.Structs;
+
+namespace FourDO.FileSystem
+{
+	// 
+	// FileSystemIndex:
+	//     a table of every file and directory on a disc, built by reading
+	//     each directory block exactly once. paths are looked up with a 
+	//     binary search instead of walking the directories, and the table
+	//     can be saved next to the image so later runs skip the walk.
+	// 
+	public class FileSystemIndex
+	{
+		private const UInt32 CacheMagic = 0x49443446; // "4DOI"
+		private const UInt32 CacheVersion = 1;
+
+		// A damaged disc could send us around in circles; no real disc comes close.
+		private const int MaxDirectoryDepth = 64;
+
+		private static readonly StringComparer PathComparer = StringComparer.OrdinalIgnoreCase;
+
+		private CoreVolumeHeader _coreVolumeHeader;
+
+		private List<IndexEntry> _entries = new List<IndexEntry>(); // in disc order
+		private string[] _sortedPaths;
+		private IndexEntry[] _sortedEntries;
+		private Dictionary<string, List<IndexEntry>> _children;
+
+		private FileSystemIndex()
+		{
+		}
+
+		public int Count
+		{
+			get { return _entries.Count; }
+		}
+
+		// 
+		// Build: 
+		//     walks the whole filesystem once, reading each directory block
+		//     in a single read and parsing its entries from memory.
+		// 
+		// arguments:
+		//     1) IFileReader fileReader: the disc
+		// 
+		// return value:
+		//     the index, or null if there is no readable volume header
+		// 
+		public static FileSystemIndex Build(IFileReader fileReader)
+		{
+			var index = new FileSystemIndex();
+			if (!ReadVolumeHeader(fileReader, out index._coreVolumeHeader))
+				return null;
+
+			var vh = index._coreVolumeHeader;
+			index.ReadDirectory(fileReader, "", vh.FirstCopy, vh.rootDirBlocks, vh.rootDirBlockSize, 0);
+			index.Sort();
+			return index;
+		}
+
+		// 
+		// LoadOrBuild: 
+		//     uses the index saved at cachePath if it was made for this disc,
+		//     otherwise builds a new one and tries to save it there.
+		// 
+		// arguments:
+		//     1) IFileReader fileReader: the disc
+		//     2) string cachePath: where the index is kept, or null to not keep it
+		// 
+		// return value:
+		//     the index, or null if there is no readable volume header
+		// 
+		public static FileSystemIndex LoadOrBuild(IFileReader fileReader, string cachePath)
+		{
+			if (cachePath != null && System.IO.File.Exists(cachePath))
+			{
+				try
+				{
+					using (var stream = new FileStream(cachePath, FileMode.Open, FileAccess.Read))
+					{
+						var cached = Load(stream, fileReader);
+						if (cached != null)
+							return cached;
+					}
+				}
+				catch (IOException) { }
+				catch (UnauthorizedAccessException) { }
+			}
+
+			var index = Build(fileReader);
+			if (index != null && cachePath != null)
+			{
+				try
+				{
+					using (var stream = new FileStream(cachePath, FileMode.Create, FileAccess.Write))
+						index.Save(stream);
+				}
+				catch (IOException) { }
+				catch (UnauthorizedAccessException) { } // Read-only media is fine; we just rebuild next time.
+			}
+			return index;
+		}
+
+		// 
+		// Find: 
+		//     looks up an item by its full path ("/folder/file"). case does
+		//     not matter, as on the 3DO.
+		// 
+		// return value:
+		//     the entry, or null if there is no such item
+		// 
+		public IndexEntry Find(string path)
+		{
+			path = NormalizePath(path);
+			int position = Array.BinarySearch(_sortedPaths, path, PathComparer);
+			return (position >= 0) ? _sortedEntries[position] : null;
+		}
+
+		// 
+		// GetChildren: 
+		//     lists a directory in the order the disc stores it. the root 
+		//     directory is "/" (or "").
+		// 
+		// return value:
+		//     the items in the directory; empty if there is no such directory
+		// 
+		public List<IndexEntry> GetChildren(string path)
+		{
+			List<IndexEntry> children;
+			if (!_children.TryGetValue(NormalizePath(path), out children))
+				return new List<IndexEntry>();
+			return new List<IndexEntry>(children);
+		}
+
+		public IEnumerable<IndexEntry> Entries
+		{
+			get { return _sortedEntries; }
+		}
+
+		public void Save(Stream stream)
+		{
+			var writer = new BinaryWriter(stream);
+			writer.Write(CacheMagic);
+			writer.Write(CacheVersion);
+			WriteVolumeKey(writer, _coreVolumeHeader);
+
+			writer.Write(_entries.Count);
+			var entryBytes = new byte[CoreDirectoryEntryConsts.DirectoryEntrySize];
+			foreach (var entry in _entries)
+			{
+				writer.Write(entry.Path);
+				unsafe
+				{
+					fixed (byte* entryPtr = entryBytes)
+						*(CoreDirectoryEntry*)entryPtr = entry.CoreDirectoryEntry;
+				}
+				writer.Write(entryBytes);
+
+				var copies = entry.Copies;
+				writer.Write(copies.Length);
+				foreach (var copy in copies)
+					writer.Write(copy);
+			}
+			writer.Flush();
+		}
+
+		// 
+		// Load: 
+		//     reads an index written by Save.
+		// 
+		// arguments:
+		//     1) Stream stream: the saved index
+		//     2) IFileReader fileReader: the disc, whose volume header must 
+		//        match the one the index was built from
+		// 
+		// return value:
+		//     the index, or null if it is damaged or belongs to another disc
+		// 
+		public static FileSystemIndex Load(Stream stream, IFileReader fileReader)
+		{
+			var index = new FileSystemIndex();
+			if (!ReadVolumeHeader(fileReader, out index._coreVolumeHeader))
+				return null;
+
+			var reader = new BinaryReader(stream);
+			try
+			{
+				if (reader.ReadUInt32() != CacheMagic || reader.ReadUInt32() != CacheVersion)
+					return null;
+
+				var key = new MemoryStream();
+				WriteVolumeKey(new BinaryWriter(key), index._coreVolumeHeader);
+				var savedKey = reader.ReadBytes((int)key.Length);
+				if (!KeysMatch(key.ToArray(), savedKey))
+					return null;
+
+				int count = reader.ReadInt32();
+				if (count < 0)
+					return null;
+				for (int i = 0; i < count; i++)
+				{
+					var path = reader.ReadString();
+					var entryBytes = reader.ReadBytes(CoreDirectoryEntryConsts.DirectoryEntrySize);
+					if (entryBytes.Length != CoreDirectoryEntryConsts.DirectoryEntrySize)
+						return null;
+
+					var coreDirectoryEntry = new CoreDirectoryEntry();
+					unsafe
+					{
+						fixed (byte* entryPtr = entryBytes)
+							coreDirectoryEntry = *(CoreDirectoryEntry*)entryPtr;
+					}
+
+					// No more copies than fit in a directory block, as when reading the disc;
+					// the count is compared in 64 bits so a lastCopy of 0xFFFFFFFF can't wrap to 0.
+					int copyCount = reader.ReadInt32();
+					if (coreDirectoryEntry.lastCopy >= index._coreVolumeHeader.rootDirBlockSize / 4)
+						return null;
+					if (copyCount != (Int64)coreDirectoryEntry.lastCopy + 1)
+						return null;
+					var copies = new UInt32[copyCount];
+					for (int c = 0; c < copyCount; c++)
+						copies[c] = reader.ReadUInt32();
+
+					index._entries.Add(new IndexEntry(path, coreDirectoryEntry, copies));
+				}
+			}
+			catch (EndOfStreamException)
+			{
+				return null;
+			}
+
+			index.Sort();
+			return index;
+		}
+
+		private void ReadDirectory(IFileReader fileReader, string path, UInt32 firstBlock, UInt32 blocks, UInt32 blockSize, int depth)
+		{
+			if (depth > MaxDirectoryDepth || blockSize < CoreDirectoryHeaderConsts.DirectoryHeaderSize)
+				return;
+
+			var blockBytes = new byte[blockSize];
+			var folders = new List<IndexEntry>();
+
+			// Each block names the next one; count them so a bad link cannot loop.
+			Int32 blockNumber = 0;
+			for (UInt32 blocksRead = 0; blocksRead < Math.Max(blocks, 1); blocksRead++)
+			{
+				UInt32 byteNumber = (firstBlock + (UInt32)blockNumber) * _coreVolumeHeader.rootDirBlockSize;
+				if (!ReadBytes(fileReader, byteNumber, blockBytes))
+					break;
+
+				Int32 nextBlock;
+				if (ParseDirectoryBlock(blockBytes, path, folders, out nextBlock))
+					break;
+				if (nextBlock < 0 || nextBlock >= blocks)
+					break;
+				blockNumber = nextBlock;
+			}
+
+			foreach (var folder in folders)
+				ReadDirectory(fileReader, folder.Path, folder.FirstCopy, folder.EntryLengthBlocks, folder.BlockSize, depth + 1);
+		}
+
+		// Returns true once the last entry of the directory has been seen.
+		private unsafe bool ParseDirectoryBlock(byte[] blockBytes, string path, List<IndexEntry> folders, out Int32 nextBlock)
+		{
+			UInt32 blockSize = (UInt32)blockBytes.Length;
+			const UInt32 copiesOffset = CoreDirectoryEntryConsts.DirectoryEntrySize - 4;
+
+			fixed (byte* blockPtr = blockBytes)
+			{
+				var header = *(CoreDirectoryHeader*)blockPtr;
+				nextBlock = (Int32)EndianSwap((UInt32)header.nextBlock);
+				UInt32 offset = EndianSwap(header.directoryOffset);
+
+				while (offset + CoreDirectoryEntryConsts.DirectoryEntrySize <= blockSize)
+				{
+					var coreDirectoryEntry = *(CoreDirectoryEntry*)(blockPtr + offset);
+					EndianSwap(ref coreDirectoryEntry);
+
+					if (coreDirectoryEntry.lastCopy >= (blockSize - offset - copiesOffset) / 4)
+						return true; // Runs off the block; the directory is damaged.
+
+					var copies = new UInt32[coreDirectoryEntry.lastCopy + 1];
+					var copyPtr = (UInt32*)(blockPtr + offset + copiesOffset);
+					for (int i = 0; i < copies.Length; i++)
+						copies[i] = EndianSwap(copyPtr[i]);
+
+					var entry = new IndexEntry(path + "/" + coreDirectoryEntry.FileNameString, coreDirectoryEntry, copies);
+					_entries.Add(entry);
+					if (entry.ItemType == ItemType.Directory)
+						folders.Add(entry);
+
+					offset += copiesOffset + (UInt32)copies.Length * 4;
+
+					UInt32 position = coreDirectoryEntry.flags & CoreDirectoryEntryConsts.DirectoryEntryPosMask;
+					if (position == CoreDirectoryEntryConsts.DirectoryEntryPosLastInDir)
+						return true;
+					if (position == CoreDirectoryEntryConsts.DirectoryEntryPosLastInBlock)
+						return false;
+				}
+			}
+			return false;
+		}
+
+		private void Sort()
+		{
+			_sortedEntries = _entries.ToArray();
+			_sortedPaths = new string[_sortedEntries.Length];
+			for (int i = 0; i < _sortedEntries.Length; i++)
+				_sortedPaths[i] = _sortedEntries[i].Path;
+			Array.Sort(_sortedPaths, _sortedEntries, PathComparer);
+
+			_children = new Dictionary<string, List<IndexEntry>>(PathComparer);
+			_children[""] = new List<IndexEntry>();
+			foreach (var entry in _entries)
+			{
+				List<IndexEntry> siblings;
+				if (!_children.TryGetValue(entry.ParentPath, out siblings))
+				{
+					siblings = new List<IndexEntry>();
+					_children[entry.ParentPath] = siblings;
+				}
+				siblings.Add(entry);
+			}
+		}
+
+		private static string NormalizePath(string path)
+		{
+			path = (path ?? "").TrimEnd('/');
+			if (path.Length > 0 && !path.StartsWith("/"))
+				path = "/" + path;
+			return path;
+		}
+
+		private static bool ReadBytes(IFileReader fileReader, UInt32 byteNumber, byte[] buffer)
+		{
+			if (!fileReader.SeekToByte(byteNumber, false))
+				return false;
+
+			UInt32 bytesRead = 0;
+			GCHandle handle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
+			try
+			{
+				return fileReader.Read(handle.AddrOfPinnedObject(), (UInt32)buffer.Length, ref bytesRead)
+					&& bytesRead == buffer.Length;
+			}
+			finally
+			{
+				handle.Free();
+			}
+		}
+
+		private static unsafe bool ReadVolumeHeader(IFileReader fileReader, out CoreVolumeHeader vh)
+		{
+			vh = new CoreVolumeHeader();
+			var buffer = new byte[CoreVolumeHeaderConsts.VolumeHeaderSize];
+			if (!ReadBytes(fileReader, 0, buffer))
+				return false;
+
+			fixed (byte* bufferPtr = buffer)
+				vh = *(CoreVolumeHeader*)bufferPtr;
+
+			vh.id = EndianSwap(vh.id);
+			vh.blockSize = EndianSwap(vh.blockSize);
+			vh.blockCount = EndianSwap(vh.blockCount);
+			vh.rootDirId = EndianSwap(vh.rootDirId);
+			vh.rootDirBlocks = EndianSwap(vh.rootDirBlocks);
+			vh.rootDirBlockSize = EndianSwap(vh.rootDirBlockSize);
+			vh.lastRootDirCopy = EndianSwap(vh.lastRootDirCopy);
+			fixed (UInt32* copies = vh.rootDirCopies)
+			{
+				for (int i = 0; i < 8; i++)
+					copies[i] = EndianSwap(copies[i]);
+			}
+
+			return vh.rootDirBlockSize != 0;
+		}
+
+		// What ties a saved index to its disc.
+		private static void WriteVolumeKey(BinaryWriter writer, CoreVolumeHeader vh)
+		{
+			writer.Write(vh.id);
+			writer.Write(vh.blockCount);
+			writer.Write(vh.rootDirBlocks);
+			writer.Write(vh.rootDirBlockSize);
+			writer.Write(vh.FirstCopy);
+			writer.Flush();
+		}
+
+		private static bool KeysMatch(byte[] key, byte[] savedKey)
+		{
+			if (key.Length != savedKey.Length)
+				return false;
+			for (int i = 0; i < key.Length; i++)
+			{
+				if (key[i] != savedKey[i])
+					return false;
+			}
+			return true;
+		}
+
+		private static void EndianSwap(ref CoreDirectoryEntry de)
+		{
+			de.flags = EndianSwap(de.flags);
+			de.id = EndianSwap(de.id);
+			de.blockSize = EndianSwap(de.blockSize);
+			de.entryLengthBytes = EndianSwap(de.entryLengthBytes);
+			de.entryLengthBlocks = EndianSwap(de.entryLengthBlocks);
+			de.burst = EndianSwap(de.burst);
+			de.gap = EndianSwap(de.gap);
+			de.lastCopy = EndianSwap(de.lastCopy);
+			de.copies = EndianSwap(de.copies);
+		}
+
+		private static UInt32 EndianSwap(UInt32 x)
+		{
+			return (x >> 24) | 
+				((x >> 8) & 0x0000FF00) | 
+				((x << 8) & 0x00FF0000) | 
+				(x << 24);
+		}
+	}
+}
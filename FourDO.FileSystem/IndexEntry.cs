@@ -0,0 +1,59 @@
+﻿using System;
+using FourDO.FileSystem.Core.Structs;
+
+namespace FourDO.FileSystem
+{
+	public class IndexEntry
+	{
+		private string _path;
+		private CoreDirectoryEntry _coreDirectoryEntry;
+		private UInt32[] _copies;
+
+		internal IndexEntry(string path, CoreDirectoryEntry coreDirectoryEntry, UInt32[] copies)
+		{
+			_path = path;
+			_coreDirectoryEntry = coreDirectoryEntry;
+			_copies = copies;
+		}
+
+		internal CoreDirectoryEntry CoreDirectoryEntry
+		{
+			get { return _coreDirectoryEntry; }
+		}
+
+		// Full path as Directory.GetFullPath gives it: "/FOLDER/FILE".
+		public string Path { get { return _path; } }
+
+		public string ParentPath
+		{
+			get { return _path.Substring(0, _path.LastIndexOf('/')); }
+		}
+
+		public string Name { get { return _coreDirectoryEntry.FileNameString; } }
+		public string Extension { get { return _coreDirectoryEntry.ExtString; } }
+
+		public ItemType ItemType
+		{
+			get
+			{
+				UInt32 itemType = (_coreDirectoryEntry.flags & CoreDirectoryEntryConsts.DirectoryEntryTypeMask);
+				return (itemType == CoreDirectoryEntryConsts.DirectoryEntryTypeFolder) ? ItemType.Directory : ItemType.File;
+			}
+		}
+
+		public uint Flags { get { return _coreDirectoryEntry.flags; } }
+		public uint Id { get { return _coreDirectoryEntry.id; } }
+		public uint BlockSize { get { return _coreDirectoryEntry.blockSize; } }
+		public uint EntryLengthBytes { get { return _coreDirectoryEntry.entryLengthBytes; } }
+		public uint EntryLengthBlocks { get { return _coreDirectoryEntry.entryLengthBlocks; } }
+
+		public uint FirstCopy { get { return _copies[0]; } }
+
+		// Every block the item is stored at; the disc usually holds
+		// several copies of each directory.
+		public UInt32[] Copies
+		{
+			get { return (UInt32[])_copies.Clone(); }
+		}
+	}
+}
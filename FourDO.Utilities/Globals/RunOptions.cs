@@ -23,6 +23,7 @@
 
 		public static bool PrintKPrint { get; set; }
 		public static bool ForceGdiRendering { get; set; }
+		public static bool ForcePushAudio { get; set; }
 		public static bool StartupPaused { get; set; }
 	}
 }
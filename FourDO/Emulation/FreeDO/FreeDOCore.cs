@@ -16,6 +16,13 @@ namespace FourDO.Emulation.FreeDO
 		FIX_BIT_GRAPHICS_STEP_Y = 0x00080000,
 	}
 
+	public enum CDTiming
+	{
+		Turbo = 0, // Sectors are there as soon as the game asks for them.
+		SingleSpeed = 1,
+		DoubleSpeed = 2,
+	}
+
 
 
 	internal static class FreeDOCore
@@ -37,6 +44,9 @@ namespace FourDO.Emulation.FreeDO
 		public delegate void PushSampleDelegate(uint dspSample);
 		public static PushSampleDelegate PushSampleEvent { get; set; }
 
+		public delegate void PushSamplesDelegate(IntPtr samples, int count);
+		public static PushSamplesDelegate PushSamplesEvent { get; set; }
+
 		public delegate int GetPbusLengthDelegate();
 		public static GetPbusLengthDelegate GetPbusLengthEvent { get; set; }
 
@@ -73,8 +83,8 @@ namespace FourDO.Emulation.FreeDO
 			EXT_READ_ROMS = 1,
 			EXT_READ_NVRAM = 2,
 			EXT_WRITE_NVRAM = 3,
-			EXT_SWAPFRAME = 5, //frame swap (in mutlithreaded) or frame draw(single treaded)
-			EXT_PUSH_SAMPLE = 6, //sends sample to the buffer
+			EXT_SWAPFRAME = 5, //frame done, data is the finished frame (valid only inside the callback)
+			EXT_PUSH_SAMPLE = 6, //sends sample to the buffer (no longer sent, see EXT_PUSH_SAMPLES)
 			EXT_GET_PBUSLEN = 7,
 			EXT_GETP_PBUSDATA = 8,
 			EXT_KPRINT = 9,
@@ -84,7 +94,7 @@ namespace FourDO.Emulation.FreeDO
 			EXT_GET_DISC_SIZE = 15,
 			EXT_ON_SECTOR = 16,
 			EXT_ARM_SYNC = 17,
-			FDP_GET_FRAME_BITMAP = 18
+			EXT_PUSH_SAMPLES = 18, //data is a SampleBlock, sent per 512 samples and at the end of a frame
 		}
 
 		private enum InterfaceFunction
@@ -96,8 +106,8 @@ namespace FourDO.Emulation.FreeDO
 			FDP_DO_FRAME_MT = 4,  //multitasking
 			FDP_DO_EXECFRAME_MT = 5,  //multitasking
 			FDP_DO_LOAD = 6,  //load state from buffer, returns !NULL if everything went smooth
-			FDP_GET_SAVE_SIZE = 7,  //return size of savestatemachine
-			FDP_DO_SAVE = 8,  //save state to buffer
+			FDP_GET_SAVE_SIZE = 7,  //return size of savestatemachine (room for the largest state, full or incremental)
+			FDP_DO_SAVE = 8,  //save state to buffer, returns the length
 			FDP_GETP_NVRAM = 9,  //returns ptr to NVRAM 32K
 			FDP_GETP_RAMS = 10, //returns ptr to RAM 3M
 			FDP_GETP_ROMS = 11, //returns ptr to ROM 2M
@@ -109,7 +119,28 @@ namespace FourDO.Emulation.FreeDO
 			FDP_SET_FIX_MODE = 17,
 			FDP_GET_FRAME_BITMAP = 18,
             FDP_GET_BIOS_TYPE = 19,
-            FDP_SET_ANVIL = 20
+            FDP_SET_ANVIL = 20,
+            FDP_GETP_FRAME = 21, //returns ptr to the newest finished frame, owned by the caller until the next call
+            FDP_GET_SCALER_INFO = 22, //fills ScalerInfo at datum, returns !NULL if the scaler exists
+            FDP_CAPTURE_START = 23, //start streaming frames to the file named by datum, returns !NULL on success
+            FDP_CAPTURE_STOP = 24, //flush and close the capture, returns the number of dropped frames
+            FDP_AUDIO_SET_RATE = 25, //datum is the host output rate in Hz, 0 turns the resampled output off
+            FDP_AUDIO_READ = 26, //datum is a SampleBlock to fill with up to count resampled samples, returns the count read
+            FDP_AUDIO_GET_BUFFERED = 27, //returns the number of resampled samples waiting to be read
+            FDP_AUDIO_WAIT = 28, //blocks until at most datum samples are buffered (0 = default latency), returns the count
+            FDP_AUDIO_CAPTURE_START = 29, //start recording DSP output to the WAV (or .flac) file named by datum, returns !NULL on success
+            FDP_AUDIO_CAPTURE_STOP = 30, //finish and close the recording, returns the number of dropped samples
+            FDP_DISC_OPEN = 31, //map the disc image (.iso, BIN/CUE or .4doz) named by datum and read sectors from it, returns !NULL on success; call while the core is not running
+            FDP_DISC_CLOSE = 32, //unmap the disc image, back to EXT_READ2048; call while the core is not running
+            FDP_DISC_READ = 33, //datum is a DiscSectorRequest, copies one sector of the open image, returns !NULL on success
+            FDP_DISC_COMPRESS = 34, //datum is a DiscCompressRequest, writes source as a .4doz image, returns !NULL on success
+            FDP_SET_CD_TIMING = 35, //datum is one of CD_TIMING_*, may be changed at any time; returns NULL, changing nothing, for any other value
+            FDP_SECTOR_TRACE_START = 36, //start recording the sectors the drive reads; call right after FDP_INIT, returns !NULL on success
+            FDP_SECTOR_TRACE_STOP = 37, //datum is a SectorTraceRequest, writes the trace and boot profile, returns !NULL if the profile was written
+            FDP_SECTOR_PRELOAD = 38, //read the sectors of the boot profile named by datum ahead of time; call after FDP_INIT, returns the number of sectors
+            FDP_SET_SAVE_BASE = 39, //start tracking RAM changes against a copy of the current RAM, returns the base's id
+            FDP_DO_SAVE_INCREMENTAL = 40, //save state to buffer (FDP_GET_SAVE_SIZE bytes) with only the RAM pages changed since the base, returns the length, 0 without a base; FDP_DO_LOAD takes it back while the base is current
+            FDP_DO_LOAD_BUFFER = 41 //datum is a StateBuffer, like FDP_DO_LOAD but never reads past length; returns !NULL if the state loaded, and changes nothing if not
 		}
 
 		#endregion // Private Types
@@ -142,6 +173,11 @@ namespace FourDO.Emulation.FreeDO
 			return FreeDoInterface((int)InterfaceFunction.FDP_GETP_ROMS, (IntPtr)0);
 		}
 
+		public static IntPtr GetPointerFrame()
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_GETP_FRAME, (IntPtr)0);
+		}
+
 		public static IntPtr GetPointerProfile()
 		{
 			return FreeDoInterface((int)InterfaceFunction.FDP_GETP_PROFILE, (IntPtr)0);
@@ -171,14 +207,14 @@ namespace FourDO.Emulation.FreeDO
 			FreeDoInterface((int)InterfaceFunction.FDP_DESTROY, (IntPtr)0);
 		}
 
-		public static void DoExecuteFrame(IntPtr VDLFrame)
+		public static void DoExecuteFrame()
 		{
-			FreeDoInterface((int)InterfaceFunction.FDP_DO_EXECFRAME, VDLFrame);
+			FreeDoInterface((int)InterfaceFunction.FDP_DO_EXECFRAME, (IntPtr)0);
 		}
 
-		public static void DoExecuteFrameMultitask(IntPtr VDLFrame)
+		public static void DoExecuteFrameMultitask()
 		{
-			FreeDoInterface((int)InterfaceFunction.FDP_DO_EXECFRAME_MT, VDLFrame);
+			FreeDoInterface((int)InterfaceFunction.FDP_DO_EXECFRAME_MT, (IntPtr)0);
 		}
 
 		public static void DoFrameMultitask(IntPtr VDLFrame)
@@ -186,14 +222,241 @@ namespace FourDO.Emulation.FreeDO
 			FreeDoInterface((int)InterfaceFunction.FDP_DO_FRAME_MT, VDLFrame);
 		}
 
-		public static bool DoLoad(IntPtr loadBuffer)
+		/// <summary>
+		/// Loads the state in the first length bytes of the buffer. Returns false, leaving the
+		/// console as it was, if the state is damaged, cut short, from another BIOS or an
+		/// incremental state whose base is gone.
+		/// </summary>
+		public static bool DoLoad(IntPtr loadBuffer, int length)
+		{
+			var request = new StateBuffer();
+			request.data = loadBuffer;
+			request.length = (uint)length;
+
+			GCHandle requestHandle;
+			RawSerialize(request, out requestHandle);
+			bool loaded = FreeDoInterface((int)InterfaceFunction.FDP_DO_LOAD_BUFFER, requestHandle.AddrOfPinnedObject()) != IntPtr.Zero;
+			requestHandle.Free();
+			return loaded;
+		}
+
+		/// <summary>
+		/// Saves into a buffer of GetSaveSize bytes. Returns the length of the state, which is
+		/// usually less than that.
+		/// </summary>
+		public static int DoSave(IntPtr saveBuffer)
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_DO_SAVE, saveBuffer).ToInt32();
+		}
+
+		/// <summary>
+		/// Makes the current RAM the base that DoSaveIncremental saves against. Earlier incremental
+		/// states can no longer be loaded.
+		/// </summary>
+		public static void SetSaveBase()
+		{
+			FreeDoInterface((int)InterfaceFunction.FDP_SET_SAVE_BASE, (IntPtr)0);
+		}
+
+		/// <summary>
+		/// Saves like DoSave (into a buffer of GetSaveSize bytes), but with only the RAM pages that
+		/// changed since SetSaveBase. Returns the length of the state, or 0 if there is no base.
+		/// DoLoad takes the state back as long as the base has not changed since.
+		/// </summary>
+		public static int DoSaveIncremental(IntPtr saveBuffer)
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_DO_SAVE_INCREMENTAL, saveBuffer).ToInt32();
+		}
+
+		public static bool StartCapture(string fileName)
+		{
+			IntPtr fileNamePtr = Marshal.StringToHGlobalAnsi(fileName);
+			bool started = FreeDoInterface((int)InterfaceFunction.FDP_CAPTURE_START, fileNamePtr) != IntPtr.Zero;
+			Marshal.FreeHGlobal(fileNamePtr);
+			return started;
+		}
+
+		public static int StopCapture()
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_CAPTURE_STOP, (IntPtr)0).ToInt32();
+		}
+
+		/// <summary>
+		/// Has the core record its audio to a WAV file, or FLAC when the name ends in ".flac".
+		/// Does nothing if a recording is already running.
+		/// </summary>
+		public static bool StartAudioCapture(string fileName)
+		{
+			IntPtr fileNamePtr = Marshal.StringToHGlobalAnsi(fileName);
+			bool started = FreeDoInterface((int)InterfaceFunction.FDP_AUDIO_CAPTURE_START, fileNamePtr) != IntPtr.Zero;
+			Marshal.FreeHGlobal(fileNamePtr);
+			return started;
+		}
+
+		/// <summary>
+		/// Finishes the audio recording; returns the number of samples dropped because the disk fell behind.
+		/// </summary>
+		public static int StopAudioCapture()
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_AUDIO_CAPTURE_STOP, (IntPtr)0).ToInt32();
+		}
+
+		/// <summary>
+		/// Lets the core map an .iso, BIN/CUE or compressed .4doz image and read its sectors directly
+		/// instead of asking Read2048Event for each one. Call while the core is not running; returns
+		/// false when the core cannot open the image, in which case the events keep serving it.
+		/// </summary>
+		public static bool OpenDisc(string fileName)
+		{
+			IntPtr fileNamePtr = Marshal.StringToHGlobalAnsi(fileName);
+			bool opened = FreeDoInterface((int)InterfaceFunction.FDP_DISC_OPEN, fileNamePtr) != IntPtr.Zero;
+			Marshal.FreeHGlobal(fileNamePtr);
+			return opened;
+		}
+
+		/// <summary>
+		/// Releases the image opened with OpenDisc. Call while the core is not running.
+		/// </summary>
+		public static void CloseDisc()
+		{
+			FreeDoInterface((int)InterfaceFunction.FDP_DISC_CLOSE, (IntPtr)0);
+		}
+
+		/// <summary>
+		/// Copies one 2048-byte sector of the image opened with OpenDisc into buffer,
+		/// decompressing it if need be. Returns false (and zeroes) past the end of the disc.
+		/// </summary>
+		public static bool ReadDiscSector(IntPtr buffer, int sectorNumber)
 		{
-			return FreeDoInterface((int)InterfaceFunction.FDP_DO_LOAD, loadBuffer).ToInt32() != 0;
+			var request = new DiscSectorRequest();
+			request.sector = (uint)sectorNumber;
+			request.buffer = buffer;
+
+			GCHandle requestHandle;
+			RawSerialize(request, out requestHandle);
+			bool read = FreeDoInterface((int)InterfaceFunction.FDP_DISC_READ, requestHandle.AddrOfPinnedObject()) != IntPtr.Zero;
+			requestHandle.Free();
+			return read;
 		}
 
-		public static void DoSave(IntPtr saveBuffer)
+		/// <summary>
+		/// Writes any image OpenDisc accepts to a compressed .4doz image. Does not need the core
+		/// to be initialized and leaves the open disc alone.
+		/// </summary>
+		public static bool CompressDisc(string sourceFileName, string targetFileName)
 		{
-			FreeDoInterface((int)InterfaceFunction.FDP_DO_SAVE, saveBuffer);
+			var request = new DiscCompressRequest();
+			request.source = Marshal.StringToHGlobalAnsi(sourceFileName);
+			request.target = Marshal.StringToHGlobalAnsi(targetFileName);
+
+			GCHandle requestHandle;
+			RawSerialize(request, out requestHandle);
+			bool written = FreeDoInterface((int)InterfaceFunction.FDP_DISC_COMPRESS, requestHandle.AddrOfPinnedObject()) != IntPtr.Zero;
+			requestHandle.Free();
+
+			Marshal.FreeHGlobal(request.target);
+			Marshal.FreeHGlobal(request.source);
+			return written;
+		}
+
+		/// <summary>
+		/// Starts recording which sectors the drive reads and when. Call right after Initialize,
+		/// so that the start of the trace is the boot.
+		/// </summary>
+		public static bool StartSectorTrace()
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_SECTOR_TRACE_START, (IntPtr)0) != IntPtr.Zero;
+		}
+
+		/// <summary>
+		/// Ends the sector trace and writes it to traceFileName, along with the sectors read in the
+		/// first bootSeconds to profileFileName (either may be null). Returns true if the profile was
+		/// written; it is not when a state was loaded during the trace, or when the trace was shorter
+		/// than bootSeconds and a profile already exists.
+		/// </summary>
+		public static bool StopSectorTrace(string traceFileName, string profileFileName, int bootSeconds)
+		{
+			var request = new SectorTraceRequest();
+			request.tracePath = (traceFileName == null) ? IntPtr.Zero : Marshal.StringToHGlobalAnsi(traceFileName);
+			request.profilePath = (profileFileName == null) ? IntPtr.Zero : Marshal.StringToHGlobalAnsi(profileFileName);
+			request.bootSeconds = (uint)bootSeconds;
+
+			GCHandle requestHandle;
+			RawSerialize(request, out requestHandle);
+			bool profiled = FreeDoInterface((int)InterfaceFunction.FDP_SECTOR_TRACE_STOP, requestHandle.AddrOfPinnedObject()) != IntPtr.Zero;
+			requestHandle.Free();
+
+			if (request.profilePath != IntPtr.Zero)
+				Marshal.FreeHGlobal(request.profilePath);
+			if (request.tracePath != IntPtr.Zero)
+				Marshal.FreeHGlobal(request.tracePath);
+			return profiled;
+		}
+
+		/// <summary>
+		/// Reads every sector listed in a boot profile written by StopSectorTrace, in one pass in
+		/// sector order. Call after Initialize and before the core runs; returns the number of sectors.
+		/// </summary>
+		public static int PreloadSectors(string profileFileName)
+		{
+			IntPtr fileNamePtr = Marshal.StringToHGlobalAnsi(profileFileName);
+			int preloaded = FreeDoInterface((int)InterfaceFunction.FDP_SECTOR_PRELOAD, fileNamePtr).ToInt32();
+			Marshal.FreeHGlobal(fileNamePtr);
+			return preloaded;
+		}
+
+		/// <summary>
+		/// Has the core resample its output to the given rate (0 turns it off).
+		/// The result is picked up with ReadAudio.
+		/// </summary>
+		public static void SetAudioOutputRate(int rate)
+		{
+			FreeDoInterface((int)InterfaceFunction.FDP_AUDIO_SET_RATE, new IntPtr(rate));
+			AudioOutputRate = rate;
+		}
+
+		/// <summary>
+		/// The rate last given to SetAudioOutputRate; 0 while the core's output is off.
+		/// </summary>
+		public static int AudioOutputRate { get; private set; }
+
+		/// <summary>
+		/// Number of resampled samples the core has queued for ReadAudio.
+		/// </summary>
+		public static int GetAudioBuffered()
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_AUDIO_GET_BUFFERED, (IntPtr)0).ToInt32();
+		}
+
+		/// <summary>
+		/// Blocks until the audio sink has drained the core's output down to the watermark
+		/// (0 uses the core's default latency). Returns the number of samples still queued.
+		/// </summary>
+		public static int WaitAudio(int watermark)
+		{
+			return FreeDoInterface((int)InterfaceFunction.FDP_AUDIO_WAIT, new IntPtr(watermark)).ToInt32();
+		}
+
+		/// <summary>
+		/// Copies up to count resampled samples out of the core; returns how many it got.
+		/// Meant to be called from a single audio thread.
+		/// </summary>
+		public static int ReadAudio(uint[] buffer, int count)
+		{
+			GCHandle bufferHandle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
+
+			var block = new SampleBlock();
+			block.samples = bufferHandle.AddrOfPinnedObject();
+			block.count = Math.Min(count, buffer.Length);
+
+			GCHandle blockHandle;
+			RawSerialize(block, out blockHandle);
+
+			int read = FreeDoInterface((int)InterfaceFunction.FDP_AUDIO_READ, blockHandle.AddrOfPinnedObject()).ToInt32();
+
+			blockHandle.Free();
+			bufferHandle.Free();
+			return read;
 		}
 
 		public static IntPtr SetArmClock(int clock)
@@ -207,6 +470,15 @@ namespace FourDO.Emulation.FreeDO
 			return FreeDoInterface((int)InterfaceFunction.FDP_SET_FIX_MODE, new IntPtr(fixMode));
 		}
 
+		/// <summary>
+		/// Chooses how fast the emulated drive seeks and reads. Turbo is instant; the others
+		/// follow a real drive for titles that depend on it. Takes effect with the next read.
+		/// </summary>
+		public static void SetCDTiming(CDTiming timing)
+		{
+			FreeDoInterface((int)InterfaceFunction.FDP_SET_CD_TIMING, new IntPtr((int)timing));
+		}
+
 		public static IntPtr SetTextureQuality(int textureScalar)
 		{
 			return FreeDoInterface((int)InterfaceFunction.FDP_SET_TEXQUALITY, new IntPtr(textureScalar));
@@ -260,7 +532,11 @@ namespace FourDO.Emulation.FreeDO
                 resultingBitmapCrop.Right = crop.right;
                 resultingBitmapCrop.Bottom = crop.bottom;
             }
-            else if (param.scalingAlgorithm == 1 || Properties.Settings.Default.RenderHighResolution == true)
+            else if (param.scalingAlgorithm == (int)ScalingAlgorithm.Hq2X
+                || param.scalingAlgorithm == (int)ScalingAlgorithm.Nearest2X
+                || param.scalingAlgorithm == (int)ScalingAlgorithm.Bilinear2X
+                || param.scalingAlgorithm == (int)ScalingAlgorithm.Xbr2X
+                || Properties.Settings.Default.RenderHighResolution == true)
             {
                 resultingBitmapCrop.Top = crop.top + 32;
                 resultingBitmapCrop.Left = crop.left + 32;
@@ -297,6 +573,25 @@ namespace FourDO.Emulation.FreeDO
 			cropHandle.Free();
 		}
 
+		/// <summary>
+		/// Returns the core's throughput figures for a scaler, or null if the core doesn't have it.
+		/// Figures accumulate from the moment the scaler was last selected.
+		/// </summary>
+		public static ScalerInfo GetScalerInfo(ScalingAlgorithm scalingAlgorithm)
+		{
+			var info = new ScalerInfo();
+			info.scalingAlgorithm = (int)scalingAlgorithm;
+
+			GCHandle infoHandle;
+			RawSerialize(info, out infoHandle);
+
+			bool exists = FreeDoInterface((int)InterfaceFunction.FDP_GET_SCALER_INFO, infoHandle.AddrOfPinnedObject()) != IntPtr.Zero;
+			Marshal.PtrToStructure(infoHandle.AddrOfPinnedObject(), info);
+
+			infoHandle.Free();
+			return exists ? info : null;
+		}
+
 		private delegate IntPtr ExternalInterfaceDelegate(int procedure, IntPtr data);
 		private static readonly ExternalInterfaceDelegate externalInterfaceDelegate = new ExternalInterfaceDelegate(PrivateExternalInterface);
 
@@ -329,6 +624,16 @@ namespace FourDO.Emulation.FreeDO
 						PushSampleEvent((uint)data);
 					break;
 
+				case (int)ExternalFunction.EXT_PUSH_SAMPLES:
+					if (PushSamplesEvent != null)
+					{
+						// struct SampleBlock { unsigned int* samples; int count; }
+						IntPtr samples = Marshal.ReadIntPtr(data);
+						int count = Marshal.ReadInt32(data, IntPtr.Size);
+						PushSamplesEvent(samples, count);
+					}
+					break;
+
 				case (int)ExternalFunction.EXT_GET_PBUSLEN:
 					if (GetPbusLengthEvent != null)
 						return (IntPtr)GetPbusLengthEvent();
@@ -8,9 +8,60 @@ namespace FourDO.Emulation.FreeDO
 		None = 0,
 		Hq2X = 1,
 		Hq3X = 2,
-		Hq4X = 3
+		Hq4X = 3,
+		Nearest2X = 4,
+		Bilinear2X = 5,
+		Xbr2X = 6
 	}
 
+	[StructLayout(LayoutKind.Sequential, Pack = 1, CharSet = CharSet.Ansi)]
+	public class ScalerInfo
+	{
+		public int scalingAlgorithm;
+		[MarshalAs(UnmanagedType.ByValTStr, SizeConst = 16)]
+		public string name;
+		public int factor;
+		public uint frames;
+		public double averageMilliseconds;
+		public double megapixelsPerSecond;
+	};
+
+	[StructLayout(LayoutKind.Sequential, Pack = 1)]
+	public class SampleBlock
+	{
+		public IntPtr samples;
+		public int count;
+	};
+
+	[StructLayout(LayoutKind.Sequential, Pack = 1)]
+	public class DiscSectorRequest
+	{
+		public uint sector;
+		public IntPtr buffer;
+	};
+
+	[StructLayout(LayoutKind.Sequential, Pack = 1)]
+	public class DiscCompressRequest
+	{
+		public IntPtr source;
+		public IntPtr target;
+	};
+
+	[StructLayout(LayoutKind.Sequential, Pack = 1)]
+	public class SectorTraceRequest
+	{
+		public IntPtr tracePath;
+		public IntPtr profilePath;
+		public uint bootSeconds;
+	};
+
+	[StructLayout(LayoutKind.Sequential, Pack = 1)]
+	public class StateBuffer
+	{
+		public IntPtr data;
+		public uint length;
+	};
+
 	[StructLayout(LayoutKind.Sequential, Pack = 1)]
 	public class GetFrameBitmapParams
 	{
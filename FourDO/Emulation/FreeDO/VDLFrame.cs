@@ -7,8 +7,7 @@ namespace FourDO.Emulation.FreeDO
 			// The rest are the components of VDLLine... *sigh*
 			(
 				2 * 320*4 + // line
-				1 * 32    + // xCLUTB
-				1 * 32    + // xCLUTG
+				4         + // xCLUTSET
 				4         + // xOUTCONTROLL
 				4         + // xCLUTDMA
 				4           // xBACKGROUND
@@ -16,14 +15,21 @@ namespace FourDO.Emulation.FreeDO
 			];
 		public uint srcw;
 		public uint srch;
+		public uint clutcount;
+		public fixed byte cluts[240 * 3 * 32]; // VDLClut, indexed by VDLLine.xCLUTSET
 	}
 
-	public unsafe struct VDLLine
+	public unsafe struct VDLClut
 	{
-		public fixed ushort line[320 * 4];
 		public fixed byte xCLUTB[32];
 		public fixed byte xCLUTG[32];
 		public fixed byte xCLUTR[32];
+	}
+
+	public unsafe struct VDLLine
+	{
+		public fixed ushort line[320 * 4];
+		public uint xCLUTSET;
 		public uint xOUTCONTROLL;
 		public uint xCLUTDMA;
 		public uint xBACKGROUND;
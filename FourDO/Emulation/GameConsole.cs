@@ -59,12 +59,14 @@ namespace FourDO.Emulation
 
 		private const int TARGET_FRAMES_PER_SECOND = 60;
 
+		private const int SECTOR_PROFILE_BOOT_SECONDS = 30;
+		private const string SECTOR_TRACE_EXTENSION = ".sectortrace";
+		private const string SECTOR_PROFILE_EXTENSION = ".bootprofile";
+
 		private byte[] biosRom1Copy;
 		private byte[] biosRom2Copy;
 
-		private byte[] frame;
 		private IntPtr framePtr;
-		private GCHandle frameHandle;
 
 		private byte[] pbusData;
 		private IntPtr pbusDataPtr;
@@ -91,6 +93,11 @@ namespace FourDO.Emulation
 
 		private bool? renderHighResolution;
 
+		private CDTiming cdTiming = CDTiming.Turbo;
+
+		private string sectorProfileFolder;
+		private string sectorTraceBaseName;
+
 		private volatile FrameSpeedCalculator speedCalculator = new FrameSpeedCalculator(10);
 		private volatile HealthCalculator healthCalculator = new HealthCalculator();
 
@@ -124,6 +131,7 @@ namespace FourDO.Emulation
 			FreeDOCore.WriteNvramEvent = new FreeDOCore.WriteNvramDelegate(ExternalInterface_WriteNvram);
 			FreeDOCore.SwapFrameEvent = new FreeDOCore.SwapFrameDelegate(ExternalInterface_SwapFrame);
 			FreeDOCore.PushSampleEvent = new FreeDOCore.PushSampleDelegate(ExternalInterface_PushSample);
+			FreeDOCore.PushSamplesEvent = new FreeDOCore.PushSamplesDelegate(ExternalInterface_PushSamples);
 			FreeDOCore.GetPbusLengthEvent = new FreeDOCore.GetPbusLengthDelegate(ExternalInterface_GetPbusLength);
 			FreeDOCore.GetPbusDataEvent = new FreeDOCore.GetPbusDataDelegate(ExternalInterface_GetPbusData);
 			FreeDOCore.KPrintEvent = new FreeDOCore.KPrintDelegate(ExternalInterface_KPrint);
@@ -137,20 +145,6 @@ namespace FourDO.Emulation
 			this.nvramTimer.Elapsed += new ElapsedEventHandler(nvramTimer_Elapsed);
 			this.nvramTimer.Enabled = false;
 
-			///////////////
-			// Allocate the VDLFrames
-
-			// Get the size of a VDLFrame (must be "unsafe").
-			int VDLFrameSize;
-			unsafe
-			{
-				VDLFrameSize = sizeof(VDLFrame);
-			}
-
-			this.frame = new byte[VDLFrameSize];
-			this.frameHandle = GCHandle.Alloc(this.frame, GCHandleType.Pinned);
-			this.framePtr = this.frameHandle.AddrOfPinnedObject();
-
 			this.pbusData = new byte[PBUS_DATA_MAX_SIZE];
 			this.pbusDataHandle = GCHandle.Alloc(this.pbusData, GCHandleType.Pinned);
 			this.pbusDataPtr = this.pbusDataHandle.AddrOfPinnedObject();
@@ -284,6 +278,38 @@ namespace FourDO.Emulation
 			}
 		}
 
+		public CDTiming CDTiming
+		{
+			get
+			{
+				return this.cdTiming;
+			}
+			set
+			{
+				// The setting is stored as a number, and the core refuses modes it doesn't have.
+				if (!Enum.IsDefined(typeof(CDTiming), value))
+					value = CDTiming.Turbo;
+				this.cdTiming = value;
+				FreeDOCore.SetCDTiming(value);
+			}
+		}
+
+		/// <summary>
+		/// Where sector traces and boot profiles are kept, one of each per game Id. Null turns
+		/// tracing and preloading off. Takes effect the next time the console starts.
+		/// </summary>
+		public string SectorProfileFolder
+		{
+			get
+			{
+				return this.sectorProfileFolder;
+			}
+			set
+			{
+				this.sectorProfileFolder = value;
+			}
+		}
+
 		public bool RenderHighResolution
 		{
 			get
@@ -446,6 +472,11 @@ namespace FourDO.Emulation
                     ) fixMode = fixMode | (int)FixMode.FIX_BIT_GRAPHICS_STEP_Y;
             }
 			FreeDOCore.SetFixMode(fixMode);
+
+			/////////////////
+			// Pull in what the game read while booting last time, and record it again.
+			this.StartSectorTrace();
+
 			/////////////////
 			// Start the core thread
 			this.InternalResume(false);
@@ -466,7 +497,11 @@ namespace FourDO.Emulation
 			if (this.State == ConsoleState.Running)
 				this.InternalPause();
 
-			// Close the game source.
+			this.StopSectorTrace();
+			FreeDOCore.Destroy();
+
+			// Close the game source. (After the core is gone, since it may be reading the
+			// image the source handed it.)
 			try
 			{
 				this.GameSource.Close();
@@ -474,10 +509,47 @@ namespace FourDO.Emulation
 			catch { } // Might happen, but I don't care. The game source shouldn't have done that.
 
 			// Done!
-			FreeDOCore.Destroy();
 			this.State = ConsoleState.Stopped;
 		}
 
+		private void StartSectorTrace()
+		{
+			this.sectorTraceBaseName = null;
+			if (this.sectorProfileFolder == null || this.GameSource is BiosOnlyGameSource)
+				return;
+
+			string gameId = this.GameSource.GetGameId();
+			if (string.IsNullOrEmpty(gameId))
+				return;
+
+			this.sectorTraceBaseName = Path.Combine(this.sectorProfileFolder, gameId);
+
+			string profileFileName = this.sectorTraceBaseName + SECTOR_PROFILE_EXTENSION;
+			if (File.Exists(profileFileName))
+				FreeDOCore.PreloadSectors(profileFileName);
+
+			FreeDOCore.StartSectorTrace();
+		}
+
+		private void StopSectorTrace()
+		{
+			if (this.sectorTraceBaseName == null)
+				return;
+
+			try
+			{
+				if (!Directory.Exists(this.sectorProfileFolder))
+					Directory.CreateDirectory(this.sectorProfileFolder);
+			}
+			catch { } // The core just won't manage to write the files.
+
+			FreeDOCore.StopSectorTrace(
+				this.sectorTraceBaseName + SECTOR_TRACE_EXTENSION,
+				this.sectorTraceBaseName + SECTOR_PROFILE_EXTENSION,
+				SECTOR_PROFILE_BOOT_SECONDS);
+			this.sectorTraceBaseName = null;
+		}
+
 		public void Pause()
 		{
 			if (this.State != ConsoleState.Running)
@@ -522,10 +594,53 @@ namespace FourDO.Emulation
 			}
 		}
 
-		public void LoadState(string saveStateFileName)
+		/// <summary>
+		/// Returns false if the state could not be loaded; the console then carries on as it was.
+		/// </summary>
+		public bool LoadState(string saveStateFileName)
 		{
 			if (this.State == ConsoleState.Stopped)
-				return;
+				return false;
+
+			bool systemWasRunning = (this.State == ConsoleState.Running);
+			if (systemWasRunning == true)
+				this.InternalPause();
+
+			try
+			{
+				return States.SaveStateHelper.LoadState(saveStateFileName);
+			}
+			finally
+			{
+				if (systemWasRunning == true)
+					this.InternalResume(false);
+			}
+		}
+
+		public byte[] SaveCheckpoint()
+		{
+			if (this.State == ConsoleState.Stopped)
+				return null;
+
+			bool systemWasRunning = (this.State == ConsoleState.Running);
+			if (systemWasRunning)
+				this.InternalPause();
+
+			try
+			{
+				return States.SaveStateHelper.SaveCheckpoint();
+			}
+			finally
+			{
+				if (systemWasRunning == true)
+					this.InternalResume(false);
+			}
+		}
+
+		public bool LoadCheckpoint(byte[] checkpoint)
+		{
+			if (this.State == ConsoleState.Stopped)
+				return false;
 
 			bool systemWasRunning = (this.State == ConsoleState.Running);
 			if (systemWasRunning == true)
@@ -533,7 +648,7 @@ namespace FourDO.Emulation
 
 			try
 			{
-				States.SaveStateHelper.LoadState(saveStateFileName);
+				return States.SaveStateHelper.LoadCheckpoint(checkpoint);
 			}
 			finally
 			{
@@ -627,7 +742,7 @@ namespace FourDO.Emulation
 		private IntPtr ExternalInterface_SwapFrame(IntPtr currentFrame)
 		{
 			// This get signaled in non-multi task mode at the end of each frame.
-			// I'm not entirely certain why.
+			// The core owns the frame buffers; we pick up the finished one with GetPointerFrame.
 
 			this.isSwapFrameSignaled = true;
 			return currentFrame;
@@ -641,6 +756,22 @@ namespace FourDO.Emulation
 				this.audioPlugin.PushSample(dspSample);
 		}
 
+		private int[] pushSamplesBuffer = new int[0];
+		private void ExternalInterface_PushSamples(IntPtr samples, int count)
+		{
+			// The core hands over a whole block at once; the pointer is only valid during this call.
+			lastAudioSampleCount += count;
+			if (this.audioPlugin == null)
+				return;
+
+			if (pushSamplesBuffer.Length < count)
+				pushSamplesBuffer = new int[count];
+			Marshal.Copy(samples, pushSamplesBuffer, 0, count);
+
+			for (int i = 0; i < count; i++)
+				this.audioPlugin.PushSample((uint)pushSamplesBuffer[i]);
+		}
+
 		private int ExternalInterface_GetPbusLength()
 		{
 			// Ask input plugin for Pbus data.
@@ -687,9 +818,6 @@ namespace FourDO.Emulation
 
 			// Done with this frame.
 			this.isSwapFrameSignaled = true;
-			
-			// Use of multi-task mode requires that we ask the core to update our VDL frame for us.
-			FreeDOCore.DoFrameMultitask(this.framePtr);
 		}
 
 		private void ExternalInterface_Read2048(IntPtr buffer)
@@ -762,14 +890,18 @@ namespace FourDO.Emulation
 				do
 				{
 					if (doFreeDOMultitask)
-						FreeDOCore.DoExecuteFrameMultitask(this.framePtr);
+						FreeDOCore.DoExecuteFrameMultitask();
 					else
-						FreeDOCore.DoExecuteFrame(this.framePtr);
+						FreeDOCore.DoExecuteFrame();
 
 					lastFrameCount++;
 				} while (isSwapFrameSignaled == false && lastFrameCount < MAXIMUM_FRAME_COUNT);
 				frameWatch.Stop();
 
+				///////////
+				// Grab the newest finished frame from the core's triple buffer.
+				this.framePtr = FreeDOCore.GetPointerFrame();
+
 				///////////
 				// Signal completion.
 				var doneWatch = new PerformanceStopWatch();
@@ -852,10 +984,16 @@ namespace FourDO.Emulation
 				this.audioPlugin.FrameDone(cheatAmount > 0 ? 0 : currentOvershoot, cheatAmount);
 
 				/////////////
-				// Sleep if we've been instructed to.
+				// Sleep if we've been instructed to. When an audio sink pulls resampled
+				// audio from the core, its device clock paces us instead.
 				var sleepWatch = new PerformanceStopWatch();
 				sleepWatch.Start();
-				if (sleepTime > 0 && !this.stopWorkerSignal)
+				if (FreeDOCore.AudioOutputRate > 0)
+				{
+					if (!this.stopWorkerSignal)
+						FreeDOCore.WaitAudio(0);
+				}
+				else if (sleepTime > 0 && !this.stopWorkerSignal)
 					Thread.Sleep(sleepTime);
 				sleepWatch.Stop();
 				
@@ -1,6 +1,7 @@
 ﻿using System;
 using System.Diagnostics;
 using System.IO;
+using FourDO.Emulation.FreeDO;
 using FourDO.Utilities;
 using FourDO.Utilities.CueSharp;
 
@@ -9,11 +10,14 @@ namespace FourDO.Emulation.GameSource
 	internal class FileGameSource : GameSourceBase
 	{
 		private const string LOG_PREFIX = "GameSource - ";
+		private const string COMPRESSED_EXTENSION = ".4DOZ";
+		private const string INDEX_EXTENSION = ".4doidx";
 
 		private object _accessSemaphore = new object();
 
 		private FourDO.Utilities.CueSharp.DataType imageDataType;
 		private BinaryReader gameRomReader = null;
+		private bool coreDisc = false;
 
 		public FileGameSource(string gameFilePath)
 		{
@@ -28,6 +32,18 @@ namespace FourDO.Emulation.GameSource
 		{
 			try
 			{
+				////////////////////
+				// Let the core map the image and serve its sectors itself. Compressed images
+				// can only be read that way; the others fall back to our own reader below.
+				this.coreDisc = FreeDOCore.OpenDisc(this.GameFilePath);
+				if (this.coreDisc)
+					return;
+
+				if (Path.GetExtension(this.GameFilePath).ToUpper() == COMPRESSED_EXTENSION)
+					throw new IOException("The compressed image could not be opened: " + this.GameFilePath);
+
+				Trace.WriteLine(LOG_PREFIX + "The core could not map the image, so sectors will be read through the game source: " + this.GameFilePath);
+
 				var identifiedFile = false;
 
 				////////////////////
@@ -60,7 +76,7 @@ namespace FourDO.Emulation.GameSource
 							string fileToOpen = Path.Combine(Path.GetDirectoryName(this.GameFilePath), track.DataFile.Filename);
 							try
 							{
-								this.gameRomReader = new BinaryReader(new FileStream(fileToOpen, FileMode.Open));
+								this.gameRomReader = new BinaryReader(new FileStream(fileToOpen, FileMode.Open, FileAccess.Read, FileShare.Read));
 								this.imageDataType = track.TrackDataType;
 								identifiedFile = true;
 							}
@@ -127,7 +143,8 @@ namespace FourDO.Emulation.GameSource
 
 					/////////////////////
 					// Open the game.
-					this.gameRomReader = new BinaryReader(new FileStream(this.GameFilePath, FileMode.Open));
+					// (Read only, and sharing reads, since the core has the image open as well.)
+					this.gameRomReader = new BinaryReader(new FileStream(this.GameFilePath, FileMode.Open, FileAccess.Read, FileShare.Read));
 				}
 			}
 			catch
@@ -141,12 +158,22 @@ namespace FourDO.Emulation.GameSource
 		{
 			if (this.gameRomReader != null)
 				this.gameRomReader.Close();
+
+			if (this.coreDisc)
+				FreeDOCore.CloseDisc();
+			this.coreDisc = false;
 		}
 
 		protected override void OnReadSector(IntPtr destinationBuffer, int sectorNumber)
 		{
 			lock (_accessSemaphore)
 			{
+				if (this.coreDisc)
+				{
+					FreeDOCore.ReadDiscSector(destinationBuffer, sectorNumber);
+					return;
+				}
+
 				if (this.gameRomReader == null)
 					return; // No game loaded.
 
@@ -170,5 +197,10 @@ namespace FourDO.Emulation.GameSource
 		}
 
 		#endregion // IGameSource Implementation
+
+		protected override string GetIndexCachePath()
+		{
+			return this.GameFilePath + INDEX_EXTENSION;
+		}
 	}
 }
@@ -1,4 +1,6 @@
 ﻿using System;
+using FourDO.FileSystem;
+using FourDO.UI.DiscBrowser;
 
 namespace FourDO.Emulation.GameSource
 {
@@ -10,6 +12,7 @@ namespace FourDO.Emulation.GameSource
 		private int sectorCount = 0;
 		private string gameId = null;
 		private string gameName = null;
+		private FileSystemIndex fileSystemIndex = null;
 
 		private bool isOpen = false;
 
@@ -37,6 +40,7 @@ namespace FourDO.Emulation.GameSource
 			if (this.isOpen)
 			{
 				this.isOpen = false;
+				this.fileSystemIndex = null;
 
 				this.OnClose();
 			}
@@ -74,6 +78,24 @@ namespace FourDO.Emulation.GameSource
 				return null;
 		}
 
+		/// <summary>
+		/// Where the disc's file system index is kept between runs, or null to not keep it.
+		/// </summary>
+		protected virtual string GetIndexCachePath() { return null; }
+
+		/// <summary>
+		/// Gets an index of every file on the disc, building it on first use.
+		/// </summary>
+		public FileSystemIndex GetFileSystemIndex()
+		{
+			if (!this.isOpen)
+				return null;
+
+			if (this.fileSystemIndex == null)
+				this.fileSystemIndex = FileSystemIndex.LoadOrBuild(new DiscFileReader(this), this.GetIndexCachePath());
+			return this.fileSystemIndex;
+		}
+
 		private unsafe void ReadSectorCount()
 		{
 			var sectorZero = new byte[2048];
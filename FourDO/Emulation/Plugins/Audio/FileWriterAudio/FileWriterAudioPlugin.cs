@@ -1,10 +1,6 @@
 ﻿using System.IO;
-using System.Text;
-using SlimDX.DirectSound;
-using System;
-using System.Diagnostics;
 using System.Windows.Forms;
-using PerformanceCounter = FourDO.Utilities.PerformanceCounter;
+using FourDO.Emulation.FreeDO;
 
 namespace FourDO.Emulation.Plugins.Audio.FileWriterAudio
 {
@@ -41,15 +37,9 @@ namespace FourDO.Emulation.Plugins.Audio.FileWriterAudio
 		{
 		}
 
-		private const int TEMP_BUFFER_SIZE = 525; // in samples
-		private int _currentTempBufferPosition = 0;
-		private byte[] _tempBuffer = new byte[TEMP_BUFFER_SIZE * 4];
-
-		private BinaryWriter _writer;
-
+		// The core records the samples itself, from its own writer thread.
 		public void PushSample(uint dspSample)
 		{
-			this.InternalPushSample(dspSample);
 		}
 
 		public void Destroy()
@@ -58,16 +48,13 @@ namespace FourDO.Emulation.Plugins.Audio.FileWriterAudio
 
 		public void Start()
 		{
-			_currentTempBufferPosition = 0;
-
-			var path = GetOutputFileName();
-
-			_writer = new BinaryWriter(new FileStream(path, FileMode.OpenOrCreate | FileMode.Append));
+			// Resuming keeps the running recording; the core closes it when the game stops.
+			FreeDOCore.StartAudioCapture(GetOutputFileName());
 		}
 
 		public void Stop()
 		{
-			_writer.Close();
+			// Nothing to do, the core gets no samples while paused.
 		}
 
 		public void FrameDone(long currentOvershoot, long adjustmentPosted)
@@ -80,30 +67,8 @@ namespace FourDO.Emulation.Plugins.Audio.FileWriterAudio
 		{
 			var path = Application.ExecutablePath;
 			path = Path.GetDirectoryName(path);
-			path = Path.Combine(path, "Temp\\AudioOutput.raw");
+			path = Path.Combine(path, "Temp\\AudioOutput.wav");
 			return path;
 		}
-
-		private void InternalPushSample(uint dspSample)
-		{
-			int bytePos = _currentTempBufferPosition * 4;
-			_tempBuffer[bytePos] = (byte)(dspSample >> 24);
-			_tempBuffer[bytePos + 1] = (byte)(dspSample >> 16);
-			_tempBuffer[bytePos + 2] = (byte)(dspSample >> 8);
-			_tempBuffer[bytePos + 3] = (byte)(dspSample);
-
-			_currentTempBufferPosition++;
-			if (_currentTempBufferPosition == TEMP_BUFFER_SIZE)
-			{
-				_currentTempBufferPosition = 0;
-
-				this.PushTempBlock();
-			}
-		}
-
-		private void PushTempBlock()
-		{
-			_writer.Write(_tempBuffer);
-		}
 	}
 }
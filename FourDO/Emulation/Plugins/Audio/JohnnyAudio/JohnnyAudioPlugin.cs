@@ -1,7 +1,9 @@
 ﻿using SlimDX.DirectSound;
 using System;
 using System.Diagnostics;
+using System.Threading;
 using System.Windows.Forms;
+using FourDO.Emulation.FreeDO;
 using PerformanceCounter = FourDO.Utilities.PerformanceCounter;
 
 namespace FourDO.Emulation.Plugins.Audio.JohnnyAudio
@@ -97,8 +99,23 @@ namespace FourDO.Emulation.Plugins.Audio.JohnnyAudio
 
 		private uint[] emptyBuffer;
 
+		////////////////////
+		// Unless --ForcePushAudio is given, a feeder thread pulls resampled audio out of the core
+		// and keeps the play buffer BufferMilliseconds ahead of the play cursor. The emulation
+		// thread waits on the core for the feeder to drain it, so the sound card's clock paces
+		// the emulation, and pushed samples and frame schedules are ignored.
+		private const int FEEDER_SLEEP_MILLISECONDS = 5;
+		private const int PULL_BUFFER_SIZE = 4410;
+		private uint[] pullBuffer = new uint[PULL_BUFFER_SIZE];
+		private bool pullFromCore;
+		private Thread feederThread;
+		private volatile bool stopFeeder;
+
 		public void PushSample(uint dspSample)
 		{
+			if (this.pullFromCore)
+				return;
+
 			this.InternalPushSample(dspSample);
 		}
 
@@ -120,6 +137,9 @@ namespace FourDO.Emulation.Plugins.Audio.JohnnyAudio
 
 		public void FrameDone(long currentOvershoot, long adjustmentPosted)
 		{
+			if (this.pullFromCore)
+				return;
+
 			this.InternalFrameDone(currentOvershoot, adjustmentPosted);
 		}
 
@@ -130,15 +150,80 @@ namespace FourDO.Emulation.Plugins.Audio.JohnnyAudio
 			this.Initialize();
 
 			this.scheduleAccepted = false;
+			this.pullFromCore = !FourDO.Utilities.Globals.RunOptions.ForcePushAudio;
+			if (this.pullFromCore)
+			{
+				FreeDOCore.SetAudioOutputRate(this.bufferFormat.SamplesPerSecond);
+				this.ResetWritePosition();
+
+				this.stopFeeder = false;
+				this.feederThread = new Thread(new ThreadStart(this.FeederThread));
+				this.feederThread.Priority = ThreadPriority.AboveNormal;
+				this.feederThread.IsBackground = true;
+				this.feederThread.Start();
+			}
 			this.playBuffer.Play(0, PlayFlags.Looping);
 		}
 
 		private void InternalStop()
 		{
+			// The feeder has to be gone before the output is turned off (and before the core is
+			// destroyed, which the console only does after stopping us).
+			if (this.feederThread != null)
+			{
+				this.stopFeeder = true;
+				this.feederThread.Join();
+				this.feederThread = null;
+				FreeDOCore.SetAudioOutputRate(0);
+			}
+
 			this.playBuffer.Stop();
 			this.playBuffer.Write<uint>(this.emptyBuffer, 0, LockFlags.None);
 		}
 
+		private void FeederThread()
+		{
+			while (!this.stopFeeder)
+			{
+				int playPosition = this.playBuffer.CurrentPlayPosition;
+				int ahead = this.GetRealPositionDiff(this.currentWritePosition, playPosition);
+				if (ahead > this.buffer_max_offset)
+				{
+					// The play cursor got past everything we wrote (or we're too far ahead). Start over.
+					if (FourDO.Utilities.Globals.RunOptions.LogAudioDebug)
+						Trace.WriteLine(LOG_PREFIX + "Resetting:Play cursor outside the pulled audio");
+					this.ResetWritePosition();
+					ahead = this.buffer_base_offset;
+				}
+
+				int wanted = (this.buffer_base_offset - ahead) / this.bufferFormat.BlockAlignment;
+				if (wanted > 0)
+				{
+					int read = FreeDOCore.ReadAudio(this.pullBuffer, Math.Min(wanted, PULL_BUFFER_SIZE));
+					if (read > 0)
+						this.WritePulledSamples(read);
+				}
+
+				Thread.Sleep(FEEDER_SLEEP_MILLISECONDS);
+			}
+		}
+
+		private void WritePulledSamples(int count)
+		{
+			int copySize = count * sizeof(uint);
+			if (this.currentWritePosition + copySize > bufferDescription.SizeInBytes)
+			{
+				int firstWriteSize = (bufferDescription.SizeInBytes - this.currentWritePosition);
+				playBuffer.Write<uint>(this.pullBuffer, 0, firstWriteSize / sizeof(uint), this.currentWritePosition, LockFlags.None);
+				playBuffer.Write<uint>(this.pullBuffer, firstWriteSize / sizeof(uint), (copySize - firstWriteSize) / sizeof(uint), 0, LockFlags.None);
+			}
+			else
+			{
+				playBuffer.Write<uint>(this.pullBuffer, 0, count, this.currentWritePosition, LockFlags.None);
+			}
+			this.currentWritePosition = this.AddToPosition(this.currentWritePosition, copySize);
+		}
+
 		private void Initialize()
 		{
 			if (this.initialized)
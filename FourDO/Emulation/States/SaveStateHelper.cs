@@ -7,6 +7,77 @@ namespace FourDO.Emulation.States
 {
 	internal static class SaveStateHelper
 	{
+		// Reused by every save, rather than allocating several megabytes each time.
+		private static byte[] saveData;
+
+		private static byte[] GetSaveBuffer()
+		{
+			return GetSaveBuffer(0);
+		}
+
+		/// <summary>
+		/// States from before the BIOS was left out of them are larger than GetSaveSize, so loading
+		/// asks for room for the whole file.
+		/// </summary>
+		private static byte[] GetSaveBuffer(long minimumSize)
+		{
+			long saveSize = Math.Max(FreeDOCore.GetSaveSize(), minimumSize);
+			if (saveData == null || saveData.Length < saveSize)
+				saveData = new byte[saveSize];
+			return saveData;
+		}
+
+		/// <summary>
+		/// Takes an in-memory checkpoint holding only what changed since the checkpoint base
+		/// (taken on the first call, or by ResetCheckpointBase). Checkpoints stay loadable until
+		/// the base is reset or the console stops.
+		/// </summary>
+		public static byte[] SaveCheckpoint()
+		{
+			byte[] buffer = GetSaveBuffer();
+			int length;
+			unsafe
+			{
+				fixed (byte* saveDataPtr = buffer)
+				{
+					var pointer = new IntPtr(saveDataPtr);
+					length = FreeDOCore.DoSaveIncremental(pointer);
+					if (length == 0)
+					{
+						FreeDOCore.SetSaveBase();
+						length = FreeDOCore.DoSaveIncremental(pointer);
+					}
+				}
+			}
+
+			var checkpoint = new byte[length];
+			Buffer.BlockCopy(buffer, 0, checkpoint, 0, length);
+			return checkpoint;
+		}
+
+		/// <summary>
+		/// Returns false if the checkpoint was taken against an older base.
+		/// </summary>
+		public static bool LoadCheckpoint(byte[] checkpoint)
+		{
+			unsafe
+			{
+				fixed (byte* checkpointPtr = checkpoint)
+				{
+					return FreeDOCore.DoLoad(new IntPtr(checkpointPtr), checkpoint.Length);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Starts a new checkpoint base from the current state. Checkpoints grow with everything
+		/// changed since their base, so a fresh base keeps them small; older ones become unusable.
+		/// </summary>
+		public static void ResetCheckpointBase()
+		{
+			FreeDOCore.SetSaveBase();
+		}
+
 		public static void SaveState(string fileName)
 		{
 			BinaryWriter binaryWriter = null;
@@ -24,16 +95,17 @@ namespace FourDO.Emulation.States
 				//////////////////////////////////
 				// Save binary data from core emulation.
 				binaryWriter = new BinaryWriter(new FileStream(fileName, FileMode.Create));
-				var saveData = new byte[FreeDOCore.GetSaveSize()];
+				var saveData = GetSaveBuffer();
+				int length;
 				unsafe
 				{
 					fixed (byte* saveDataPtr = saveData)
 					{
 						var pointer = new IntPtr(saveDataPtr);
-						FreeDOCore.DoSave(pointer);
+						length = FreeDOCore.DoSave(pointer);
 					}
 				}
-				binaryWriter.Write(saveData);
+				binaryWriter.Write(saveData, 0, length);
 				binaryWriter.Close();
 			}
 			finally
@@ -43,19 +115,27 @@ namespace FourDO.Emulation.States
 			}
 		}
 
-		public static void LoadState(string fileName)
+		/// <summary>
+		/// Returns false if the core refused the state (see FreeDOCore.DoLoad).
+		/// </summary>
+		public static bool LoadState(string fileName)
 		{
+			bool loaded;
 			BinaryReader reader = null;
 			try
 			{
 				reader = new BinaryReader(new FileStream(fileName, FileMode.Open));
-				var saveData = reader.ReadBytes((int)FreeDOCore.GetSaveSize());
+				var saveData = GetSaveBuffer(reader.BaseStream.Length);
+				int totalRead = 0, bytesRead;
+				while (totalRead < saveData.Length && (bytesRead = reader.Read(saveData, totalRead, saveData.Length - totalRead)) > 0)
+					totalRead += bytesRead;
 				unsafe
 				{
 					fixed (byte* saveDataPtr = saveData)
 					{
 						var pointer = new IntPtr(saveDataPtr);
-						FreeDOCore.DoLoad(pointer);
+						// Only what was read now; the rest of the reused buffer is an older state.
+						loaded = FreeDOCore.DoLoad(pointer, totalRead);
 					}
 				}
 				reader.Close();
@@ -65,6 +145,7 @@ namespace FourDO.Emulation.States
 				if (reader != null)
 					reader.Close();
 			}
+			return loaded;
 		}
 	}
 }
@@ -210,6 +210,9 @@ namespace FourDO
 			if (arguments["ForceGDIRendering"] != null)
 				RunOptions.ForceGdiRendering = true;
 
+			if (arguments["ForcePushAudio"] != null)
+				RunOptions.ForcePushAudio = true;
+
 			if (arguments["printKPrint"] != null)
 				RunOptions.PrintKPrint = true;
 
@@ -224,9 +227,11 @@ namespace FourDO
 				Console.WriteLine("  -StartLoadFile [filename] : Loads a game from file.");
 				Console.WriteLine("  -StartLoadDrive [letter]  : Loads from CD of the drive letter.");
 				Console.WriteLine("  --StartFullScreen         : Start Full Screen.");
+				Console.WriteLine("  -CompressImage [filename] : Writes the image as a compressed .4doz and quits.");
 				Console.WriteLine("");
 				Console.WriteLine("  --PrintKPrint        : Prints KPRINT (3DO debug) output to console.");
 				Console.WriteLine("  --ForceGDIRendering  : Forces GDI Rendering rather than DirectX.");
+				Console.WriteLine("  --ForcePushAudio     : Times emulation with the CPU clock, not the sound card.");
 				Console.WriteLine("  --DebugStartupPaused : Start 4do in a paused state.");
 				Console.WriteLine("______________________________________________________________________");
 				Console.WriteLine("");
@@ -253,6 +258,25 @@ namespace FourDO
 				return false;
 			}
 
+			var compressImage = arguments["CompressImage"];
+			if (compressImage != null)
+			{
+				string targetFile = Path.ChangeExtension(compressImage, ".4doz");
+				Console.WriteLine("Compressing " + compressImage + " to " + targetFile + "...");
+				if (FourDO.Emulation.FreeDO.FreeDOCore.CompressDisc(compressImage, targetFile))
+				{
+					Console.WriteLine("Done: " + new FileInfo(compressImage).Length + " -> " + new FileInfo(targetFile).Length + " bytes.");
+				}
+				else
+				{
+					Console.WriteLine(USAGE_ERROR + "The image could not be read, or the compressed image could not be written.");
+				}
+
+				PrintFakeDosPrompt();
+
+				return false;
+			}
+
 			return true;
 		}
 
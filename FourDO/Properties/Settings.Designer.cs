@@ -441,5 +441,19 @@ namespace FourDO.Properties {
                 this["WindowScalingAlgorithm"] = value;
             }
         }
+        
+        [global::System.Configuration.UserScopedSettingAttribute()]
+        [global::System.Configuration.SettingsProviderAttribute(typeof(FourDO.UI.PortableSettingsProvider))]
+        [global::System.Diagnostics.DebuggerNonUserCodeAttribute()]
+        [global::System.Configuration.DefaultSettingValueAttribute("0")]
+        [global::System.Configuration.SettingsManageabilityAttribute(global::System.Configuration.SettingsManageability.Roaming)]
+        public int CDTiming {
+            get {
+                return ((int)(this["CDTiming"]));
+            }
+            set {
+                this["CDTiming"] = value;
+            }
+        }
     }
 }
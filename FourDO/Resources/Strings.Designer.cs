@@ -348,6 +348,15 @@ namespace FourDO.Resources {
             }
         }
         
+        /// <summary>
+        ///   Ищет локализованную строку, похожую на The save state ({0}) could not be loaded. It may be damaged, or it was saved with a different BIOS..
+        /// </summary>
+        internal static string MainErrorLoadState {
+            get {
+                return ResourceManager.GetString("MainErrorLoadState", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Ищет локализованную строку, похожую на &amp;Audio.
         /// </summary>
@@ -510,6 +519,15 @@ namespace FourDO.Resources {
             }
         }
         
+        /// <summary>
+        ///   Ищет локализованную строку, похожую на Bilinear 2x.
+        /// </summary>
+        internal static string MainMenuDisplayScalingBilinear2x {
+            get {
+                return ResourceManager.GetString("MainMenuDisplayScalingBilinear2x", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Ищет локализованную строку, похожую на Double Resolution Rendering.
         /// </summary>
@@ -546,6 +564,15 @@ namespace FourDO.Resources {
             }
         }
         
+        /// <summary>
+        ///   Ищет локализованную строку, похожую на Nearest Neighbor 2x.
+        /// </summary>
+        internal static string MainMenuDisplayScalingNearest2x {
+            get {
+                return ResourceManager.GetString("MainMenuDisplayScalingNearest2x", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Ищет локализованную строку, похожую на None.
         /// </summary>
@@ -555,6 +582,15 @@ namespace FourDO.Resources {
             }
         }
         
+        /// <summary>
+        ///   Ищет локализованную строку, похожую на xBR 2x.
+        /// </summary>
+        internal static string MainMenuDisplayScalingXbr2x {
+            get {
+                return ResourceManager.GetString("MainMenuDisplayScalingXbr2x", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Ищет локализованную строку, похожую на &amp;Smooth Image Resizing.
         /// </summary>
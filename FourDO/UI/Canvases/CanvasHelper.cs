@@ -52,7 +52,10 @@ namespace FourDO.UI.Canvases
             if (highResolution)
                 sizeMultiplier *= 2;
 
-            if (algorithm == ScalingAlgorithm.Hq2X)
+            if (algorithm == ScalingAlgorithm.Hq2X
+                || algorithm == ScalingAlgorithm.Nearest2X
+                || algorithm == ScalingAlgorithm.Bilinear2X
+                || algorithm == ScalingAlgorithm.Xbr2X)
                 sizeMultiplier *= 2;
             else if (algorithm == ScalingAlgorithm.Hq3X)
                 sizeMultiplier *= 3;
@@ -375,12 +375,13 @@ namespace FourDO.UI.DX
 			for (int line = 0; line < bitmapHeight; line++)
 			{
 				VDLLine* linePtr = (VDLLine*)&(framePtr->lines[sizeof(VDLLine) * line]);
+				VDLClut* clutPtr = (VDLClut*)&(framePtr->cluts[sizeof(VDLClut) * linePtr->xCLUTSET]);
 				short* srcPtr = (short*)linePtr;
 				for (int pix = 0; pix < bitmapWidth; pix++)
 				{
-					*destPtr++ = (byte)(linePtr->xCLUTG[(*srcPtr) & 0x1F]);
-					*destPtr++ = linePtr->xCLUTG[((*srcPtr) >> 5) & 0x1F];
-					*destPtr++ = linePtr->xCLUTR[(*srcPtr) >> 10 & 0x1F];
+					*destPtr++ = (byte)(clutPtr->xCLUTG[(*srcPtr) & 0x1F]);
+					*destPtr++ = clutPtr->xCLUTG[((*srcPtr) >> 5) & 0x1F];
+					*destPtr++ = clutPtr->xCLUTR[(*srcPtr) >> 10 & 0x1F];
 					destPtr++;
 					srcPtr++;
 				}
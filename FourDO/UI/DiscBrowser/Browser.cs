@@ -35,7 +35,11 @@ namespace FourDO.UI.DiscBrowser
 			}
 
 			_fileReader = new DiscFileReader(GameSource);
-			_fileSystem = new FileSystem.FileSystem(_fileReader);
+
+			// Browse from the disc's index when it has one, so directories are not read again.
+			var indexedSource = GameSource as GameSourceBase;
+			var index = (indexedSource != null) ? indexedSource.GetFileSystemIndex() : null;
+			_fileSystem = new FileSystem.FileSystem(_fileReader, index);
 
 			_extractPath = System.IO.Directory.GetCurrentDirectory();
 
@@ -88,6 +88,9 @@ namespace FourDO.UI
             this.scalingModeHq2xMenuItem = new System.Windows.Forms.ToolStripMenuItem();
             this.scalingModeHq3xMenuItem = new System.Windows.Forms.ToolStripMenuItem();
             this.scalingModeHq4xMenuItem = new System.Windows.Forms.ToolStripMenuItem();
+            this.scalingModeNearest2xMenuItem = new System.Windows.Forms.ToolStripMenuItem();
+            this.scalingModeBilinear2xMenuItem = new System.Windows.Forms.ToolStripMenuItem();
+            this.scalingModeXbr2xMenuItem = new System.Windows.Forms.ToolStripMenuItem();
             this.audioMenuItem = new System.Windows.Forms.ToolStripMenuItem();
             this.optionsMenuItem = new System.Windows.Forms.ToolStripMenuItem();
             this.settingsMenuItem = new System.Windows.Forms.ToolStripMenuItem();
@@ -536,7 +539,10 @@ namespace FourDO.UI
             this.scalingModeDoubleResMenuItem,
             this.scalingModeHq2xMenuItem,
             this.scalingModeHq3xMenuItem,
-            this.scalingModeHq4xMenuItem});
+            this.scalingModeHq4xMenuItem,
+            this.scalingModeNearest2xMenuItem,
+            this.scalingModeBilinear2xMenuItem,
+            this.scalingModeXbr2xMenuItem});
             this.scalingModeMenuItem.Name = "scalingModeMenuItem";
             this.scalingModeMenuItem.Size = new System.Drawing.Size(240, 22);
             this.scalingModeMenuItem.Text = "Sca&ling Mode";
@@ -576,6 +582,27 @@ namespace FourDO.UI
             this.scalingModeHq4xMenuItem.Text = "HQ4X";
             this.scalingModeHq4xMenuItem.Click += new System.EventHandler(this.scalingModeHq4xMenuItem_Click);
             // 
+            // scalingModeNearest2xMenuItem
+            // 
+            this.scalingModeNearest2xMenuItem.Name = "scalingModeNearest2xMenuItem";
+            this.scalingModeNearest2xMenuItem.Size = new System.Drawing.Size(228, 22);
+            this.scalingModeNearest2xMenuItem.Text = "Nearest Neighbor 2x";
+            this.scalingModeNearest2xMenuItem.Click += new System.EventHandler(this.scalingModeNearest2xMenuItem_Click);
+            // 
+            // scalingModeBilinear2xMenuItem
+            // 
+            this.scalingModeBilinear2xMenuItem.Name = "scalingModeBilinear2xMenuItem";
+            this.scalingModeBilinear2xMenuItem.Size = new System.Drawing.Size(228, 22);
+            this.scalingModeBilinear2xMenuItem.Text = "Bilinear 2x";
+            this.scalingModeBilinear2xMenuItem.Click += new System.EventHandler(this.scalingModeBilinear2xMenuItem_Click);
+            // 
+            // scalingModeXbr2xMenuItem
+            // 
+            this.scalingModeXbr2xMenuItem.Name = "scalingModeXbr2xMenuItem";
+            this.scalingModeXbr2xMenuItem.Size = new System.Drawing.Size(228, 22);
+            this.scalingModeXbr2xMenuItem.Text = "xBR 2x";
+            this.scalingModeXbr2xMenuItem.Click += new System.EventHandler(this.scalingModeXbr2xMenuItem_Click);
+            // 
             // audioMenuItem
             // 
             this.audioMenuItem.Name = "audioMenuItem";
@@ -851,6 +878,9 @@ namespace FourDO.UI
 		private System.Windows.Forms.ToolStripMenuItem scalingModeHq2xMenuItem;
 		private System.Windows.Forms.ToolStripMenuItem scalingModeHq3xMenuItem;
 		private System.Windows.Forms.ToolStripMenuItem scalingModeHq4xMenuItem;
+		private System.Windows.Forms.ToolStripMenuItem scalingModeNearest2xMenuItem;
+		private System.Windows.Forms.ToolStripMenuItem scalingModeBilinear2xMenuItem;
+		private System.Windows.Forms.ToolStripMenuItem scalingModeXbr2xMenuItem;
 		private System.Windows.Forms.ToolStripSeparator toolStripSeparator16;
 		private System.Windows.Forms.ToolStripStatusLabel toolStripStatusLabel1;
 		private System.Windows.Forms.Timer checkInputTimer;
@@ -78,6 +78,9 @@ namespace FourDO.UI
 			this.scalingModeHq2xMenuItem.Text = Strings.MainMenuDisplayScalingHq2x;
 			this.scalingModeHq3xMenuItem.Text = Strings.MainMenuDisplayScalingHq3x;
 			this.scalingModeHq4xMenuItem.Text = Strings.MainMenuDisplayScalingHq4x;
+			this.scalingModeNearest2xMenuItem.Text = Strings.MainMenuDisplayScalingNearest2x;
+			this.scalingModeBilinear2xMenuItem.Text = Strings.MainMenuDisplayScalingBilinear2x;
+			this.scalingModeXbr2xMenuItem.Text = Strings.MainMenuDisplayScalingXbr2x;
 
 			this.audioMenuItem.Text = Strings.MainMenuAudio;
 
@@ -311,6 +311,9 @@ namespace FourDO.UI
 			if (e.PropertyName == Utilities.Reflection.GetPropertyName(() => Properties.Settings.Default.CpuClockHertz))
 				GameConsole.Instance.CpuClockHertz = Properties.Settings.Default.CpuClockHertz;
 
+			if (e.PropertyName == Utilities.Reflection.GetPropertyName(() => Properties.Settings.Default.CDTiming))
+				GameConsole.Instance.CDTiming = (CDTiming)Properties.Settings.Default.CDTiming;
+
 			if (e.PropertyName == Utilities.Reflection.GetPropertyName(() => Properties.Settings.Default.WindowScalingAlgorithm))
 				this.gameCanvas.ScalingAlgorithm = (ScalingAlgorithm)Properties.Settings.Default.WindowScalingAlgorithm;
 
@@ -522,6 +525,21 @@ namespace FourDO.UI
 			this.DoSetScalingMode(ScalingAlgorithm.Hq4X , false);
 		}
 
+		private void scalingModeNearest2xMenuItem_Click(object sender, EventArgs e)
+		{
+			this.DoSetScalingMode(ScalingAlgorithm.Nearest2X, false);
+		}
+
+		private void scalingModeBilinear2xMenuItem_Click(object sender, EventArgs e)
+		{
+			this.DoSetScalingMode(ScalingAlgorithm.Bilinear2X, false);
+		}
+
+		private void scalingModeXbr2xMenuItem_Click(object sender, EventArgs e)
+		{
+			this.DoSetScalingMode(ScalingAlgorithm.Xbr2X, false);
+		}
+
         private void autoCropMenuItem_Click(object sender, EventArgs e)
         {
             this.DoToggleAutoCrop();
@@ -853,6 +871,12 @@ namespace FourDO.UI
 				currentAlgorithmItem = this.scalingModeHq3xMenuItem;
 			else if (Properties.Settings.Default.WindowScalingAlgorithm == (int)ScalingAlgorithm.Hq2X)
 				currentAlgorithmItem = this.scalingModeHq2xMenuItem;
+			else if (Properties.Settings.Default.WindowScalingAlgorithm == (int)ScalingAlgorithm.Nearest2X)
+				currentAlgorithmItem = this.scalingModeNearest2xMenuItem;
+			else if (Properties.Settings.Default.WindowScalingAlgorithm == (int)ScalingAlgorithm.Bilinear2X)
+				currentAlgorithmItem = this.scalingModeBilinear2xMenuItem;
+			else if (Properties.Settings.Default.WindowScalingAlgorithm == (int)ScalingAlgorithm.Xbr2X)
+				currentAlgorithmItem = this.scalingModeXbr2xMenuItem;
 			else
 				currentAlgorithmItem = this.scalingModeNoneMenuItem;
 
@@ -959,6 +983,8 @@ namespace FourDO.UI
 			// Set required settings.
 			GameConsole.Instance.AudioBufferMilliseconds = Properties.Settings.Default.AudioBufferMilliseconds;
 			GameConsole.Instance.CpuClockHertz = Properties.Settings.Default.CpuClockHertz;
+			GameConsole.Instance.CDTiming = (CDTiming)Properties.Settings.Default.CDTiming;
+			GameConsole.Instance.SectorProfileFolder = SaveHelper.GetSectorProfileFolder();
 			GameConsole.Instance.RenderHighResolution = Properties.Settings.Default.RenderHighResolution;
 			gameCanvas.RenderHighResolution = Properties.Settings.Default.RenderHighResolution;
 			gameCanvas.ScalingAlgorithm = (ScalingAlgorithm)Properties.Settings.Default.WindowScalingAlgorithm;
@@ -1174,7 +1200,7 @@ namespace FourDO.UI
 			{
 				openDialog.InitialDirectory = this.GetLastRomDirectory();
 				openDialog.Filter =
-					Strings.MainMessageCDImageFiles + " (*.iso, *.bin, *.cue)|*.iso;*.bin;*.cue|" +
+					Strings.MainMessageCDImageFiles + " (*.iso, *.bin, *.cue, *.4doz)|*.iso;*.bin;*.cue;*.4doz|" +
 					Strings.MainMessageAllFiles + " (*.*)|*.*";
 				openDialog.RestoreDirectory = true;
 
@@ -1238,7 +1264,10 @@ namespace FourDO.UI
 			{
 				string saveStateFileName = SaveHelper.GetSaveStateFileName(GameConsole.Instance.GameSource, Properties.Settings.Default.SaveStateSlot);
 				if (System.IO.File.Exists(saveStateFileName))
-					GameConsole.Instance.LoadState(saveStateFileName);
+				{
+					if (!GameConsole.Instance.LoadState(saveStateFileName))
+						FourDO.UI.Error.ShowError(string.Format(Strings.MainErrorLoadState, saveStateFileName));
+				}
 			}
 		}
 
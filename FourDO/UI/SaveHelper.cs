@@ -13,6 +13,8 @@ namespace FourDO.UI
 
 		private const string SCREENSHOT_SUBFOLDER = "Screenshots";
 
+		private const string SECTOR_PROFILE_SUBFOLDER = "SectorProfiles";
+
 		private const int MAXIMUM_FRIENDLY_NAME_LENGTH = 32;
 
 		public static string GetSaveStateFileName(IGameSource gameSource, int saveStateSlot)
@@ -77,6 +79,12 @@ namespace FourDO.UI
 			return Path.Combine(Path.Combine(appFolder, SAVE_SUBFOLDER), "NVRAM_SaveData.ram");
 		}
 
+		public static string GetSectorProfileFolder()
+		{
+			string appFolder = Path.GetDirectoryName(Application.ExecutablePath);
+			return Path.Combine(Path.Combine(appFolder, SAVE_SUBFOLDER), SECTOR_PROFILE_SUBFOLDER);
+		}
+
 		public static string GetScreenshotFilePath(IGameSource gameSource)
 		{
 			string gameName = null;
@@ -0,0 +1,92 @@
+#include <string.h>
+#include <emmintrin.h>
+#include "scalers.h"
+
+// Per-byte average, rounding up (same result as _mm_avg_epu8).
+static inline uint32_t avg32(uint32_t a, uint32_t b)
+{
+	return (a | b) - (((a ^ b) >> 1) & 0x7F7F7F7F);
+}
+
+void nearest2x_32( uint32_t * src, uint32_t * dest, int width, int height )
+{
+	bool sse2 = cpuHasSSE2();
+	int destWidth = width * 2;
+
+	for (int y = 0; y < height; y++)
+	{
+		uint32_t* srcRow = src + y * width;
+		uint32_t* destRow = dest + y * 2 * destWidth;
+
+		int x = 0;
+		if (sse2)
+		{
+			for (; x + 4 <= width; x += 4)
+			{
+				__m128i p = _mm_loadu_si128((__m128i*)(srcRow + x));
+				_mm_storeu_si128((__m128i*)(destRow + x * 2), _mm_unpacklo_epi32(p, p));
+				_mm_storeu_si128((__m128i*)(destRow + x * 2 + 4), _mm_unpackhi_epi32(p, p));
+			}
+		}
+		for (; x < width; x++)
+		{
+			destRow[x * 2] = srcRow[x];
+			destRow[x * 2 + 1] = srcRow[x];
+		}
+
+		memcpy(destRow + destWidth, destRow, destWidth * sizeof(uint32_t));
+	}
+}
+
+// Output pixels sit on the source grid and half way between source pixels:
+//   a   ab
+//   ac  abcd
+void bilinear2x_32( uint32_t * src, uint32_t * dest, int width, int height )
+{
+	bool sse2 = cpuHasSSE2();
+	int destWidth = width * 2;
+
+	for (int y = 0; y < height; y++)
+	{
+		uint32_t* row = src + y * width;
+		uint32_t* below = (y + 1 < height) ? row + width : row;
+		uint32_t* top = dest + y * 2 * destWidth;
+		uint32_t* bottom = top + destWidth;
+
+		int x = 0;
+		if (sse2)
+		{
+			// Leave the last column to the scalar loop so x+1 never runs off the row.
+			for (; x + 5 <= width; x += 4)
+			{
+				__m128i a = _mm_loadu_si128((__m128i*)(row + x));
+				__m128i b = _mm_loadu_si128((__m128i*)(row + x + 1));
+				__m128i c = _mm_loadu_si128((__m128i*)(below + x));
+				__m128i d = _mm_loadu_si128((__m128i*)(below + x + 1));
+
+				__m128i ab = _mm_avg_epu8(a, b);
+				__m128i ac = _mm_avg_epu8(a, c);
+				__m128i abcd = _mm_avg_epu8(ab, _mm_avg_epu8(c, d));
+
+				_mm_storeu_si128((__m128i*)(top + x * 2), _mm_unpacklo_epi32(a, ab));
+				_mm_storeu_si128((__m128i*)(top + x * 2 + 4), _mm_unpackhi_epi32(a, ab));
+				_mm_storeu_si128((__m128i*)(bottom + x * 2), _mm_unpacklo_epi32(ac, abcd));
+				_mm_storeu_si128((__m128i*)(bottom + x * 2 + 4), _mm_unpackhi_epi32(ac, abcd));
+			}
+		}
+		for (; x < width; x++)
+		{
+			int right = (x + 1 < width) ? x + 1 : x;
+			uint32_t a = row[x];
+			uint32_t b = row[right];
+			uint32_t c = below[x];
+			uint32_t d = below[right];
+			uint32_t ab = avg32(a, b);
+
+			top[x * 2] = a;
+			top[x * 2 + 1] = ab;
+			bottom[x * 2] = avg32(a, c);
+			bottom[x * 2 + 1] = avg32(ab, avg32(c, d));
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#include "scalers.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#define CPU_SSE2    0x01
+#define CPU_AVX2    0x02
+#define CPU_PROBED  0x80
+
+static int cpuFeatures = 0;
+
+static int probeCpu(void)
+{
+	int features = CPU_PROBED;
+
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	if (info[3] & (1 << 26))
+		features |= CPU_SSE2;
+
+	// AVX2 needs both the instruction set and the OS saving YMM state.
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+			features |= CPU_AVX2;
+	}
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		features |= CPU_SSE2;
+	if (__builtin_cpu_supports("avx2"))
+		features |= CPU_AVX2;
+#endif
+
+	return features;
+}
+
+bool cpuHasSSE2(void)
+{
+	if (!cpuFeatures)
+		cpuFeatures = probeCpu();
+	return (cpuFeatures & CPU_SSE2) != 0;
+}
+
+bool cpuHasAVX2(void)
+{
+	if (!cpuFeatures)
+		cpuFeatures = probeCpu();
+	return (cpuFeatures & CPU_AVX2) != 0;
+}
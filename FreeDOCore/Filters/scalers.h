@@ -0,0 +1,26 @@
+// scalers.h - Cheap SIMD scalers that complement hqx.
+//
+// All scalers take a 32-bit (BGRX) source of width*height pixels and write
+// a destination of (width*2)*(height*2) pixels. Each one checks the CPU at
+// runtime and falls back to plain C when the vector unit is missing, so the
+// output is identical on every host.
+
+#ifndef __SCALERS_H_
+#define __SCALERS_H_
+
+#include <stdint.h>
+
+// CPU features, probed once.
+bool cpuHasSSE2(void);
+bool cpuHasAVX2(void);
+
+// Pixel doubling and 2x bilinear (SSE2).
+void nearest2x_32( uint32_t * src, uint32_t * dest, int width, int height );
+void bilinear2x_32( uint32_t * src, uint32_t * dest, int width, int height );
+
+// Edge-directed 2x in the style of xBR level 1 (AVX2).
+void xbrInit(void);
+void xbrDestroy(void);
+void xbr2x_32( uint32_t * src, uint32_t * dest, int width, int height );
+
+#endif
@@ -41,6 +41,7 @@ int lsize, flagtime;
 int TIMER_VAL=0; //0x415
 extern int ARM_CLOCK;
 extern int FMVFIX;
+extern void* Getp_RAMS();
 
 void   HandleDMA(unsigned int val);
 
@@ -77,6 +78,18 @@ static unsigned int * Mregs;
 
 static CLIODatum clio;
 
+// Input FIFOs hand the DSP words from a small block read ahead of PTRI,
+// the way the DMA engine keeps its FIFO topped up, so most _clio_EIFIFO
+// calls are a pointer bump. Not part of the state: any _clio_SetFIFO on a
+// channel, or a load, drops its block and the next read refills it.
+#define EIFIFO_PREFETCH 16	// halfwords
+
+static unsigned short EIPrefetch[16][EIFIFO_PREFETCH];	// indexed like _clio_SetFIFO does, (adr>>4)&0xf
+static int EIPrefetchPos[16];
+static int EIPrefetchCount[16];
+
+static void EIFIFOFlush(void);
+
 #define cregs clio.cregs
 #define DSPW1 clio.DSPW1
 #define DSPW2 clio.DSPW2
@@ -86,19 +99,38 @@ static CLIODatum clio;
 #define FIFOI clio.FIFOI
 #define FIFOO clio.FIFOO
 
+// cregs is indexed by byte offset, but the ARM only ever reaches CLIO a word
+// at a time, and 0x1800-0x37ff is routed to the DSP without touching cregs.
+// Only the words that can hold something are saved.
+static const unsigned int CregsLive[][2]={{0x0000,0x1800},{0x3800,0x10000}};
+#define CREGS_LIVE_RANGES (sizeof(CregsLive)/sizeof(CregsLive[0]))
+
 #include <memory.h>
 unsigned int _clio_SaveSize()
 {
-        return sizeof(CLIODatum);
+        unsigned int size=sizeof(CLIODatum)-sizeof(cregs);
+        for(unsigned int r=0;r<CREGS_LIVE_RANGES;r++)
+                size+=(CregsLive[r][1]-CregsLive[r][0])/4*sizeof(unsigned int);
+        return size;
 }
 void _clio_Save(void *buff)
 {
-        memcpy(buff,&clio,sizeof(CLIODatum));
+        unsigned int *out=(unsigned int*)buff;
+        for(unsigned int r=0;r<CREGS_LIVE_RANGES;r++)
+                for(unsigned int i=CregsLive[r][0];i<CregsLive[r][1];i+=4)
+                        *out++=cregs[i];
+        memcpy(out,&DSPW1,sizeof(CLIODatum)-sizeof(cregs));
 }
 void _clio_Load(void *buff)
 {
 		TIMER_VAL=0;
-        memcpy(&clio,buff,sizeof(CLIODatum));
+        unsigned int *in=(unsigned int*)buff;
+        memset(cregs,0,sizeof(cregs));
+        for(unsigned int r=0;r<CREGS_LIVE_RANGES;r++)
+                for(unsigned int i=CregsLive[r][0];i<CregsLive[r][1];i+=4)
+                        cregs[i]=*in++;
+        memcpy(&DSPW1,in,sizeof(CLIODatum)-sizeof(cregs));
+        EIFIFOFlush();
 }
 
 #define CURADR Mregs[base]
@@ -625,6 +657,12 @@ unsigned int _clio_GetTimerDelay()
 	return cregs[0x220];
 }
 
+void _clio_ResumeXBusDMA()
+{
+	if(cregs[0x304]&0x00100000)
+		HandleDMA(0x00100000);
+}
+
 
 void   HandleDMA(unsigned int val)
 {
@@ -632,13 +670,12 @@ void   HandleDMA(unsigned int val)
 	unsigned int trg;
         int len;
 	unsigned int ptr;
-	unsigned char b0,b1,b2,b3;
+	unsigned char b0,b1;
 
 
 	cregs[0x304]|=val;
 	if(val&0x00100000)
 	{
-		cregs[0x304]&=~0x00100000;
 		src=_madam_Peek(0x540);
                 //if(src&3)_3do_DPrint("Align Err!!! - see CLIO XBUS DMA");
 		trg=src;
@@ -647,72 +684,37 @@ void   HandleDMA(unsigned int val)
 
 		cregs[0x400]&=~0x80;
 
-	  if((cregs[0x404])&0x200)
-	  {
-		ptr=0;
-		while(len>=0)
-		  {
-			  b3=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-			  //ptr++;
-
-  			  b2=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-
-			  b1=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-
-			  b0=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-
-			  _mem_write8(trg,b0);
-                          _mem_write8(trg+1,b1);
-                          _mem_write8(trg+2,b2);
-                          _mem_write8(trg+3,b3);
-
-			  trg+=4;
-			  len-=4;
-			  ptr+=4;
-
-		  }
-		//CCdRom::ClearDataPoll(CMadam::Peek(0x544));
-		//CCdRom::ClearDataPoll();
-		cregs[0x400]|=0x80;
+		// len is the byte count minus 4; the transfer is the same whether
+		// cregs[0x404]&0x200 is set or not.
+		if(len>=0)
+		{
+			unsigned int bytes=((unsigned int)len&~3)+4;
+			unsigned char *ram=(unsigned char*)Getp_RAMS()+trg;
+			unsigned int done;
+
+			// FIFO bytes come most significant first, RAM words are little-endian.
+			// The drive hands over whole sectors, so done stays word aligned.
+			done=_xbus_GetDataBlock(ram,bytes)&~3;
+			for(ptr=0;ptr<done;ptr+=4)
+			{
+				b0=ram[ptr];   ram[ptr]=ram[ptr+3];   ram[ptr+3]=b0;
+				b1=ram[ptr+1]; ram[ptr+1]=ram[ptr+2]; ram[ptr+2]=b1;
+			}
+			_mem_mirror(trg,done);
 
-	  }
-	  else
-	  {
-		ptr=0;
-		while(len>=0)
-		  {
-			  b3=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-			  //ptr++;
-
-  			  b2=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-
-			  b1=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-
-			  b0=_xbus_GetDataFIFO();
-			  //st=CXBUS::GetPoll();
-
-                          _mem_write8(trg,b0);
-                          _mem_write8(trg+1,b1);
-                          _mem_write8(trg+2,b2);
-                          _mem_write8(trg+3,b3);
-
-			  trg+=4;
-			  len-=4;
-			  ptr+=4;
-
-		  }
-		//CCdRom::ClearDataPoll(CMadam::Peek(0x544));
-		//CCdRom::ClearDataPoll();
+			if(done<bytes)
+			{
+				// The drive has not read the rest yet. The channel stays
+				// enabled, with address and count moved past what came in,
+				// and _clio_ResumeXBusDMA carries on when more arrives.
+				_madam_Poke(0x540,trg+done);
+				_madam_Poke(0x544,len-done);
+				return;
+			}
+		}
+		cregs[0x304]&=~0x00100000;
 		cregs[0x400]|=0x80;
 
-	  }
 	  len=0xFFFFFFFC;
 	  _madam_Poke(0x544,len);
 	  	//event.type = SDL_USEREVENT;
@@ -767,13 +769,42 @@ void _clio_Init(int ResetReson)
 	cregs[0x220]=64;
 	Mregs=_madam_GetRegs();
 	TIMER_VAL=0;
+	EIFIFOFlush();
+
+}
+
+static void EIFIFOFlush(void)
+{
+	int i;
+	for(i=0;i<16;i++)
+		EIPrefetchPos[i]=EIPrefetchCount[i]=0;
+}
+
+// Reads up to EIFIFO_PREFETCH halfwords from PTRI on, never past StartLen.
+static void EIFIFORefill(unsigned short channel)
+{
+	int i,count;
+
+	count=(FIFOI[channel].StartLen-PTRI[channel]+1)>>1;
+	if(count>EIFIFO_PREFETCH)
+		count=EIFIFO_PREFETCH;
+
+	for(i=0;i<count;i++)
+		EIPrefetch[channel][i]=_mem_read16( ((FIFOI[channel].StartAdr+PTRI[channel]+(i<<1))^2) );
 
+	EIPrefetchPos[channel]=0;
+	EIPrefetchCount[channel]=count;
 }
+
 unsigned short    _clio_EIFIFO(unsigned short channel)
 {
 	unsigned int val,base,mask;
 
-
+	if(EIPrefetchPos[channel]<EIPrefetchCount[channel])
+	{
+		PTRI[channel]+=2;
+		return EIPrefetch[channel][EIPrefetchPos[channel]++];
+	}
 
 	base=0x400+(channel*16);
 	mask=1<<channel;
@@ -783,7 +814,8 @@ unsigned short    _clio_EIFIFO(unsigned short channel)
 
 		if( (FIFOI[channel].StartLen-PTRI[channel])>0 )
 		{
-			val=_mem_read16( ((FIFOI[channel].StartAdr+PTRI[channel])^2) );
+			EIFIFORefill(channel);
+			val=EIPrefetch[channel][EIPrefetchPos[channel]++];
 			PTRI[channel]+=2;
 		}
 		else
@@ -856,6 +888,8 @@ unsigned short    _clio_EIFIFONI(unsigned short channel)
 {
 	unsigned int base;
 	base=0x400+(channel*16);
+	if(EIPrefetchPos[channel]<EIPrefetchCount[channel])
+		return EIPrefetch[channel][EIPrefetchPos[channel]];
 	return _mem_read16(((FIFOI[channel].StartAdr+PTRI[channel])^2));
 }
 
@@ -889,6 +923,7 @@ void _clio_SetFIFO(unsigned int adr, unsigned int val)
 {
 	if((adr&0x500)==0x400)
 	{
+		EIPrefetchPos[(adr>>4)&0xf]=EIPrefetchCount[(adr>>4)&0xf]=0;
 
 		switch (adr&0xf)
 		{
@@ -50,6 +50,8 @@ Felix Lazarev
 	void  _clio_GenerateFiq(unsigned int reason1, unsigned int reason2);
 
 	unsigned int _clio_GetTimerDelay();
+	// Moves more data into an XBUS DMA that is still waiting on its device.
+	void _clio_ResumeXBusDMA();
 
         unsigned int _clio_SaveSize();
         void _clio_Save(void *buff);
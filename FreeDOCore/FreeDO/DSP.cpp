@@ -50,8 +50,11 @@ Felix Lazarev
 unsigned short __fastcall RegBase(unsigned int reg);
 unsigned short __fastcall ireadh(unsigned int addr);
 void __fastcall iwriteh(unsigned int addr, unsigned short val);
-void __fastcall OperandLoader(int Requests);
-int __fastcall OperandLoaderNWB(void);
+struct DSPOp;
+static DSPOp* __fastcall DecodedOp(unsigned int pc);
+static void __fastcall OperandLoader(const DSPOp* op);
+static unsigned short __fastcall OperandLoaderNWB(const DSPOp* op);
+static void DecodeFlush(void);
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -190,9 +193,6 @@ int __fastcall OperandLoaderNWB(void);
 struct DSPDatum
 {
         unsigned int RBASEx4;
-        __INSTTRAS INSTTRAS[0x8000];
-        unsigned short REGCONV[8][16];
-        bool BRCONDTAB[32][32];
         unsigned short NMem[2048];
         unsigned short IMem[1024];
         int REGi;
@@ -206,6 +206,12 @@ struct DSPDatum
 
 static DSPDatum dsp;
 
+// Lookup tables built by _dsp_Init; they never change, so they stay out of
+// the saved state.
+static __INSTTRAS INSTTRAS[0x8000];
+static unsigned short REGCONV[8][16];
+static bool BRCONDTAB[32][32];
+
 #include <memory.h>
 
 unsigned int _dsp_SaveSize()
@@ -219,12 +225,10 @@ void _dsp_Save(void *buff)
 void _dsp_Load(void *buff)
 {
         memcpy(&dsp,buff,sizeof(DSPDatum));
+        DecodeFlush();
 }
 
 #define RBASEx4 dsp.RBASEx4
-#define INSTTRAS dsp.INSTTRAS
-#define REGCONV dsp.REGCONV
-#define BRCONDTAB dsp.BRCONDTAB
 #define NMem dsp.NMem
 #define IMem dsp.IMem
 #define REGi dsp.REGi
@@ -233,6 +237,194 @@ void _dsp_Load(void *buff)
 #define g_seed dsp.g_seed
 #define CPUSupply dsp.CPUSupply
 
+//////////////////////////////////////////////////////////////////////
+// Pre-decoded program
+//////////////////////////////////////////////////////////////////////
+// Every NMem word is decoded once, the first time PC reaches it, into a
+// DSPOp that carries the bitfields already unpacked and the operand words
+// that follow it already walked. Only REGi/RBASEx4 are looked up at run
+// time. An op spans at most DSP_OP_MAXWORDS words, so a write to NMem only
+// drops the decodes of the few ops that can cover that address.
+
+#define DSP_OP_MAXWORDS	5	// instruction + up to 4 operand words
+
+#define FETCH_ADDR	0	// value is an I/EI address
+#define FETCH_REG	1	// value is a register, mapped through REGCONV/RBASE
+#define FETCH_IMM	2	// value is the operand itself
+
+#define FETCH_DI	1	// indirect, read the address from value first
+#define FETCH_WB	2	// the address becomes WRITEBACK
+#define FETCH_GWB	4	// ...and is latched as the global writeback
+
+#define DSPOP_ALU		0
+#define DSPOP_CONTROL	1
+
+	struct DSPFetch{
+		unsigned char	type;
+		unsigned char	mode;
+		unsigned short	value;
+		unsigned short	pc;		// PC after the word this operand came from
+	};
+
+	struct DSPOp{
+		bool			valid;
+		unsigned char	kind;
+		unsigned short	raw;
+		unsigned short	next;	// PC after the op and its operand words
+
+		// control
+		unsigned char	special;
+		unsigned char	bits;
+		unsigned short	addr;
+		DSPFetch		dest;	// MOVE/MOVEREG destination
+
+		// ALU
+		unsigned char	MUXA, MUXB, ALU;
+		bool			M2SEL;
+		bool			ACSBU;
+		unsigned char	req;
+		unsigned char	BS;
+
+		unsigned char	fetches;
+		DSPFetch		fetch[6];
+	};
+
+static DSPOp DSPProg[sizeof(NMem)/sizeof(NMem[0])];
+
+static void DecodeFlush(void)
+{
+	unsigned int i;
+	for(i=0;i<sizeof(DSPProg)/sizeof(DSPProg[0]);i++)
+		DSPProg[i].valid=false;
+}
+
+static void DecodeFetch(DSPFetch* f, unsigned char type, unsigned int value, int mode, unsigned int pc)
+{
+	f->type=type;
+	f->mode=(unsigned char)mode;
+	f->value=(unsigned short)value;
+	f->pc=(unsigned short)pc;
+}
+
+// Mirrors the walk the interpreter did over the operand words of an ALU op.
+static unsigned int DecodeOperands(DSPOp* op, unsigned int pc, int Requests)
+{
+	int Operands=0;
+	ITAG operand;
+
+	op->fetches=0;
+	if(Requests==0)
+	{
+		if(op->req)
+			Requests=4;
+		else
+			return pc;
+	}
+
+	do
+	{
+		DSPFetch* f=&op->fetch[op->fetches];
+
+		operand.raw=NMem[pc++&0x7ff];
+		if(operand.nrof.TYPE==4)
+		{
+				//non reg format ///IT'S an address!!!
+				DecodeFetch(f++,FETCH_ADDR,operand.nrof.OP_ADDR,
+					(operand.nrof.DI?FETCH_DI:0)|FETCH_WB|(operand.nrof.WB1?FETCH_GWB:0),pc);
+				Operands++;
+		}else if ((operand.nrof.TYPE&6)==6)
+		{
+				//case 6: and case 7:  immediate format
+				DecodeFetch(f++,FETCH_IMM,operand.iof.IMMEDIATE<<(~((operand.iof.JUSTIFY)+1)&3),FETCH_WB,pc);
+				Operands++;
+		}else if(!(operand.nrof.TYPE&4))  // case 0..3
+		{
+				DecodeFetch(f++,FETCH_REG,operand.r3of.R3,operand.r3of.R3_DI?FETCH_DI:0,pc);
+				DecodeFetch(f++,FETCH_REG,operand.r3of.R2,operand.r3of.R2_DI?FETCH_DI:0,pc);
+				// only R1 can be WRITEBACK
+				DecodeFetch(f++,FETCH_REG,operand.r3of.R1,(operand.r3of.R1_DI?FETCH_DI:0)|FETCH_WB,pc);
+				Operands+=3;
+		}else //if(operand.nrof.TYPE==5)
+		{
+				//regged 1/2 format
+				if(operand.r2of.NUMREGS)
+				{
+					DecodeFetch(f++,FETCH_REG,operand.r2of.R2,
+						(operand.r2of.R2_DI?FETCH_DI:0)|FETCH_WB|(operand.r2of.WB2?FETCH_GWB:0),pc);
+					Operands++;
+				}
+				DecodeFetch(f++,FETCH_REG,operand.r2of.R1,
+					(operand.r2of.R1_DI?FETCH_DI:0)|FETCH_WB|(operand.r2of.WB1?FETCH_GWB:0),pc);
+				Operands++;
+		}//if
+		op->fetches=(unsigned char)(f-op->fetch);
+	}while(Operands<Requests);
+
+	return pc;
+}
+
+static DSPOp* __fastcall DecodedOp(unsigned int pc)
+{
+	DSPOp* op;
+	ITAG inst;
+
+	pc&=0x7ff;
+	op=&DSPProg[pc];
+	if(op->valid)
+		return op;
+
+	inst.raw=NMem[pc];
+	op->raw=(unsigned short)inst.raw;
+	op->next=(unsigned short)(pc+1);
+	op->fetches=0;
+
+	if(inst.aif.PAD)
+	{//Control instruction
+		op->kind=DSPOP_CONTROL;
+		op->special=(inst.raw>>7)&255;
+		op->bits=inst.br.bits;
+		op->addr=inst.cif.BCH_ADDR;
+
+		if(op->special>=32 && op->special<64)
+		{
+			// MOVEREG/MOVE read one operand word, without writeback.
+			ITAG operand;
+			operand.raw=NMem[(pc+1)&0x7ff];
+			op->next=(unsigned short)(pc+2);
+
+			if(operand.nrof.TYPE==4)
+				DecodeFetch(&op->fetch[0],FETCH_ADDR,operand.nrof.OP_ADDR,operand.nrof.DI?FETCH_DI:0,pc+2);
+			else if(!(operand.nrof.TYPE&4))  // case 0..3
+				DecodeFetch(&op->fetch[0],FETCH_REG,operand.r3of.R3,operand.r3of.R3_DI?FETCH_DI:0,pc+2);
+			else if ((operand.nrof.TYPE&6)==6)
+				DecodeFetch(&op->fetch[0],FETCH_IMM,operand.iof.IMMEDIATE<<(~((operand.iof.JUSTIFY)+1)&3),0,pc+2);
+			else //if(operand.r2of.NUMREGS) ignore... It's right?
+				DecodeFetch(&op->fetch[0],FETCH_REG,operand.r2of.R1,operand.r2of.R1_DI?FETCH_DI:0,pc+2);
+			op->fetches=1;
+
+			if(op->special<48) // MOVEREG
+				DecodeFetch(&op->dest,FETCH_REG,inst.r2of.R1,inst.r2of.R1_DI?FETCH_DI:0,pc+2);
+			else // MOVE
+				DecodeFetch(&op->dest,FETCH_ADDR,inst.cif.BCH_ADDR,inst.nrof.DI?FETCH_DI:0,pc+2);
+		}
+	}
+	else
+	{//ALU instruction
+		op->kind=DSPOP_ALU;
+		op->MUXA=inst.aif.MUXA;
+		op->MUXB=inst.aif.MUXB;
+		op->ALU=inst.aif.ALU;
+		op->M2SEL=inst.aif.M2SEL!=0;
+		op->ACSBU=(inst.aif.ALU==3)||(inst.aif.ALU==5);
+		op->req=INSTTRAS[inst.raw].req.raw;
+		op->BS=INSTTRAS[inst.raw].BS;
+		op->next=(unsigned short)DecodeOperands(op,pc+1,inst.aif.NUMOPS);
+	}
+
+	op->valid=true;
+	return op;
+}
+
 
 
 
@@ -383,6 +575,7 @@ void _dsp_Init()
 	dregs.Sema4Status = 0; //?? 8-CPU last, 4-DSP last, 2-CPU ACK, 1 DSP ACK ??
 	for( i=0;i<sizeof(NMem)/sizeof(NMem[0]);i++) NMem[i]=0x8380; //SLEEP
 	for(i=0;i<16;i++) CPUSupply[i]=0;
+	DecodeFlush();
 }
 
 void _dsp_Reset()
@@ -396,6 +589,13 @@ void _dsp_Reset()
 
 #include "freedocore.h"
 extern _ext_Interface  io_interface;
+#ifdef DSP_TRACE
+
+#include <stdio.h>
+
+static FILE* traceFile;
+static unsigned int traceSample;
+
 void _Arithmetic_Debug(uint16 nrc, uint16 opmask)
 {
  bool MULT1_RQST_L,MULT2_RQST_L,ALU1_RQST_L,ALU2_RQST_L,BS_RQST_L;
@@ -429,7 +629,21 @@ void _Arithmetic_Debug(uint16 nrc, uint16 opmask)
 
 }
 
+static void DSPTrace(unsigned int pc, const DSPOp* op)
+{
+	if(!traceFile)
+		traceFile=fopen(DSP_TRACE_FILE,"w");
+	if(traceFile)
+		fprintf(traceFile,"%08X %03X %04X%s",traceSample,pc,op->raw,op->kind==DSPOP_CONTROL?"\n":"");
+}
+
+static void DSPTraceALU(unsigned int Y, unsigned int Flags, bool fExact)
+{
+	if(traceFile)
+		fprintf(traceFile," Y=%08X F=%08X X=%d WB=%03X\n",Y,Flags,fExact?1:0,flags.WRITEBACK);
+}
 
+#endif //DSP_TRACE
 
 unsigned int _dsp_Loop()
 {
@@ -467,14 +681,18 @@ unsigned int _dsp_Loop()
 		Work=true;
 		do
 		{
-		  ITAG inst;
+		  const DSPOp* op;
 
-			inst.raw=NMem[dregs.PC++];
+			op=DecodedOp(dregs.PC);
+#ifdef DSP_TRACE
+			DSPTrace(dregs.PC,op);
+#endif
+			dregs.PC=op->next;
 			//DSPCYCLES++;
 
-			if(inst.aif.PAD)
+			if(op->kind==DSPOP_CONTROL)
 			{//Control instruction
-				switch((inst.raw>>7)&255) //special
+				switch(op->special) //special
 					{
 					case 0://NOP TODO
 							break;
@@ -482,16 +700,16 @@ unsigned int _dsp_Loop()
 							dregs.PC=(Y>>16)&0x3ff;
 							break;
 					case 2://set rbase
-							RBASEx4=(inst.cif.BCH_ADDR&0x3f)<<2;
+							RBASEx4=(op->addr&0x3f)<<2;
 							break;
 					case 3://set rmap
-							REGi=inst.cif.BCH_ADDR&7;
+							REGi=op->addr&7;
 							break;
 					case 4://RTS
 							dregs.PC=RBSR;
 							break;
 					case 5://set op_mask
-							flags.nOP_MASK=~(inst.cif.BCH_ADDR&0x1f);
+							flags.nOP_MASK=~(op->addr&0x1f);
 							break;
 					case 6:// -not used2- ins
 							break;
@@ -501,18 +719,18 @@ unsigned int _dsp_Loop()
 					case 8:  case 9:  case 10: case 11:
 					case 12: case 13: case 14: case 15:
 							//jump //branch only if not branched
-							dregs.PC=inst.cif.BCH_ADDR;
+							dregs.PC=op->addr;
 							break;
 					case 16: case 17: case 18: case 19:
 					case 20: case 21: case 22: case 23:
 							//jsr
 							RBSR=dregs.PC;
-							dregs.PC=inst.cif.BCH_ADDR;
+							dregs.PC=op->addr;
 							break;
 					case 24: case 25: case 26: case 27:
 					case 28: case 29: case 30: case 31:
 							// branch only if was branched
-							dregs.PC=inst.cif.BCH_ADDR;
+							dregs.PC=op->addr;
 							break;
 					case 32: case 33: case 34: case 35:
 					case 36: case 37: case 38: case 39:
@@ -520,11 +738,11 @@ unsigned int _dsp_Loop()
 					case 44: case 45: case 46: case 47: // ??? -not used- instr's
 							// MOVEREG
 							{
-								int Operand=OperandLoaderNWB();
-								if(inst.r2of.R1_DI)
-									iwriteh(ireadh(REGCONV[REGi][inst.r2of.R1]^RBASEx4),Operand);
+								unsigned short Operand=OperandLoaderNWB(op);
+								if(op->dest.mode&FETCH_DI)
+									iwriteh(ireadh(REGCONV[REGi][op->dest.value]^RBASEx4),Operand);
 								else
-									iwriteh(REGCONV[REGi][inst.r2of.R1]^RBASEx4,Operand);
+									iwriteh(REGCONV[REGi][op->dest.value]^RBASEx4,Operand);
 							}
 							break;
 					case 48: case 49: case 50: case 51:
@@ -533,35 +751,37 @@ unsigned int _dsp_Loop()
 					case 60: case 61: case 62: case 63:
 							// MOVE
 							{
-								int Operand=OperandLoaderNWB();
-								if(inst.nrof.DI)
-									iwriteh(ireadh(inst.cif.BCH_ADDR),Operand);
+								unsigned short Operand=OperandLoaderNWB(op);
+								if(op->dest.mode&FETCH_DI)
+									iwriteh(ireadh(op->dest.value),Operand);
 								else
-									iwriteh(inst.cif.BCH_ADDR,Operand);
+									iwriteh(op->dest.value,Operand);
 							}
 							break;
 					default: // Coundition branch
-							if(1&BRCONDTAB[inst.br.bits][fExact+((Flags.raw*0x10080402)>>24)]) dregs.PC=inst.cif.BCH_ADDR;
+							if(1&BRCONDTAB[op->bits][fExact+((Flags.raw*0x10080402)>>24)]) dregs.PC=op->addr;
 							break;
-				}//switch((inst.raw>>7)&255) //special
+				}//switch(op->special) //special
 			}
-			else //if(inst.aif.PAD)
+			else //if(op->kind==DSPOP_CONTROL)
 			{
 				//ALU instruction
 
-				_Arithmetic_Debug(inst.raw, ~flags.nOP_MASK);
+#ifdef DSP_TRACE
+				_Arithmetic_Debug(op->raw, ~flags.nOP_MASK);
+#endif
 
-				flags.req.raw=INSTTRAS[inst.raw].req.raw;
-				flags.BS     =INSTTRAS[inst.raw].BS;
+				flags.req.raw=op->req;
+				flags.BS     =op->BS;
 
-				OperandLoader(inst.aif.NUMOPS);
+				OperandLoader(op);
 
-				switch(inst.aif.MUXA)
+				switch(op->MUXA)
 				{
 				case 3:
-					if(inst.aif.M2SEL==0)
+					if(!op->M2SEL)
 					{
-						if((inst.aif.ALU==3)||(inst.aif.ALU==5)) // ACSBU signal
+						if(op->ACSBU) // ACSBU signal
 							AOP=Flags.Carry? ((int)flags.MULT1<<16)&ALUSIZEMASK : 0;
 						else
 							AOP=( ((int)flags.MULT1*(((signed int)Y>>15)&~1))&ALUSIZEMASK );
@@ -580,13 +800,13 @@ unsigned int _dsp_Loop()
 					break;
 				}
 
-				if((inst.aif.ALU==3)||(inst.aif.ALU==5)) // ACSBU signal
+				if(op->ACSBU) // ACSBU signal
 				{
 					BOP=Flags.Carry<<16;
 				}
 				else
 				{
-					switch(inst.aif.MUXB)
+					switch(op->MUXB)
 					{
 					case 0:
 						BOP=Y;
@@ -598,7 +818,7 @@ unsigned int _dsp_Loop()
 						BOP=flags.ALU2<<16;
 						break;
 					case 3:
-						if(inst.aif.M2SEL==0) // ACSBU==0 here always
+						if(!op->M2SEL) // ACSBU==0 here always
 							BOP=( ((int)flags.MULT1*(((signed int)Y>>15))&~1)&ALUSIZEMASK );
 						else
 							BOP=( ((int)flags.MULT1*(int)flags.MULT2*2)&ALUSIZEMASK );
@@ -608,7 +828,7 @@ unsigned int _dsp_Loop()
 				//ok now ALU itself.
                                 //unsigned char ctt1,ctt2;
 				Flags.Over=Flags.Carry=0; // Any ALU op. change Over and possible Carry
-				switch(inst.aif.ALU)
+				switch(op->ALU)
 				{
 				case 0:
 					Y=AOP;
@@ -783,12 +1003,21 @@ unsigned int _dsp_Loop()
 				{
 					iwriteh(flags.WRITEBACK,((signed int)Y)>>16);
 				}
+#ifdef DSP_TRACE
+				DSPTraceALU(Y,Flags.raw,fExact);
+#endif
 
 				//fin :)
-			}//else //if(inst.aif.PAD)
+			}//else //if(op->kind==DSPOP_CONTROL)
 
 		}while(Work);//big while!!!
 
+#ifdef DSP_TRACE
+		traceSample++;
+		if(traceFile)
+			fflush(traceFile);
+#endif
+
 
 		if(1&flags.GenFIQ)
 		{
@@ -808,7 +1037,15 @@ void __fastcall _dsp_WriteMemory(unsigned short addr, unsigned short val) //CPU
 {
 	//mwriteh(addr,val);
 	//printf("#NWRITE 0x%3.3X<=0x%4.4X\n",addr,val);
-	NMem[addr&0x3ff]=val;
+	int a;
+
+	addr&=0x3ff;
+	NMem[addr]=val;
+
+	// drop every decoded op whose words can include addr
+	for(a=addr-(DSP_OP_MAXWORDS-1);a<=addr;a++)
+		if(a>=0)
+			DSPProg[a].valid=false;
 }
 
 unsigned short __fastcall RegBase(unsigned int reg)
@@ -1137,97 +1374,49 @@ unsigned int _dsp_ARMread2sema4(void)
 	return (dregs.Sema4Status<<16) | dregs.Sema4Data;
 }
 
- void __fastcall OperandLoader(int Requests)
+ static unsigned short __fastcall FetchOperand(const DSPFetch* f)
+{
+	unsigned int addr;
+
+	dregs.PC=f->pc;
+	if(f->type==FETCH_IMM)
+	{
+		if(f->mode&FETCH_WB)
+			flags.WRITEBACK=f->value;
+		return f->value;
+	}
+
+	if(f->type==FETCH_REG)
+		addr=REGCONV[REGi][f->value]^RBASEx4;
+	else
+		addr=f->value;
+
+	if(f->mode&FETCH_DI)
+		addr=ireadh(addr);
+	if(f->mode&FETCH_WB)
+		flags.WRITEBACK=addr;
+	return ireadh(addr);
+}
+
+static void __fastcall OperandLoader(const DSPOp* op)
 {
 	int Operands;//total of operands
 	int Ptr;
 	unsigned short OperandPool[6]; // c'mon -- 5 is real maximum
 	unsigned short GWRITEBACK;
 
-	ITAG operand;
-
 	flags.WRITEBACK=0;
-
-	if(Requests==0)
-	{
-		if(flags.req.raw)
-			Requests=4;
-		else
-			return;
-	}
-
-	//DSPCYCLES+=Requests;
-	Operands=0;
 	GWRITEBACK=0;
 
-	do
+	//DSPCYCLES+=Requests;
+	for(Operands=0;Operands<op->fetches;Operands++)
 	{
-		operand.raw=NMem[dregs.PC++];
-		if(operand.nrof.TYPE==4)
-		{
-				//non reg format ///IT'S an address!!!
-				if(operand.nrof.DI)
-					OperandPool[Operands]=ireadh(flags.WRITEBACK=ireadh(operand.nrof.OP_ADDR));
-				else
-					OperandPool[Operands]=ireadh(flags.WRITEBACK=       operand.nrof.OP_ADDR);
-				Operands++;
-
-				if(operand.nrof.WB1)
-					GWRITEBACK=flags.WRITEBACK;
-
-		}else if ((operand.nrof.TYPE&6)==6)
-		{
-				//case 6: and case 7:  immediate format
-				OperandPool[Operands]=operand.iof.IMMEDIATE<<(~((operand.iof.JUSTIFY)+1)&3);
-				flags.WRITEBACK=OperandPool[Operands++];
-
-		}else if(!(operand.nrof.TYPE&4))  // case 0..3
-		{
-				if(operand.r3of.R3_DI)
-					OperandPool[Operands]=ireadh(ireadh(REGCONV[REGi][operand.r3of.R3]^RBASEx4));
-				else
-					OperandPool[Operands]=ireadh(       REGCONV[REGi][operand.r3of.R3]^RBASEx4 );
-				Operands++;
-
-				if(operand.r3of.R2_DI)
-					OperandPool[Operands]=ireadh(ireadh(REGCONV[REGi][operand.r3of.R2]^RBASEx4));
-				else
-					OperandPool[Operands]=ireadh(       REGCONV[REGi][operand.r3of.R2]^RBASEx4 );
-				Operands++;
-
-				// only R1 can be WRITEBACK
-				if(operand.r3of.R1_DI)
-					OperandPool[Operands]=ireadh(flags.WRITEBACK=ireadh(REGCONV[REGi][operand.r3of.R1]^RBASEx4));
-				else
-					OperandPool[Operands]=ireadh(flags.WRITEBACK=       REGCONV[REGi][operand.r3of.R1]^RBASEx4 );
-				Operands++;
-
-		}else //if(operand.nrof.TYPE==5)
-		{
-				//regged 1/2 format
-				if(operand.r2of.NUMREGS)
-				{
-					if(operand.r2of.R2_DI)
-						OperandPool[Operands]=ireadh(flags.WRITEBACK=ireadh(REGCONV[REGi][operand.r2of.R2]^RBASEx4));
-					else
-						OperandPool[Operands]=ireadh(flags.WRITEBACK=       REGCONV[REGi][operand.r2of.R2]^RBASEx4 );
-					Operands++;
-
-					if(operand.r2of.WB2)
-						GWRITEBACK=flags.WRITEBACK;
-				}
-
-				if(operand.r2of.R1_DI)
-					OperandPool[Operands]=ireadh(flags.WRITEBACK=ireadh(REGCONV[REGi][operand.r2of.R1]^RBASEx4));
-				else
-					OperandPool[Operands]=ireadh(flags.WRITEBACK=       REGCONV[REGi][operand.r2of.R1]^RBASEx4 );
-				Operands++;
-
-				if(operand.r2of.WB1)
-					GWRITEBACK=flags.WRITEBACK;
-		}//if
-	}while(Operands<Requests);
-
+		OperandPool[Operands]=FetchOperand(&op->fetch[Operands]);
+		if(op->fetch[Operands].mode&FETCH_GWB)
+			GWRITEBACK=flags.WRITEBACK;
+	}
+	if(Operands==0)
+		return;
 
 	//ok let's clean out Requests (using op_mask)
 	flags.req.raw&=flags.nOP_MASK;
@@ -1257,40 +1446,7 @@ unsigned int _dsp_ARMread2sema4(void)
 		flags.WRITEBACK=GWRITEBACK;
 }
 
-int __fastcall OperandLoaderNWB(void)
+static unsigned short __fastcall OperandLoaderNWB(const DSPOp* op)
 {
-	int Operand;
-
-	ITAG operand;
-
-		operand.raw=NMem[dregs.PC++];
-		if(operand.nrof.TYPE==4)
-		{
-				//non reg format ///IT'S an address!!!
-				if(operand.nrof.DI)
-					Operand=ireadh(ireadh(operand.nrof.OP_ADDR));
-				else
-					Operand=ireadh(       operand.nrof.OP_ADDR);
-
-
-		}else if(!(operand.nrof.TYPE&4))  // case 0..3
-		{
-				if(operand.r3of.R3_DI) // ???
-					Operand=ireadh(ireadh(REGCONV[REGi][operand.r3of.R3]^RBASEx4));
-				else
-					Operand=ireadh(       REGCONV[REGi][operand.r3of.R3]^RBASEx4 );
-		}else if ((operand.nrof.TYPE&6)==6)
-		{
-				//case 6: and case 7:  immediate format
-				Operand=operand.iof.IMMEDIATE<<(~((operand.iof.JUSTIFY)+1)&3); 
-
-		}else if(operand.nrof.TYPE==5)
-		{ //if(operand.r2of.NUMREGS) ignore... It's right?
-				if(operand.r2of.R1_DI)
-					Operand=ireadh(ireadh(REGCONV[REGi][operand.r2of.R1]^RBASEx4));
-				else
-					Operand=ireadh(       REGCONV[REGi][operand.r2of.R1]^RBASEx4 );
-		}
-
-		return Operand;
+	return FetchOperand(&op->fetch[0]);
 }
@@ -27,7 +27,11 @@ Felix Lazarev
 #include "freedoconfig.h"
 #include <memory.h>
 #include "IsoXBUS.h"
+#include "XBUSFifo.h"
 #include "types.h"
+#include "stdafx.h"
+#include "freedocore.h"
+#include "cdcache.h"
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -35,6 +39,13 @@ Felix Lazarev
 
 #define STATDELAY 100
 #define REQSIZE	2048
+
+// Drive timing, for every CD_TIMING_* mode but turbo.
+#define CD_SECTORS_PER_SECOND	75		// at 1x
+#define CD_BUFFER_SECTORS		16		// the drive reads this far ahead of the host
+#define CD_SEEK_MS				60		// shortest seek, settling included
+#define CD_FULL_SEEK_MS			300		// added for a seek across the whole disc
+#define CD_FULL_SEEK_SECTORS	333000	// 74 minutes
 enum MEI_CDROM_Error_Codes {
   MEI_CDROM_no_error = 0x00,
   MEI_CDROM_recv_retry = 0x01,
@@ -154,19 +165,21 @@ class cdrom_Device
 private:
 	unsigned char Poll;
 	unsigned char XbusStatus;
-	unsigned char StatusLen;
-	int  DataLen;
-	int  DataPtr;
 	unsigned int olddataptr;
-	unsigned char CmdPtr;
-	unsigned char Status[256];
-	unsigned char Data[REQSIZE];
-	unsigned char Command[7];
+	XBUSFifo<256> Status;
+	XBUSFifo<REQSIZE> Data;
+	XBUSFifo<8> CmdFifo;
+	unsigned char Command[7];	// the command being run
 	char STATCYC;
 	int Requested;
 	MEI_CDROM_Error_Codes MEIStatus;
 	DISCStc DISC;
         unsigned int curr_sector;
+	int Buffered;		// of the Requested sectors, how many the drive has read
+	int ReadDelay;		// ARM cycles until it has read one more
+
+	int SectorCycles();
+	int SeekCycles(unsigned int from, unsigned int to);
 
 public:
 
@@ -178,7 +191,10 @@ public:
 	bool TestFIQ();
 	void SetPoll(unsigned int val);
 	unsigned int GetDataFifo();
+	unsigned int GetDataBlock(unsigned char *buff, unsigned int len);
+	void DataEmptied();
 	void DoCommand();
+	bool Clock(int cycles);
 	unsigned char BCD2BIN(unsigned char in);
 	unsigned char BIN2BCD(unsigned char in);
 	void MSF2BLK();
@@ -199,8 +215,7 @@ public:
 #pragma pack(pop)
 
 extern unsigned int _3do_DiscSize();
-extern void _3do_Read2048(void *buff);
-extern void _3do_OnSector(unsigned int sector);
+extern int ARM_CLOCK;
 
 
 void cdrom_Device::Init()
@@ -208,7 +223,11 @@ void cdrom_Device::Init()
 	unsigned int filesize;
 
 	filesize=150;
-	DataPtr=0;
+	Status.Clear();
+	Data.Clear();
+	CmdFifo.Clear();
+	Buffered=0;
+	ReadDelay=0;
 
 		XbusStatus=0;
 		//XBPOLL=POLSTMASK|POLDTMASK|POLMAMASK|POLREMASK;
@@ -255,16 +274,11 @@ unsigned int cdrom_Device::GetStatusFifo()
 {
 	unsigned int res;
 	res=0;
-	if(StatusLen>0)
+	if(!Status.IsEmpty())
 	{
-		res=Status[0];
-		StatusLen--;
-		if(StatusLen>0)
-			memcpy(Status,Status+1,StatusLen);
-		else
-		{
-				Poll&=~POLST;
-		}
+		res=Status.Pop();
+		if(Status.IsEmpty())
+			Poll&=~POLST;
 	}
 	return res;
 
@@ -272,18 +286,14 @@ unsigned int cdrom_Device::GetStatusFifo()
 
 void __fastcall cdrom_Device::SendCommand(unsigned char val)
 {
- 	if (CmdPtr<7)
-	{
-			Command[CmdPtr]=(unsigned char)val;
-			CmdPtr++;
-
-	}
-	if((CmdPtr>=7) || (Command[0]==0x8))
+ 	if (CmdFifo.Count()<7)
+		CmdFifo.Push(val);
+	if((CmdFifo.Count()>=7) || (CmdFifo.Peek(0)==0x8))
 	{
 
 			//Poll&=~0x80; ???
+			CmdFifo.Read(Command,7);
 			DoCommand();
-			CmdPtr=0;
 	}
 }
 
@@ -312,36 +322,109 @@ unsigned int cdrom_Device::GetDataFifo()
 {
 	unsigned int res;
 	res=0;
-        //int i;
 
-	if(DataLen>0)
+	if(!Data.IsEmpty())
 	{
-		res=(unsigned char)Data[DataPtr];
-		DataLen--;
-		DataPtr++;
+		res=Data.Pop();
+		if(Data.IsEmpty())
+			DataEmptied();
+	}
+
+	return res;
+}
 
-		if(DataLen==0)
+// Same as len calls to GetDataFifo: whole runs of the current block are
+// copied at once, and reading past the end of the data yields zeroes.
+// With drive timing, the copy stops short while the drive still owes
+// sectors it has not read yet. Returns the bytes copied.
+unsigned int cdrom_Device::GetDataBlock(unsigned char *buff, unsigned int len)
+{
+	unsigned int done=0;
+
+	while(len)
+	{
+		if(Data.IsEmpty())
 		{
-			DataPtr=0;
-			if(Requested)
-			{
-                                _3do_OnSector(curr_sector++);
-                                _3do_Read2048(Data);
-				Requested--;
-				DataLen=REQSIZE;
-			}
-			else
-			{
-				Poll&=~POLDT;
-				Requested=0;
-				DataLen=0;
-				DataPtr=0;
-			}
+			if(cdtiming!=CD_TIMING_TURBO && Requested)
+				return done;
+			memset(buff,0,len);
+			return done+len;
+		}
+
+		unsigned int run=Data.Read(buff,len);
+		buff+=run;
+		len-=run;
+		done+=run;
+
+		if(Data.IsEmpty())
+			DataEmptied();
+	}
+	return done;
+}
+
+void cdrom_Device::DataEmptied()
+{
+	if(Requested && (cdtiming==CD_TIMING_TURBO || Buffered>0))
+	{
+                _cdcache_Read(curr_sector++,Data.data);
+		Requested--;
+		if(Buffered)
+			Buffered--;
+		Data.Load(REQSIZE);
+	}
+	else
+	{
+		// Either done, or the drive has not read the next sector yet;
+		// Clock brings it in then.
+		Poll&=~POLDT;
+		Data.Clear();
+	}
+}
 
+int cdrom_Device::SectorCycles()
+{
+	return ARM_CLOCK/(CD_SECTORS_PER_SECOND*cdtiming);
+}
+
+int cdrom_Device::SeekCycles(unsigned int from, unsigned int to)
+{
+	unsigned int distance=(from>to)?from-to:to-from;
+	if(distance<=CD_BUFFER_SECTORS)
+		return 0;	// still under the head
+	if(distance>CD_FULL_SEEK_SECTORS)
+		distance=CD_FULL_SEEK_SECTORS;
+
+	int ms=CD_SEEK_MS+(int)((unsigned long long)CD_FULL_SEEK_MS*distance/CD_FULL_SEEK_SECTORS);
+	return (int)((long long)ARM_CLOCK*ms/1000);
+}
+
+// Runs the drive for the given number of ARM cycles. The drive keeps up to
+// CD_BUFFER_SECTORS read ahead of the host, and hands over the next one as
+// soon as the data FIFO is empty. Returns true when new data was put in the
+// FIFO, which raises the data FIQ again.
+bool cdrom_Device::Clock(int cycles)
+{
+	if(Requested==0)
+		return false;
+
+	if(cdtiming!=CD_TIMING_TURBO)
+	{
+		ReadDelay-=cycles;
+		while(ReadDelay<=0 && Buffered<Requested && Buffered<CD_BUFFER_SECTORS)
+		{
+			Buffered++;
+			ReadDelay+=SectorCycles();
 		}
+		if(ReadDelay<0)
+			ReadDelay=0;	// buffer full, the drive waits for the host
 	}
 
-	return res;
+	if(!Data.IsEmpty() || (cdtiming!=CD_TIMING_TURBO && Buffered==0))
+		return false;
+
+	DataEmptied();
+	Poll|=POLDT;
+	return true;
 }
 
 void cdrom_Device::DoCommand()
@@ -352,7 +435,7 @@ void cdrom_Device::DoCommand()
 		Data[i]=0;
 
 	DataLen=0;*/
-	StatusLen=0;
+	Status.Clear();
 
 
 	Poll&=~POLST;
@@ -392,11 +475,11 @@ void cdrom_Device::DoCommand()
 
 		Poll|=POLST; //status is valid
 
-		StatusLen=2;
-		Status[0]=0x2;
+		Status.Load(2);
+		Status.data[0]=0x2;
 		//Status[1]=0x0;
 		//Status[2]=0x0;
-		Status[1]=XbusStatus;
+		Status.data[1]=XbusStatus;
 
 
 		break;
@@ -422,11 +505,11 @@ void cdrom_Device::DoCommand()
 
 		Poll|=POLST; //status is valid
 
-		StatusLen=2;
-		Status[0]=0x3;
+		Status.Load(2);
+		Status.data[0]=0x3;
 		//Status[1]=0x0;
 		//Status[2]=0x0;
-		Status[1]=XbusStatus;
+		Status.data[1]=XbusStatus;
 
 		break;
 	case 0x4:
@@ -459,11 +542,11 @@ void cdrom_Device::DoCommand()
 		Poll&=~POLMA;
 		MEIStatus=MEI_CDROM_no_error;
 
-		StatusLen=2;
-		Status[0]=0x6;
+		Status.Load(2);
+		Status.data[0]=0x6;
 		//Status[1]=0x0;
 		//Status[2]=0x0;
-		Status[1]=XbusStatus;
+		Status.data[1]=XbusStatus;
 
 	/*	ClearCDB();
 		CDB[0]=0x1b;
@@ -490,11 +573,11 @@ void cdrom_Device::DoCommand()
 		//status 4 bytes
 		//xx xx xx XS
 		//
-		StatusLen=33;
-		Status[0]=0x8;
+		Status.Load(33);
+		Status.data[0]=0x8;
 		for(i=1;i<32;i++)
-			Status[i]=0;
-		Status[32]=XbusStatus;
+			Status.data[i]=0;
+		Status.data[32]=XbusStatus;
 
 		XbusStatus|=CDST_RDY;
 		MEIStatus=MEI_CDROM_no_error;
@@ -527,9 +610,9 @@ void cdrom_Device::DoCommand()
 
 		Poll|=POLST; //status is valid
 
-		StatusLen=2;
-		Status[0]=0x9;
-		Status[1]=XbusStatus;
+		Status.Load(2);
+		Status.data[0]=0x9;
+		Status.data[1]=XbusStatus;
 
 
 
@@ -551,11 +634,11 @@ void cdrom_Device::DoCommand()
 		//flush all internal buffer
 		//1+31+1
 		XbusStatus|=CDST_RDY;
-		StatusLen=33;
-		Status[0]=0xb;
+		Status.Load(33);
+		Status.data[0]=0xb;
 		for(i=1;i<32;i++)
-			Status[i]=0;
-		Status[32]=XbusStatus;
+			Status.data[i]=0;
+		Status.data[32]=XbusStatus;
 
 		//XbusStatus|=CDST_RDY;
 		MEIStatus=MEI_CDROM_no_error;
@@ -582,13 +665,15 @@ void cdrom_Device::DoCommand()
 		//olddataptr=DataLen;
 		if((XbusStatus&CDST_TRAY)&&(XbusStatus&CDST_DISC)&&(XbusStatus&CDST_SPIN))
 		{
+			unsigned int head=curr_sector;
+
 			XbusStatus|=CDST_RDY;
 			//CDMode[Command[1]]=Command[2];
-			StatusLen=2;
-			Status[0]=0x10;
+			Status.Load(2);
+			Status.data[0]=0x10;
 			//Status[1]=0x0;
 			//Status[2]=0x0;
-			Status[1]=XbusStatus;
+			Status.data[1]=XbusStatus;
 
 			//if(Command[6]==Address_Abs_MSF)
 			{
@@ -605,7 +690,6 @@ void cdrom_Device::DoCommand()
 				//	fseek(fiso,DISC.templba*2048+iso_off_from_begin,SEEK_SET);
 				{
                                                 curr_sector=DISC.templba;
-						_3do_OnSector(DISC.templba);
 				}
 					//fseek(fiso,DISC.templba*2048,SEEK_SET);
 					//fseek(fiso,DISC.templba*2336,SEEK_SET);
@@ -618,18 +702,28 @@ void cdrom_Device::DoCommand()
 			olddataptr=(Command[5]<<8)+Command[6];
 			//olddataptr=olddataptr*2048; //!!!
 			Requested=olddataptr;
+			_cdcache_Prefetch(curr_sector,Requested);
 
-
+			if(cdtiming==CD_TIMING_TURBO)
+			{
 				if(Requested)
 				{
-                                        _3do_OnSector(curr_sector++);
-					_3do_Read2048(Data);
-                                        DataLen=REQSIZE;
+                                        _cdcache_Read(curr_sector++,Data.data);
+                                        Data.Load(REQSIZE);
                                         Requested--;
 				}
-                                else DataLen=0;
+                                else Data.Clear();
 
-			Poll|=POLDT;
+				Poll|=POLDT;
+			}
+			else
+			{
+				// The status comes back now, the data once the head is
+				// there and the first sector has been read.
+				Data.Clear();
+				Buffered=0;
+				ReadDelay=SeekCycles(head,curr_sector)+SectorCycles();
+			}
 			Poll|=POLST;
 			MEIStatus=MEI_CDROM_no_error;
 
@@ -640,11 +734,11 @@ void cdrom_Device::DoCommand()
 			XbusStatus|=CDST_ERRO;
 			XbusStatus&=~CDST_RDY;
 			Poll|=POLST; //status is valid
-			StatusLen=2;
-			Status[0]=0x10;
+			Status.Load(2);
+			Status.data[0]=0x10;
 			//Status[1]=0x0;
 			//Status[2]=0x0;
-			Status[1]=XbusStatus;
+			Status.data[1]=XbusStatus;
 			MEIStatus=MEI_CDROM_recv_ecc;
 
 		}
@@ -658,11 +752,11 @@ void cdrom_Device::DoCommand()
 		// status 4 bytes
 		// 80 AA 55 XS
 		XbusStatus|=CDST_RDY;
-		StatusLen=4;
-		Status[0]=0x80;
-		Status[1]=0xaa;
-		Status[2]=0x55;
-		Status[3]=XbusStatus;
+		Status.Load(4);
+		Status.data[0]=0x80;
+		Status.data[1]=0xaa;
+		Status.data[2]=0x55;
+		Status.data[3]=XbusStatus;
 		Poll|=POLST;
 		MEIStatus=MEI_CDROM_no_error;
 
@@ -681,19 +775,19 @@ void cdrom_Device::DoCommand()
 		//66
 		//77
 		//88   Current Status //TEST
-		Status[0]=0x82;
-		Status[1]=MEIStatus;
-		Status[2]=MEIStatus;
-		Status[3]=MEIStatus;
-		Status[4]=MEIStatus;
-		Status[5]=MEIStatus;
-		Status[6]=MEIStatus;
-		Status[7]=MEIStatus;
-		Status[8]=MEIStatus;
+		Status.data[0]=0x82;
+		Status.data[1]=MEIStatus;
+		Status.data[2]=MEIStatus;
+		Status.data[3]=MEIStatus;
+		Status.data[4]=MEIStatus;
+		Status.data[5]=MEIStatus;
+		Status.data[6]=MEIStatus;
+		Status.data[7]=MEIStatus;
+		Status.data[8]=MEIStatus;
 		XbusStatus|=CDST_RDY;
-		Status[9]=XbusStatus;
+		Status.data[9]=XbusStatus;
 		//Status[9]=XbusStatus; // 1 == disc present
-		StatusLen=10;
+		Status.Load(10);
 		Poll|=POLST;
 		//Poll|=0x80; //MDACC
 
@@ -707,19 +801,19 @@ void cdrom_Device::DoCommand()
 		//MEI text + XS
 		//00 M E I 1 01 00 00 00 00 00 XS
 		XbusStatus|=CDST_RDY;
-		StatusLen=12;
-		Status[0]=0x83;
-		Status[1]=0x00;//manufacture id
-		Status[2]=0x10;//10
-		Status[3]=0x00;//MANUFACTURE NUM
-		Status[4]=0x01;//01
-		Status[5]=00;
-		Status[6]=00;
-		Status[7]=0;//REVISION NUMBER:
-		Status[8]=0;
-		Status[9]=0x00;//FLAG BYTES
-		Status[10]=0x00;
-		Status[11]=XbusStatus;//DEV.DRIVER SIZE
+		Status.Load(12);
+		Status.data[0]=0x83;
+		Status.data[1]=0x00;//manufacture id
+		Status.data[2]=0x10;//10
+		Status.data[3]=0x00;//MANUFACTURE NUM
+		Status.data[4]=0x01;//01
+		Status.data[5]=00;
+		Status.data[6]=00;
+		Status.data[7]=0;//REVISION NUMBER:
+		Status.data[8]=0;
+		Status.data[9]=0x00;//FLAG BYTES
+		Status.data[10]=0x00;
+		Status.data[11]=XbusStatus;//DEV.DRIVER SIZE
 		//Status[11]=XbusStatus;
 		//Status[12]=XbusStatus;
 		Poll|=POLST;
@@ -734,10 +828,10 @@ void cdrom_Device::DoCommand()
 		//xx S1 S2 XS
 		//xx xx nn XS
 		//
-		StatusLen=4;
-		Status[0]=0x0;
-		Status[1]=0x0;
-		Status[2]=0x0;
+		Status.Load(4);
+		Status.data[0]=0x0;
+		Status.data[1]=0x0;
+		Status.data[2]=0x0;
 
 		if((XbusStatus&CDST_TRAY) && (XbusStatus&CDST_DISC))
 		{
@@ -753,7 +847,7 @@ void cdrom_Device::DoCommand()
 
 		Poll|=POLST; //status is valid
 
-		Status[3]=XbusStatus;
+		Status.data[3]=XbusStatus;
 
 
 
@@ -773,16 +867,16 @@ void cdrom_Device::DoCommand()
 		//66 ??
 		if((XbusStatus&CDST_TRAY)&&(XbusStatus&CDST_DISC)&&(XbusStatus&CDST_SPIN))
 		{
-			StatusLen=8;//CMD+status+DRVSTAT
-			Status[0]=0x85;
-			Status[1]=0;
-			Status[2]=DISC.totalmsf[0]; //min
-			Status[3]=DISC.totalmsf[1]; //sec
-			Status[4]=DISC.totalmsf[2]; //fra
-			Status[5]=0x00;
-			Status[6]=0x00;
+			Status.Load(8);//CMD+status+DRVSTAT
+			Status.data[0]=0x85;
+			Status.data[1]=0;
+			Status.data[2]=DISC.totalmsf[0]; //min
+			Status.data[3]=DISC.totalmsf[1]; //sec
+			Status.data[4]=DISC.totalmsf[2]; //fra
+			Status.data[5]=0x00;
+			Status.data[6]=0x00;
 			XbusStatus|=CDST_RDY;
-			Status[7]=XbusStatus;
+			Status.data[7]=XbusStatus;
 			Poll|=POLST;
 			MEIStatus=MEI_CDROM_no_error;
 
@@ -792,9 +886,9 @@ void cdrom_Device::DoCommand()
 		{
 			XbusStatus|=CDST_ERRO;
 			XbusStatus&=~CDST_RDY;
-			StatusLen=2;//CMD+status+DRVSTAT
-			Status[0]=0x85;
-			Status[1]=XbusStatus;
+			Status.Load(2);//CMD+status+DRVSTAT
+			Status.data[0]=0x85;
+			Status.data[1]=XbusStatus;
 			Poll|=POLST;
 			MEIStatus=MEI_CDROM_recv_ecc;
 
@@ -832,20 +926,20 @@ void cdrom_Device::DoCommand()
 
 		if((XbusStatus&CDST_TRAY)&&(XbusStatus&CDST_DISC)&&(XbusStatus&CDST_SPIN))
 		{
-			StatusLen=12;//CMD+status+DRVSTAT
-			Status[0]=0x87;
-			Status[1]=0;//DISC.totalmsf[0]; //min
-			Status[2]=0; //sec
-			Status[3]=0; //fra
-			Status[4]=0;
-			Status[5]=0;
+			Status.Load(12);//CMD+status+DRVSTAT
+			Status.data[0]=0x87;
+			Status.data[1]=0;//DISC.totalmsf[0]; //min
+			Status.data[2]=0; //sec
+			Status.data[3]=0; //fra
+			Status.data[4]=0;
+			Status.data[5]=0;
 			XbusStatus|=CDST_RDY;
-			Status[6]=0x0;
-			Status[7]=0x0;
-			Status[8]=0x0;
-			Status[9]=0x0;
-			Status[10]=0x0;
-			Status[11]=XbusStatus;
+			Status.data[6]=0x0;
+			Status.data[7]=0x0;
+			Status.data[8]=0x0;
+			Status.data[9]=0x0;
+			Status.data[10]=0x0;
+			Status.data[11]=XbusStatus;
 			Poll|=POLST;
 			MEIStatus=MEI_CDROM_no_error;
 
@@ -855,9 +949,9 @@ void cdrom_Device::DoCommand()
 		{
 			XbusStatus|=CDST_ERRO;
 			XbusStatus&=~CDST_RDY;
-			StatusLen=2;//CMD+status+DRVSTAT
-			Status[0]=0x85;
-			Status[1]=XbusStatus;
+			Status.Load(2);//CMD+status+DRVSTAT
+			Status.data[0]=0x85;
+			Status.data[1]=XbusStatus;
 			Poll|=POLST;
 			MEIStatus=MEI_CDROM_recv_ecc;
 
@@ -899,20 +993,20 @@ void cdrom_Device::DoCommand()
 		//????? which code???
 		if((XbusStatus&CDST_TRAY)&&(XbusStatus&CDST_DISC)&&(XbusStatus&CDST_SPIN))
 		{
-			StatusLen=12;//CMD+status+DRVSTAT
-			Status[0]=0x8a;
-			Status[1]=0;//DISC.totalmsf[0]; //min
-			Status[2]=0; //sec
-			Status[3]=0; //fra
-			Status[4]=0;
-			Status[5]=0;
+			Status.Load(12);//CMD+status+DRVSTAT
+			Status.data[0]=0x8a;
+			Status.data[1]=0;//DISC.totalmsf[0]; //min
+			Status.data[2]=0; //sec
+			Status.data[3]=0; //fra
+			Status.data[4]=0;
+			Status.data[5]=0;
 			XbusStatus|=CDST_RDY;
-			Status[6]=0x0;
-			Status[7]=0x0;
-			Status[8]=0x0;
-			Status[9]=0x0;
-			Status[10]=0x0;
-			Status[11]=XbusStatus;
+			Status.data[6]=0x0;
+			Status.data[7]=0x0;
+			Status.data[8]=0x0;
+			Status.data[9]=0x0;
+			Status.data[10]=0x0;
+			Status.data[11]=XbusStatus;
 			Poll|=POLST;
 			MEIStatus=MEI_CDROM_no_error;
 
@@ -922,9 +1016,9 @@ void cdrom_Device::DoCommand()
 		{
 			XbusStatus|=CDST_ERRO;
 			XbusStatus&=~CDST_RDY;
-			StatusLen=2;//CMD+status+DRVSTAT
-			Status[0]=0x85;
-			Status[1]=XbusStatus;
+			Status.Load(2);//CMD+status+DRVSTAT
+			Status.data[0]=0x85;
+			Status.data[1]=XbusStatus;
 			Poll|=POLST;
 			MEIStatus=MEI_CDROM_recv_ecc;
 
@@ -950,26 +1044,26 @@ void cdrom_Device::DoCommand()
 		//66= frames
 
 
-		StatusLen=8;//6+1 + 1 for what?
-		Status[0]=0x8b;
+		Status.Load(8);//6+1 + 1 for what?
+		Status.data[0]=0x8b;
 		if(XbusStatus&(CDST_TRAY|CDST_DISC|CDST_SPIN))
 		{
-			Status[1]=DISC.discid;
-			Status[2]=DISC.firsttrk;
-			Status[3]=DISC.lasttrk;
-			Status[4]=DISC.totalmsf[0]; //minutes
-			Status[5]=DISC.totalmsf[1]; //seconds
+			Status.data[1]=DISC.discid;
+			Status.data[2]=DISC.firsttrk;
+			Status.data[3]=DISC.lasttrk;
+			Status.data[4]=DISC.totalmsf[0]; //minutes
+			Status.data[5]=DISC.totalmsf[1]; //seconds
 			XbusStatus|=CDST_RDY;
-			Status[6]=DISC.totalmsf[2]; //frames
+			Status.data[6]=DISC.totalmsf[2]; //frames
 			MEIStatus=MEI_CDROM_no_error;
-			Status[7]=XbusStatus;
+			Status.data[7]=XbusStatus;
 		}
 		else
 		{
-			StatusLen=2;//6+1 + 1 for what?
+			Status.Load(2);//6+1 + 1 for what?
 			XbusStatus|=CDST_ERRO;
 			MEIStatus=MEI_CDROM_recv_ecc;
-			Status[1]=XbusStatus;
+			Status.data[1]=XbusStatus;
 		}
 
 		Poll|=POLST; //status is valid
@@ -991,29 +1085,29 @@ void cdrom_Device::DoCommand()
 		//66=seconds;
 		//77=frames;
 		//88=reserved7;
-		StatusLen=10;//CMD+status+DRVSTAT
-		Status[0]=0x8c;
+		Status.Load(10);//CMD+status+DRVSTAT
+		Status.data[0]=0x8c;
 		if(XbusStatus&(CDST_TRAY|CDST_DISC|CDST_SPIN))
 		{
-			Status[1]=DISC.DiscTOC[Command[2]].res0;
-			Status[2]=DISC.DiscTOC[Command[2]].CDCTL;
-			Status[3]=DISC.DiscTOC[Command[2]].TRKNUM;
-			Status[4]=DISC.DiscTOC[Command[2]].res1;
-			Status[5]=DISC.DiscTOC[Command[2]].mm; //min
+			Status.data[1]=DISC.DiscTOC[Command[2]].res0;
+			Status.data[2]=DISC.DiscTOC[Command[2]].CDCTL;
+			Status.data[3]=DISC.DiscTOC[Command[2]].TRKNUM;
+			Status.data[4]=DISC.DiscTOC[Command[2]].res1;
+			Status.data[5]=DISC.DiscTOC[Command[2]].mm; //min
 			XbusStatus|=CDST_RDY;
-			Status[6]=DISC.DiscTOC[Command[2]].ss; //sec
-			Status[7]=DISC.DiscTOC[Command[2]].ff; //frames
-			Status[8]=DISC.DiscTOC[Command[2]].res2;
+			Status.data[6]=DISC.DiscTOC[Command[2]].ss; //sec
+			Status.data[7]=DISC.DiscTOC[Command[2]].ff; //frames
+			Status.data[8]=DISC.DiscTOC[Command[2]].res2;
 			MEIStatus=MEI_CDROM_no_error;
-			Status[9]=XbusStatus;
+			Status.data[9]=XbusStatus;
 
 		}
 		else
 		{
-			StatusLen=2;
+			Status.Load(2);
 			XbusStatus|=CDST_ERRO;
 			MEIStatus=MEI_CDROM_recv_ecc;
-			Status[1]=XbusStatus;
+			Status.data[1]=XbusStatus;
 		}
 
 		Poll|=POLST;
@@ -1036,26 +1130,26 @@ void cdrom_Device::DoCommand()
 		//55=rfu1; //ignore
 		//66=rfu2  //ignore
 
-		StatusLen=8;//CMD+status+DRVSTAT
-		Status[0]=0x8d;
+		Status.Load(8);//CMD+status+DRVSTAT
+		Status.data[0]=0x8d;
 		if((XbusStatus&CDST_TRAY) && (XbusStatus&CDST_DISC))
 		{
-			Status[1]=0x00;
-			Status[2]=0x0;//DISC.sesmsf[0];//min
-			Status[3]=0x2;//DISC.sesmsf[1];//sec
-			Status[4]=0x0;//DISC.sesmsf[2];//fra
-			Status[5]=0x00;
+			Status.data[1]=0x00;
+			Status.data[2]=0x0;//DISC.sesmsf[0];//min
+			Status.data[3]=0x2;//DISC.sesmsf[1];//sec
+			Status.data[4]=0x0;//DISC.sesmsf[2];//fra
+			Status.data[5]=0x00;
 			XbusStatus|=CDST_RDY;
-			Status[6]=0x00;
-			Status[7]=XbusStatus;
+			Status.data[6]=0x00;
+			Status.data[7]=XbusStatus;
 			MEIStatus=MEI_CDROM_no_error;
 
 		}
 		else
 		{
-			StatusLen=2;//CMD+status+DRVSTAT
+			Status.Load(2);//CMD+status+DRVSTAT
 			XbusStatus|=CDST_ERRO;
-			Status[1]=XbusStatus;
+			Status.data[1]=XbusStatus;
 			MEIStatus=MEI_CDROM_recv_ecc;
 
 		}
@@ -1072,10 +1166,10 @@ void cdrom_Device::DoCommand()
 		break;
 	case 0x93:
 		//?????
-		StatusLen=4;
-		Status[0]=0x0;
-		Status[1]=0x0;
-		Status[2]=0x0;
+		Status.Load(4);
+		Status.data[0]=0x0;
+		Status.data[1]=0x0;
+		Status.data[2]=0x0;
 
 		if((XbusStatus&CDST_TRAY) && (XbusStatus&CDST_DISC))
 		{
@@ -1091,7 +1185,7 @@ void cdrom_Device::DoCommand()
 
 		Poll|=POLST; //status is valid
 
-		Status[3]=XbusStatus;
+		Status.data[3]=XbusStatus;
 
 		break;
 	default:
@@ -1152,34 +1246,20 @@ void cdrom_Device::MSF2LBA()
 
 unsigned char * cdrom_Device::GetDataPtr()
 {
-	return Data;
+	return &Data.data[Data.head&(REQSIZE-1)];
 }
 
 unsigned int cdrom_Device::GetDataLen()
 {
-	return DataLen;
+	return Data.Count();
 }
 
 void cdrom_Device::ClearDataPoll(unsigned int len)
 {
-	if((int)len<=DataLen)
-	{
-		if(DataLen>0)
-		{
-			DataLen-=len;
-			if(DataLen>0)
-				memcpy(Data,Data+4,len);
-			else
-			{
-				Poll&=~POLDT;
-			}
-		}
-	}
-	else
-	{
+	if(len<=Data.Count())
+		Data.Skip(len);
+	if(Data.IsEmpty())
 		Poll&=~POLDT;
-
-	}
 }
 
 
@@ -1191,7 +1271,7 @@ bool cdrom_Device::InitCD()
 
 		//fseek(fiso,0,SEEK_END);
                 curr_sector=0;
-		_3do_OnSector(0);
+		_cdcache_Flush();   // new disc
 		//filesize=800000000;//ftell(fiso);
 
 		filesize=_3do_DiscSize()+150;
@@ -1251,65 +1331,19 @@ unsigned char  *  cdrom_Device::GetBytes(unsigned int len)
 	//retmem=Data;
         (void)len;
 
-	return Data;
+	return GetDataPtr();
 }
 
 unsigned int cdrom_Device::GedWord()
 {
-	unsigned int res;
-	res=0;
-
-
-	if(DataLen>0)
-	{
-		//res=(unsigned char)Data[0];
-		//res
-		res=(Data[0]<<24)+(Data[1]<<16)+(Data[2]<<8)+Data[3];
-		if(DataLen<3)
-		{
-			DataLen--;
-			if(DataLen>0)
-				memcpy(Data,Data+1,DataLen);
-			else
-			{
-				Poll&=~POLDT;
-				DataLen=0;
-			}
-			DataLen--;
-			if(DataLen>0)
-				memcpy(Data,Data+1,DataLen);
-			else
-			{
-				Poll&=~POLDT;
-				DataLen=0;
-			}
-			DataLen--;
-			if(DataLen>0)
-				memcpy(Data,Data+1,DataLen);
-			else
-			{
-				Poll&=~POLDT;
-				DataLen=0;
-			}
-		}
-		else
-		{
-			//DataLen-=4;
-			{
-				memcpy(Data,Data+4,DataLen-4);
-				DataLen-=4;
-			}
+	unsigned char word[4]={0,0,0,0};
 
-			if(DataLen<=0)
-			{
-				DataLen=0;
-				Poll&=~POLDT;
-			}
-		}
-
-	}
+	// Big-endian; a short tail reads as zeroes.
+	Data.Read(word,4);
+	if(Data.IsEmpty())
+		Poll&=~POLDT;
 
-	return res;
+	return (word[0]<<24)+(word[1]<<16)+(word[2]<<8)+word[3];
 }
 
 
@@ -1343,6 +1377,11 @@ void* _xbplug_MainDevice(int proc, void* data)
 		return (void*)isodrive.TestFIQ();
 	case XBP_GET_DATA:
 		return (void*)isodrive.GetDataFifo();
+	case XBP_CLOCK:
+		return (void*)isodrive.Clock((int)data);
+	case XBP_GET_DATA_BLOCK:
+		((XBUSDataBlock*)data)->len=isodrive.GetDataBlock(((XBUSDataBlock*)data)->data,((XBUSDataBlock*)data)->len);
+		return (void*)true;
 	case XBP_GET_STATUS:
 		return (void*)isodrive.GetStatusFifo();
 	case XBP_SET_POLL:
@@ -36,11 +36,22 @@ Felix Lazarev
 #define XBP_SELECT		9   //selects device by Opera
 #define XBP_RESERV		10  //reserved reading from device
 #define XBP_DESTROY		11  //plugin destroy
+#define XBP_GET_DATA_BLOCK	12  //XBUS, fills an XBUSDataBlock and sets its len to the bytes there were, returns !NULL if supported
+#define XBP_CLOCK		13  //datum ARM cycles went by, returns !NULL if the poll bits changed
 
 #define XBP_GET_SAVESIZE	19	//save support from emulator side
 #define XBP_GET_SAVEDATA	20
 #define XBP_SET_SAVEDATA	21
 
+// Bulk read of len data FIFO bytes, in the order XBP_GET_DATA returns them.
+// A device may hand over fewer if more data is on its way; it raises the
+// data poll again when the rest is there.
+struct XBUSDataBlock
+{
+	unsigned char *data;
+	unsigned int len;
+};
+
 #ifdef XBUS_EXPORTS
 #define XBUS_API __declspec(dllexport)
 #else
@@ -2616,6 +2616,7 @@ __inline uint16 readPIX(uint32 src, int i, int j)
 __inline void writePIX(uint32 src, int i, int j, uint16 pix)
 {
 	src+=XY2OFF((((j)>>(RESSCALE))<<2),(i>>RESSCALE),WMOD);
+	_mem_MarkDirty(src);
 	if(RESSCALE)
 		*((uint16*)&Mem[(src^2)+(((i&1)<<1)+((j)&1))*1024*1024])=pix;
 	else
@@ -84,6 +84,7 @@ void __fastcall _sport_WriteAccess(unsigned int index, unsigned int mask)
 	{
                 index&=0x7ff;
                 index<<=7;
+                _mem_MarkDirtyRange(0x200000+index*4,2048);
                 if(mask == 0xFFFFffff)
 		{
 			for(i=0;i<512;i++)
@@ -111,6 +112,7 @@ void __fastcall _sport_WriteAccess(unsigned int index, unsigned int mask)
 	if(!(index & ~0x1FFF)) //SPORT copy page
 	{
                 gSPORTDESTINATION=(index &0x7ff)<<7;
+                _mem_MarkDirtyRange(0x200000+gSPORTDESTINATION*4,2048);
                 if(mask == 0xFFFFffff)
 		{
 			memcpy(&((unsigned int*)VRAM)[gSPORTDESTINATION],&((unsigned int*)VRAM)[gSPORTSOURCE],512*4);
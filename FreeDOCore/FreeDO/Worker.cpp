@@ -14,6 +14,8 @@ Worker::Worker(void (*workerFunction)(void*), void* workerFunctionArgument)
 
 Worker::~Worker()
 {
+	CloseHandle(this->threadHandle);
+	CloseHandle(this->startEvent);
 }
 
 void Worker::Run()
@@ -40,4 +42,4 @@ unsigned int __stdcall ThreadEntry(void* classInstance)
 {
 	((Worker*)classInstance)->_ThreadFunction();
 	return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
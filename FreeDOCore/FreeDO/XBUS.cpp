@@ -28,6 +28,7 @@ Felix Lazarev
 #include "freedoconfig.h"
 //#include "astring.h"
 #include "XBUS.h"
+#include "XBUSFifo.h"
 #include "Clio.h"
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -40,10 +41,8 @@ unsigned char XBSEL;
 unsigned char XBSELH;
 unsigned char POLF;
 unsigned char POLDEVF;
-unsigned char STDEVF[255];  //status of devices
-unsigned char STLENF; //pointer in fifo
-unsigned char CmdF[7];
-unsigned char CmdPtrF;
+XBUSFifo<256> STDEVF;  //status of devices
+XBUSFifo<8> CmdF;
 };
 #pragma pack(pop)
 
@@ -52,12 +51,13 @@ unsigned char CmdPtrF;
 #define POLF xbus.POLF
 #define POLDEVF xbus.POLDEVF
 #define STDEVF xbus.STDEVF
-#define STLENF xbus.STLENF
 #define CmdF xbus.CmdF
-#define CmdPtrF xbus.CmdPtrF
 
 static XBUSDatum xbus;
 static _xbus_device xdev[16];
+static unsigned int xbusCycles;
+
+#define XBUS_CLOCK_STEP	1024	// ARM cycles between two device clocks
 
 #define POLSTMASK	0x01
 #define POLDTMASK	0x02
@@ -80,16 +80,11 @@ void _xbus_SetCommandFIFO(unsigned int val)
 	}
 	else if(XBSEL==0xf)
 	{
-		if (CmdPtrF<7)
-		{
-			CmdF[CmdPtrF]=(unsigned char)val;
-			CmdPtrF++;
-
-		}
-		if(CmdPtrF>=7)
+		CmdF.Push((unsigned char)val);
+		if(CmdF.Count()>=7)
 		{
 			ExecuteCommandF();
-			CmdPtrF=0;
+			CmdF.Clear();
 		}
 	}
 
@@ -106,6 +101,42 @@ unsigned int _xbus_GetDataFIFO()
 		return 0;
 }
 
+unsigned int _xbus_GetDataBlock(unsigned char *buff, unsigned int len)
+{
+	if(xdev[XBSEL])
+	{
+		XBUSDataBlock block;
+		block.data=buff;
+		block.len=len;
+		if((*xdev[XBSEL])(XBP_GET_DATA_BLOCK,&block))
+			return block.len;
+	}
+
+	// Devices without the bulk call are read a byte at a time.
+	for(unsigned int i=0;i<len;i++)
+		buff[i]=(unsigned char)_xbus_GetDataFIFO();
+	return len;
+}
+
+void _xbus_Clock(unsigned int cycles)
+{
+	xbusCycles+=cycles;
+	if(xbusCycles<XBUS_CLOCK_STEP)
+		return;
+
+	for(int i=0;i<15;i++)
+	{
+		if(xdev[i] && (*xdev[i])(XBP_CLOCK,(void*)xbusCycles))
+		{
+			// A DMA waiting on this device takes the new data first.
+			if(i==XBSEL)
+				_clio_ResumeXBusDMA();
+			if((*xdev[i])(XBP_FIQ,NULL)) _clio_GenerateFiq(4,0);
+		}
+	}
+	xbusCycles=0;
+}
+
 unsigned int _xbus_GetPoll()
 {
 
@@ -131,21 +162,21 @@ unsigned int _xbus_GetRes()
 
 void ExecuteCommandF()
 {
-		if(CmdF[0]==0x83)
+		if(CmdF.Peek(0)==0x83)
 		{
-			STLENF=12;
-			STDEVF[0]=0x83;
-			STDEVF[1]=0x01;
-			STDEVF[2]=0x01;
-			STDEVF[3]=0x01;
-			STDEVF[4]=0x01;
-			STDEVF[5]=0x01;
-			STDEVF[6]=0x01;
-			STDEVF[7]=0x01;
-			STDEVF[8]=0x01;
-			STDEVF[9]=0x01;
-			STDEVF[10]=0x01;
-			STDEVF[11]=0x01;
+			STDEVF.Load(12);
+			STDEVF.data[0]=0x83;
+			STDEVF.data[1]=0x01;
+			STDEVF.data[2]=0x01;
+			STDEVF.data[3]=0x01;
+			STDEVF.data[4]=0x01;
+			STDEVF.data[5]=0x01;
+			STDEVF.data[6]=0x01;
+			STDEVF.data[7]=0x01;
+			STDEVF.data[8]=0x01;
+			STDEVF.data[9]=0x01;
+			STDEVF.data[10]=0x01;
+			STDEVF.data[11]=0x01;
 			POLDEVF|=POLST;
 		}
 	   if(((POLDEVF&POLST) && (POLDEVF&POLSTMASK)) || ((POLDEVF&POLDT) && (POLDEVF&POLDTMASK)))
@@ -166,19 +197,11 @@ unsigned int _xbus_GetStatusFIFO()
 	}
 	else if(XBSEL==0xf)
 	{
-		if(STLENF>0)
+		if(!STDEVF.IsEmpty())
 		{
-			res=STDEVF[0];
-			STLENF--;
-			if(STLENF>0)
-			{
-				for(int i=0;i<STLENF;i++)
-					STDEVF[i]=STDEVF[i+1];
-			}
-			else
-			{
-					POLDEVF&=~POLST;
-			}
+			res=STDEVF.Pop();
+			if(STDEVF.IsEmpty())
+				POLDEVF&=~POLST;
 		}
 		return res;
 	}
@@ -216,6 +239,8 @@ void _xbus_Init(_xbus_device zero_dev)
 	int i;
 
 	POLF=0xf;
+	STDEVF.Clear();
+	CmdF.Clear();
 
 	for(i=0;i<15;i++)
         {
@@ -47,6 +47,10 @@ typedef void* (*_xbus_device)(int, void*);
 	unsigned int _xbus_GetRes();
 	unsigned int _xbus_GetPoll();
 	unsigned int _xbus_GetDataFIFO();
+	unsigned int _xbus_GetDataBlock(unsigned char *buff, unsigned int len); //returns the bytes read
+
+	// Lets the devices run their scheduled work (seeks, sector reads).
+	void _xbus_Clock(unsigned int cycles);
 
 unsigned int _xbus_SaveSize();
 void _xbus_Save(void *buff);
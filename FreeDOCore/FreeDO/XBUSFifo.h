@@ -0,0 +1,61 @@
+// XBUSFifo.h - Byte FIFOs for the status, data and command queues of the
+// XBUS devices.
+//
+// A ring with free-running head and tail indices: taking a byte or a block
+// out never moves the bytes behind it. It is plain data, so devices that
+// are saved with memcpy can hold their FIFOs directly.
+
+#ifndef	XBUSFIFO_3DO_HEADER
+#define XBUSFIFO_3DO_HEADER
+
+#include <memory.h>
+
+template <unsigned int SIZE> struct XBUSFifo	// SIZE is a power of two
+{
+	unsigned char data[SIZE];
+	unsigned int head;		// next byte to read
+	unsigned int tail;		// next byte to write
+
+	void Clear() { head=tail=0; }
+	unsigned int Count() const { return tail-head; }
+	bool IsEmpty() const { return head==tail; }
+
+	// Makes the FIFO hold the first len bytes of data, for a device that
+	// builds a whole reply or sector in place.
+	void Load(unsigned int len) { head=0; tail=len; }
+
+	bool Push(unsigned char val)
+	{
+		if(Count()>=SIZE)
+			return false;
+		data[tail++&(SIZE-1)]=val;
+		return true;
+	}
+
+	// An empty FIFO reads as zero, as the devices always answered.
+	unsigned char Pop()
+	{
+		if(head==tail)
+			return 0;
+		return data[head++&(SIZE-1)];
+	}
+
+	unsigned char Peek(unsigned int i) const { return data[(head+i)&(SIZE-1)]; }
+
+	void Skip(unsigned int len) { head+=(len<Count())?len:Count(); }
+
+	// Takes up to len bytes, in at most two copies; returns how many.
+	unsigned int Read(unsigned char *buff, unsigned int len)
+	{
+		if(len>Count())
+			len=Count();
+		unsigned int start=head&(SIZE-1);
+		unsigned int first=(SIZE-start<len)?SIZE-start:len;
+		memcpy(buff,data+start,first);
+		memcpy(buff+first,data,len-first);
+		head+=len;
+		return len;
+	}
+};
+
+#endif
@@ -34,10 +34,17 @@ Felix Lazarev
 #include "XBUS.h"
 #include "DiagPort.h"
 #include "quarz.h"
+#include "capture.h"
+#include "audio.h"
+#include "audiocap.h"
+#include "cdcache.h"
+#include "disc.h"
+#include "cdtrace.h"
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
+#include <string.h>
 
 _ext_Interface  io_interface;
 
@@ -57,6 +64,7 @@ __inline uint32 _bswap(uint32 x)
 
 
 extern void* _xbplug_MainDevice(int proc, void* data);
+static void HashRom();
 int _3do_Init()
 {
 	unsigned char *Memory;
@@ -73,11 +81,15 @@ int _3do_Init()
 	_sport_Init(Memory+0x200000);  // Visible only VRAM to it
 	_madam_Init(Memory);
 
+	_cdcache_Init();
 	_xbus_Init(_xbplug_MainDevice);
 
 	_clio_Init(0x40); // 0x40 for start from  3D0-CD, 0x01/0x02 from PhotoCD ?? (NO use 0x40/0x02 for BIOS test)
 	_dsp_Init();
 	_frame_Init();
+	_capture_Init();
+	_audio_Init();
+	_audiocap_Init();
 	_diag_Init(-1);  // Select test, use -1 -- if d'nt need tests
 /*
 00	DIAGNOSTICS TEST	(run of test: 1F, 24, 25, 32, 50, 51, 60, 61, 62, 68, 71, 75, 80, 81, 90)
@@ -111,26 +123,28 @@ FF	TEST END (halt)
 
 	_qrz_Init();
 
+	HashRom();
+
 	return 0;
 }
 
 
-VDLFrame *curr_frame;
 bool scipframe;
 void _3do_InternalFrame(int cicles)
 {
 	int line;
 	_qrz_PushARMCycles(cicles);
+	_xbus_Clock(cicles);
 	if(_qrz_QueueDSP())
 	{
-		io_interface(EXT_PUSH_SAMPLE,(void*)_dsp_Loop());
+		_audio_PushSample(_dsp_Loop());
 	}
 	if(_qrz_QueueTimer())_clio_DoTimers();
 	if(_qrz_QueueVDL())
 	{
 		line=_qrz_VDCurrLine();
 		_clio_UpdateVCNT(line, _qrz_VDHalfFrame());
-		if(!scipframe)_vdl_DoLineNew(line,curr_frame);
+		_vdl_DoLineNew(line,_vdl_ScanFrame());
 		if(line==16 && scipframe) io_interface(EXT_FRAMETRIGGER_MT,NULL);
 		if(line==_clio_v0line())
 		{
@@ -140,21 +154,20 @@ void _3do_InternalFrame(int cicles)
 		{
 			_clio_GenerateFiq(1<<1,0);
 			_madam_KeyPressed((unsigned char*)io_interface(EXT_GETP_PBUSDATA,NULL),(int)io_interface(EXT_GET_PBUSLEN,NULL));
-			curr_frame->srcw=320;
-			curr_frame->srch=240;
-			if(!scipframe)curr_frame=(VDLFrame*)io_interface(EXT_SWAPFRAME,curr_frame);
-			//if(!scipframe)io_interface(EXT_SWAPFRAME,curr_frame);
+			VDLFrame *done=_vdl_SwapFrame();
+			_capture_Frame(done);
+			if(!scipframe)io_interface(EXT_SWAPFRAME,done);
 		}
 	}
 }
 
-void __fastcall _3do_Frame(VDLFrame *frame, bool __scipframe=false)
+void __fastcall _3do_Frame(bool __scipframe=false)
 {
 	int i,cnt=0;
 
-	curr_frame=frame;
 	scipframe=__scipframe;
 	if(flagtime)flagtime--;
+	_cdtrace_Frame();
 
 	for(i=0;i<(12500000/60);)
 	{
@@ -171,62 +184,259 @@ void __fastcall _3do_Frame(VDLFrame *frame, bool __scipframe=false)
 
 	}
 
+	_audio_Flush();
+
 }
 
+static unsigned int saveBase;      // the base RAM changes are tracked against, 0 for none
+
 void _3do_Destroy()
 {
+	saveBase=0;
 	_arm_Destroy();
 	_xbus_Destroy();
+	_cdtrace_Stop(NULL);
+	_cdcache_Destroy();
+	_audiocap_Destroy();
+	_audio_Destroy();
+	_capture_Destroy();
+	_vdl_Destroy();
+}
+
+//------------------------------------------------------------------------------
+// Save states
+//
+// A state is a header followed by tagged chunks, one per device:
+//
+//   StateHeader   "4DOS", format version, total length, chunk count
+//   per chunk     StateChunk (tag, length), then length bytes padded to 4
+//
+// The BIOS is not saved; ROMH holds a hash of it and a state taken with
+// another BIOS is refused. An incremental state has ARMI in place of ARM
+// and a BASE chunk naming the base it was taken against.
+//
+// Loading finds every chunk the core needs and checks its length against
+// what the device expects before anything is overwritten, so a damaged or
+// foreign state leaves the machine as it was. Chunks the core does not
+// know are skipped, so later versions can add some. States in the flat
+// layout that came before still load.
+
+#define STATE_MAGIC             0x534F4434      // "4DOS"
+#define STATE_VERSION           1
+#define STATE_LEGACY_MAGIC      0x97970102
+#define STATE_PAD(n)            (((n)+3)&~3)
+
+#pragma pack(push,1)
+struct StateHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int length;     // header included
+	unsigned int chunkCount;
+};
+struct StateChunk
+{
+	char tag[4];
+	unsigned int length;     // without the padding
+};
+#pragma pack(pop)
+
+struct DeviceChunk
+{
+	char tag[5];
+	unsigned int (*size)();
+	void (*save)(void *buff);
+	void (*load)(void *buff);
+};
+
+static const DeviceChunk deviceChunks[]=
+{
+	{"VDLP",_vdl_SaveSize,_vdl_Save,_vdl_Load},
+	{"DSP ",_dsp_SaveSize,_dsp_Save,_dsp_Load},
+	{"CLIO",_clio_SaveSize,_clio_Save,_clio_Load},
+	{"QRZ ",_qrz_SaveSize,_qrz_Save,_qrz_Load},
+	{"SPRT",_sport_SaveSize,_sport_Save,_sport_Load},
+	{"MADM",_madam_SaveSize,_madam_Save,_madam_Load},
+	{"XBUS",_xbus_SaveSize,_xbus_Save,_xbus_Load},
+};
+#define DEVICE_CHUNKS           (sizeof(deviceChunks)/sizeof(deviceChunks[0]))
+
+static unsigned char romHash[8];   // FNV-1a of the BIOS as loaded
+
+static void HashRom()
+{
+	unsigned char *rom=(unsigned char*)Getp_ROMS();
+	unsigned long long hash=14695981039346656037ULL;
+
+	for(int i=0;i<1024*1024*2;i++)
+		hash=(hash^rom[i])*1099511628211ULL;
+	for(int i=0;i<8;i++)
+		romHash[i]=(unsigned char)(hash>>(i*8));
 }
 
 unsigned int _3do_SaveSize()
 {
-	unsigned int tmp;
-	tmp=_arm_SaveSize();
-	tmp+=_vdl_SaveSize();
-	tmp+=_dsp_SaveSize();
-	tmp+=_clio_SaveSize();
-	tmp+=_qrz_SaveSize();
-	tmp+=_sport_SaveSize();
-	tmp+=_madam_SaveSize();
-	tmp+=_xbus_SaveSize();
-	tmp+=16*4;
+	unsigned int tmp,armSize;
+	armSize=_arm_SaveSize();
+	if(_arm_SaveIncrementalSize()>armSize)armSize=_arm_SaveIncrementalSize();
+
+	tmp=sizeof(StateHeader);
+	tmp+=sizeof(StateChunk)+sizeof(romHash);
+	tmp+=sizeof(StateChunk)+sizeof(saveBase);
+	tmp+=sizeof(StateChunk)+STATE_PAD(armSize);
+	for(unsigned int i=0;i<DEVICE_CHUNKS;i++)
+		tmp+=sizeof(StateChunk)+STATE_PAD(deviceChunks[i].size());
 	return tmp;
 }
-void _3do_Save(void *buff)
+
+// Fills in the header of a chunk whose data is already in place after it,
+// and returns where the next one goes.
+static unsigned char* EndChunk(unsigned char *out, const char *tag, unsigned int length)
+{
+	StateChunk *chunk=(StateChunk*)out;
+	memcpy(chunk->tag,tag,4);
+	chunk->length=length;
+	memset(out+sizeof(StateChunk)+length,0,STATE_PAD(length)-length);
+	return out+sizeof(StateChunk)+STATE_PAD(length);
+}
+
+static unsigned int SaveChunks(void *buff, bool incremental)
 {
-	unsigned char *data=(unsigned char*)buff;
-	int *indexes=(int*)buff;
-
-	indexes[0]=0x97970101;
-	indexes[1]=16*4;
-	indexes[2]=indexes[1]+_arm_SaveSize();
-	indexes[3]=indexes[2]+_vdl_SaveSize();
-	indexes[4]=indexes[3]+_dsp_SaveSize();
-	indexes[5]=indexes[4]+_clio_SaveSize();
-	indexes[6]=indexes[5]+_qrz_SaveSize();
-	indexes[7]=indexes[6]+_sport_SaveSize();
-	indexes[8]=indexes[7]+_madam_SaveSize();
-	indexes[9]=indexes[8]+_xbus_SaveSize();
-
-	_arm_Save(&data[indexes[1]]);
-	_vdl_Save(&data[indexes[2]]);
-	_dsp_Save(&data[indexes[3]]);
-	_clio_Save(&data[indexes[4]]);
-	_qrz_Save(&data[indexes[5]]);
-	_sport_Save(&data[indexes[6]]);
-	_madam_Save(&data[indexes[7]]);
-	_xbus_Save(&data[indexes[8]]);
+	StateHeader *header=(StateHeader*)buff;
+	unsigned char *out=(unsigned char*)buff+sizeof(StateHeader);
+	unsigned int i;
+
+	header->magic=STATE_MAGIC;
+	header->version=STATE_VERSION;
+	header->chunkCount=3+DEVICE_CHUNKS;
+
+	memcpy(out+sizeof(StateChunk),romHash,sizeof(romHash));
+	out=EndChunk(out,"ROMH",sizeof(romHash));
 
+	if(incremental)
+	{
+		memcpy(out+sizeof(StateChunk),&saveBase,sizeof(saveBase));
+		out=EndChunk(out,"BASE",sizeof(saveBase));
+		out=EndChunk(out,"ARMI",_arm_SaveIncremental(out+sizeof(StateChunk)));
+	}
+	else
+	{
+		header->chunkCount--;
+		_arm_Save(out+sizeof(StateChunk));
+		out=EndChunk(out,"ARM ",_arm_SaveSize());
+	}
+
+	for(i=0;i<DEVICE_CHUNKS;i++)
+	{
+		deviceChunks[i].save(out+sizeof(StateChunk));
+		out=EndChunk(out,deviceChunks[i].tag,deviceChunks[i].size());
+	}
+
+	header->length=out-(unsigned char*)buff;
+	return header->length;
 }
 
-bool _3do_Load(void *buff)
+unsigned int _3do_Save(void *buff)
 {
-	unsigned char *data=(unsigned char*)buff;
-	int *indexes=(int*)buff;
-	if((unsigned int)indexes[0]!=0x97970101)return false;
+	return SaveChunks(buff,false);
+}
+
+// Incremental states are only meaningful while the core keeps their base,
+// so lastSaveBase is never reused within a process.
+static unsigned int lastSaveBase;
 
-	_arm_Load(&data[indexes[1]]);
+unsigned int _3do_SetSaveBase()
+{
+	_arm_SetSaveBase();
+	saveBase=++lastSaveBase;
+	return saveBase;
+}
+
+unsigned int _3do_SaveIncremental(void *buff)
+{
+	if(!saveBase)return 0;
+	return SaveChunks(buff,true);
+}
+
+// The data of the chunk with the given tag, or NULL if it is missing or
+// its length is not the one given (any length when it is 0).
+static unsigned char* FindChunk(unsigned char *state, const char *tag, unsigned int length, unsigned int *found)
+{
+	StateHeader *header=(StateHeader*)state;
+	unsigned int at=sizeof(StateHeader);
+
+	for(unsigned int i=0;i<header->chunkCount;i++)
+	{
+		StateChunk *chunk=(StateChunk*)(state+at);
+		if(header->length-at<sizeof(StateChunk) || chunk->length>header->length-at-sizeof(StateChunk))
+			return NULL;
+		if(!memcmp(chunk->tag,tag,4))
+		{
+			if(length && chunk->length!=length)
+				return NULL;
+			if(found)*found=chunk->length;
+			return state+at+sizeof(StateChunk);
+		}
+		at+=sizeof(StateChunk)+STATE_PAD(chunk->length);
+		if(at>header->length)
+			return NULL;
+	}
+	return NULL;
+}
+
+static bool LoadChunks(unsigned char *state, unsigned int length)
+{
+	StateHeader *header=(StateHeader*)state;
+	unsigned char *rom,*base,*arm,*devices[DEVICE_CHUNKS];
+	unsigned int armLength,i;
+
+	if(length<sizeof(StateHeader))return false;
+	if(header->version!=STATE_VERSION || header->length<sizeof(StateHeader) || header->length>length)return false;
+
+	rom=FindChunk(state,"ROMH",sizeof(romHash),NULL);
+	if(!rom || memcmp(rom,romHash,sizeof(romHash)))return false;
+
+	for(i=0;i<DEVICE_CHUNKS;i++)
+	{
+		devices[i]=FindChunk(state,deviceChunks[i].tag,deviceChunks[i].size(),NULL);
+		if(!devices[i])return false;
+	}
+
+	arm=FindChunk(state,"ARM ",_arm_SaveSize(),NULL);
+	if(arm)
+		_arm_Load(arm);
+	else
+	{
+		base=FindChunk(state,"BASE",sizeof(saveBase),NULL);
+		arm=FindChunk(state,"ARMI",0,&armLength);
+		if(!saveBase || !base || !arm || memcmp(base,&saveBase,sizeof(saveBase)))return false;
+		if(!_arm_LoadIncremental(arm,armLength))return false;
+	}
+
+	for(i=0;i<DEVICE_CHUNKS;i++)
+		deviceChunks[i].load(devices[i]);
+
+	return true;
+}
+
+// The flat layout: indexes[1..8] are where the ARM block and each device's
+// block start, indexes[9] where the last one ends. Every block has to be
+// exactly the size the device takes now; a state from before a device's
+// layout changed is refused rather than loaded misaligned.
+static bool LoadLegacy(unsigned char *data, unsigned int length)
+{
+	unsigned int *indexes=(unsigned int*)data;
+	unsigned int i;
+
+	if(length<16*4 || indexes[1]!=16*4 || indexes[9]>length)return false;
+	if(indexes[2]<indexes[1] || indexes[2]-indexes[1]!=_arm_LegacySaveSize())return false;
+	for(i=0;i<DEVICE_CHUNKS;i++)
+	{
+		if(indexes[i+3]<indexes[i+2] || indexes[i+3]-indexes[i+2]!=deviceChunks[i].size())
+			return false;
+	}
+
+	_arm_LoadLegacy(&data[indexes[1]]);
 	_vdl_Load(&data[indexes[2]]);
 	_dsp_Load(&data[indexes[3]]);
 	_clio_Load(&data[indexes[4]]);
@@ -238,6 +448,32 @@ bool _3do_Load(void *buff)
 	return true;
 }
 
+// length is how much of buff holds the state; nothing is read past it.
+bool _3do_Load(void *buff, unsigned int length)
+{
+	unsigned int magic;
+
+	if(length<sizeof(magic))return false;
+	magic=*(unsigned int*)buff;
+
+	if(magic==STATE_MAGIC)
+		return LoadChunks((unsigned char*)buff,length);
+	if(magic==STATE_LEGACY_MAGIC)
+		return LoadLegacy((unsigned char*)buff,length);
+	return false;
+}
+
+static void* LoadState(void *buff, unsigned int length)
+{
+	if(!_3do_Load(buff,length))
+		return NULL;
+
+	cnbfix=1;
+	sf=0;
+	_cdtrace_StateLoaded();
+	return (void*)1;
+}
+
 
 //------------------------------------------------------------------------------
 extern uint32 *profiling;
@@ -254,6 +490,8 @@ void _3do_Read2048(void *buff)
 
 unsigned int _3do_DiscSize()
 {
+	if(_disc_IsOpen())
+		return _disc_BlockCount();
 	return (unsigned int)io_interface(EXT_GET_DISC_SIZE,NULL);
 }
 
@@ -268,10 +506,10 @@ int sdf=0;
 int unknownflag11=0;
 int jw=0;
 int cnbfix=0;
+int cdtiming=CD_TIMING_TURBO;
 
 FREEDOCORE_API void* __stdcall _freedo_Interface(int procedure, void *datum)
 {
-	int line;
 	switch(procedure)
 	{
 	case FDP_INIT:
@@ -283,24 +521,25 @@ FREEDOCORE_API void* __stdcall _freedo_Interface(int procedure, void *datum)
 		_3do_Destroy();
 		break;
 	case FDP_DO_EXECFRAME:
-		_3do_Frame((VDLFrame*)datum);
+		_3do_Frame();
 		break;
 	case FDP_DO_EXECFRAME_MT:
-		_3do_Frame((VDLFrame*)datum, true);
+		_3do_Frame(true);
 		break;
 	case FDP_DO_FRAME_MT:
-		line=0;
-		while(line<256)_vdl_DoLineNew(line++,(VDLFrame*)datum);
+		_vdl_CopyDisplayFrame((VDLFrame*)datum);
 		break;
+	case FDP_GETP_FRAME:
+		return _vdl_GetDisplayFrame();
 	case FDP_GET_SAVE_SIZE:
 		return (void*)_3do_SaveSize();
 	case FDP_DO_SAVE:
-		_3do_Save(datum);
-		break;
+		return (void*)_3do_Save(datum);
 	case FDP_DO_LOAD:
-		cnbfix=1;
-		sf=0;
-		return (void*)_3do_Load(datum);
+		// No length; the caller vouches for the buffer.
+		return LoadState(datum,0xFFFFFFFF);
+	case FDP_DO_LOAD_BUFFER:
+		return LoadState(((StateBuffer*)datum)->data,((StateBuffer*)datum)->length);
 	case FDP_GETP_NVRAM:
 		return Getp_NVRAM();
 	case FDP_GETP_RAMS:
@@ -320,6 +559,12 @@ FREEDOCORE_API void* __stdcall _freedo_Interface(int procedure, void *datum)
 	case FDP_SET_FIX_MODE:
 		fixmode=(int)datum;
 		break;
+	case FDP_SET_CD_TIMING:
+		// SectorCycles divides by it, so only the modes there are.
+		if((int)datum!=CD_TIMING_TURBO && (int)datum!=CD_TIMING_1X && (int)datum!=CD_TIMING_2X)
+			return NULL;
+		cdtiming=(int)datum;
+		return (void*)1;
 	case FDP_GET_FRAME_BITMAP:
 		{GetFrameBitmapParams* param = (GetFrameBitmapParams*)datum;
 		Get_Frame_Bitmap(
@@ -336,6 +581,44 @@ FREEDOCORE_API void* __stdcall _freedo_Interface(int procedure, void *datum)
 			, &param->resultingWidth
 			, &param->resultingHeight);}
 		break;
+	case FDP_GET_SCALER_INFO:
+		return (void*)_frame_GetScalerInfo((ScalerInfo*)datum);
+	case FDP_CAPTURE_START:
+		return (void*)_capture_Start((const char*)datum);
+	case FDP_CAPTURE_STOP:
+		return (void*)_capture_Stop();
+	case FDP_AUDIO_SET_RATE:
+		_audio_SetOutputRate((int)datum);
+		break;
+	case FDP_AUDIO_READ:
+		return (void*)_audio_ReadOutput(((SampleBlock*)datum)->samples,((SampleBlock*)datum)->count);
+	case FDP_AUDIO_GET_BUFFERED:
+		return (void*)_audio_Buffered();
+	case FDP_AUDIO_WAIT:
+		return (void*)_audio_WaitBelow((int)datum);
+	case FDP_AUDIO_CAPTURE_START:
+		return (void*)_audiocap_Start((const char*)datum);
+	case FDP_AUDIO_CAPTURE_STOP:
+		return (void*)_audiocap_Stop();
+	case FDP_DISC_OPEN:
+		return (void*)_disc_Open((const char*)datum);
+	case FDP_DISC_CLOSE:
+		_disc_Close();
+		break;
+	case FDP_DISC_READ:
+		return (void*)_disc_Read(((DiscSectorRequest*)datum)->sector,((DiscSectorRequest*)datum)->buffer);
+	case FDP_DISC_COMPRESS:
+		return (void*)_disc_Compress(((DiscCompressRequest*)datum)->source,((DiscCompressRequest*)datum)->target);
+	case FDP_SECTOR_TRACE_START:
+		return (void*)_cdtrace_Start();
+	case FDP_SECTOR_TRACE_STOP:
+		return (void*)_cdtrace_Stop((SectorTraceRequest*)datum);
+	case FDP_SECTOR_PRELOAD:
+		return (void*)_cdtrace_Preload((const char*)datum);
+	case FDP_SET_SAVE_BASE:
+		return (void*)_3do_SetSaveBase();
+	case FDP_DO_SAVE_INCREMENTAL:
+		return (void*)_3do_SaveIncremental(datum);
 	case FDP_GET_BIOS_TYPE:
 		return (void*)isanvil;
 	case FDP_SET_ANVIL:
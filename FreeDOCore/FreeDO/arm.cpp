@@ -115,6 +115,8 @@ const static uint16 cond_flags_cross[]={   //((cond_flags_cross[cond_feald]>>fla
 #define RAMSIZE     3*1024*1024 //dram1+dram2+vram
 #define ROMSIZE     1*1024*1024 //rom
 #define NVRAMSIZE   (65536>>1)		//nvram at 0x03140000...0x317FFFF
+#define RAMALLOC    (RAMSIZE+1024*1024*16) //with the high-res VRAM copies
+#define RAMPAGES    (RAMSIZE>>MEM_PAGE_SHIFT)
 #define REG_PC	RON_USER[15]
 #define UNDEFVAL 0xBAD12345
 
@@ -153,6 +155,11 @@ struct ARM_CoreState
 static ARM_CoreState arm;
 static int CYCLES;	//cycle counter
 
+// One mark per page of the whole allocation, so that writes past the saved
+// RAM need no bounds check; only the first RAMPAGES are ever saved.
+unsigned char *_mem_dirty;
+static uint8 *baseRam;  //RAM as it was at _arm_SetSaveBase
+
 unsigned int __fastcall rreadusr(unsigned int rn);
 void __fastcall loadusr(unsigned int rn, unsigned int val);
 unsigned int __fastcall mreadb(unsigned int addr);
@@ -180,27 +187,26 @@ void* Getp_NVRAM(){return pNVRam;};
 void* Getp_ROMS(){return pRom;};
 void* Getp_RAMS(){return pRam;};
 
+// The BIOS is not part of the state: it is whatever was loaded at start-up.
 unsigned int _arm_SaveSize()
 {
-        return sizeof(ARM_CoreState)+RAMSIZE+ROMSIZE*2+NVRAMSIZE;
+        return sizeof(ARM_CoreState)+RAMSIZE+NVRAMSIZE;
 }
 void _arm_Save(void *buff)
 {
         memcpy(buff,&arm,sizeof(ARM_CoreState));
         memcpy(((uint8*)buff)+sizeof(ARM_CoreState),pRam,RAMSIZE);
-        memcpy(((uint8*)buff)+sizeof(ARM_CoreState)+RAMSIZE,pRom,ROMSIZE*2);
-        memcpy(((uint8*)buff)+sizeof(ARM_CoreState)+RAMSIZE+ROMSIZE*2,pNVRam,NVRAMSIZE);
+        memcpy(((uint8*)buff)+sizeof(ARM_CoreState)+RAMSIZE,pNVRam,NVRAMSIZE);
 }
 
-void _arm_Load(void *buff)
+static void LoadParts(uint8 *state, uint8 *ram, uint8 *nvram)
 {
  uint8 *tRam=pRam;
  uint8 *tRom=pRom;
  uint8 *tNVRam=pNVRam;
-        memcpy(&arm,buff,sizeof(ARM_CoreState));
-        memcpy(tRam,((uint8*)buff)+sizeof(ARM_CoreState),RAMSIZE);
-        memcpy(tRom,((uint8*)buff)+sizeof(ARM_CoreState)+RAMSIZE,ROMSIZE*2);
-        memcpy(tNVRam,((uint8*)buff)+sizeof(ARM_CoreState)+RAMSIZE+ROMSIZE*2,NVRAMSIZE);
+        memcpy(&arm,state,sizeof(ARM_CoreState));
+        memcpy(tRam,ram,RAMSIZE);
+        memcpy(tNVRam,nvram,NVRAMSIZE);
 
         memcpy(tRam+3*1024*1024,tRam+2*1024*1024, 1024*1024);
         memcpy(tRam+4*1024*1024,tRam+2*1024*1024, 1024*1024);
@@ -221,6 +227,112 @@ void _arm_Load(void *buff)
         pRom=tRom;
         pRam=tRam;
         pNVRam=tNVRam;
+
+        // Nothing is known to match the base any more.
+        memset(_mem_dirty,1,RAMPAGES);
+}
+
+void _arm_Load(void *buff)
+{
+        LoadParts((uint8*)buff,((uint8*)buff)+sizeof(ARM_CoreState),((uint8*)buff)+sizeof(ARM_CoreState)+RAMSIZE);
+}
+
+// States from before the BIOS was left out carry a copy of it between RAM
+// and NVRAM; it is skipped.
+unsigned int _arm_LegacySaveSize()
+{
+        return sizeof(ARM_CoreState)+RAMSIZE+ROMSIZE*2+NVRAMSIZE;
+}
+void _arm_LoadLegacy(void *buff)
+{
+        LoadParts((uint8*)buff,((uint8*)buff)+sizeof(ARM_CoreState),((uint8*)buff)+sizeof(ARM_CoreState)+RAMSIZE+ROMSIZE*2);
+}
+
+void _arm_SetSaveBase()
+{
+        if(!baseRam) baseRam=new uint8[RAMSIZE];
+        memcpy(baseRam,pRam,RAMSIZE);
+        memset(_mem_dirty,0,RAMPAGES);
+}
+
+unsigned int _arm_SaveIncrementalSize()
+{
+        return sizeof(ARM_CoreState)+NVRAMSIZE+RAMPAGES/8+RAMSIZE;
+}
+
+// Layout: ARM_CoreState, NVRAM, a bitmap of the pages that follow (bit n
+// of byte n/8 for page n), then those pages in order.
+unsigned int _arm_SaveIncremental(void *buff)
+{
+ uint8 *data=(uint8*)buff;
+ uint8 *bitmap=data+sizeof(ARM_CoreState)+NVRAMSIZE;
+ uint8 *pages=bitmap+RAMPAGES/8;
+ int i;
+        memcpy(data,&arm,sizeof(ARM_CoreState));
+        memcpy(data+sizeof(ARM_CoreState),pNVRam,NVRAMSIZE);
+        memset(bitmap,0,RAMPAGES/8);
+
+        for(i=0;i<RAMPAGES;i++)
+        {
+                if(!_mem_dirty[i]) continue;
+                bitmap[i>>3]|=1<<(i&7);
+                memcpy(pages,pRam+(i<<MEM_PAGE_SHIFT),1<<MEM_PAGE_SHIFT);
+                pages+=1<<MEM_PAGE_SHIFT;
+        }
+
+        return pages-data;
+}
+
+// Returns false, leaving everything as it was, if length is not what the
+// bitmap calls for.
+bool _arm_LoadIncremental(void *buff, unsigned int length)
+{
+ uint8 *data=(uint8*)buff;
+ uint8 *bitmap=data+sizeof(ARM_CoreState)+NVRAMSIZE;
+ uint8 *pages=bitmap+RAMPAGES/8;
+ uint8 *tRam=pRam;
+ uint8 *tRom=pRom;
+ uint8 *tNVRam=pNVRam;
+ unsigned int addr;
+ int i,k;
+        if(length<sizeof(ARM_CoreState)+NVRAMSIZE+RAMPAGES/8)
+                return false;
+        k=0;
+        for(i=0;i<RAMPAGES;i++)
+                if(bitmap[i>>3]&(1<<(i&7))) k++;
+        if(length!=sizeof(ARM_CoreState)+NVRAMSIZE+RAMPAGES/8+(k<<MEM_PAGE_SHIFT))
+                return false;
+
+        memcpy(&arm,data,sizeof(ARM_CoreState));
+        pRom=tRom;
+        pRam=tRam;
+        pNVRam=tNVRam;
+        memcpy(pNVRam,data+sizeof(ARM_CoreState),NVRAMSIZE);
+
+        // A page is either in the state or, if it changed since the base,
+        // put back to the base; the rest already matches.
+        for(i=0;i<RAMPAGES;i++)
+        {
+                addr=i<<MEM_PAGE_SHIFT;
+                if(bitmap[i>>3]&(1<<(i&7)))
+                {
+                        memcpy(pRam+addr,pages,1<<MEM_PAGE_SHIFT);
+                        pages+=1<<MEM_PAGE_SHIFT;
+                        _mem_dirty[i]=1;
+                }
+                else if(_mem_dirty[i])
+                {
+                        memcpy(pRam+addr,baseRam+addr,1<<MEM_PAGE_SHIFT);
+                        _mem_dirty[i]=0;
+                }
+                else continue;
+
+                // The same VRAM copies _arm_Load makes.
+                if(addr>=0x200000)
+                        for(k=1;k<16;k++)
+                                memcpy(pRam+addr+k*1024*1024,pRam+addr,1<<MEM_PAGE_SHIFT);
+        }
+        return true;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -578,11 +690,14 @@ unsigned char * _arm_Init()
         RON_CASH[i]=RON_FIQ[i]=0;
 
 	gSecondROM=0;
-	pRam=new uint8[RAMSIZE+1024*1024*16];
+	pRam=new uint8[RAMALLOC];
 	pRom=new uint8[ROMSIZE*2];
 	pNVRam=new uint8[NVRAMSIZE];
+	_mem_dirty=new unsigned char[RAMALLOC>>MEM_PAGE_SHIFT];
+	baseRam=NULL;
 
-    memset( pRam, 0, RAMSIZE+1024*1024*16);
+    memset( pRam, 0, RAMALLOC);
+    memset( _mem_dirty, 1, RAMALLOC>>MEM_PAGE_SHIFT);
     memset( pRom, 0, ROMSIZE*2);
     memset( pNVRam,0, NVRAMSIZE);
     gFIQ=false;
@@ -608,6 +723,9 @@ void _arm_Destroy()
 	delete []pNVRam;
 	delete []pRom;
 	delete []pRam;
+	delete []_mem_dirty;
+	delete []baseRam;
+	baseRam=NULL;
 }
 
 void _arm_Reset()
@@ -1582,6 +1700,7 @@ int __fastcall _arm_Execute()
 void __fastcall _mem_write8(unsigned int addr, unsigned char val)
 {
 	    pRam[addr]=val;
+	    _mem_MarkDirty(addr);
 	    if(addr<0x200000 || !RESSCALE) return;
         pRam[addr+1024*1024]=val;
         pRam[addr+2*1024*1024]=val;
@@ -1590,6 +1709,7 @@ void __fastcall _mem_write8(unsigned int addr, unsigned char val)
 void __fastcall _mem_write16(unsigned int addr, unsigned short val)
 {
         *((unsigned short*)&pRam[addr])=val;
+        _mem_MarkDirty(addr);
         if(addr<0x200000 || !RESSCALE) return;
         *((unsigned short*)&pRam[addr+1024*1024])=val;
         *((unsigned short*)&pRam[addr+2*1024*1024])=val;
@@ -1598,12 +1718,35 @@ void __fastcall _mem_write16(unsigned int addr, unsigned short val)
 void __fastcall _mem_write32(unsigned int addr, unsigned int val)
 {
 	    *((unsigned int*)&pRam[addr])=val;
+        _mem_MarkDirty(addr);
         if(addr<0x200000 || !RESSCALE) return;
         *((unsigned int*)&pRam[addr+1024*1024])=val;
         *((unsigned int*)&pRam[addr+2*1024*1024])=val;
         *((unsigned int*)&pRam[addr+3*1024*1024])=val;
 }
 
+// Repeats what the _mem_write* calls do for VRAM in high-res mode, for a
+// range that was filled directly through Getp_RAMS().
+void __fastcall _mem_mirror(unsigned int addr, unsigned int len)
+{
+        _mem_MarkDirtyRange(addr,len);
+        if(!RESSCALE || addr+len<=0x200000) return;
+        if(addr<0x200000)
+        {
+                len-=0x200000-addr;
+                addr=0x200000;
+        }
+        memcpy(&pRam[addr+1024*1024],&pRam[addr],len);
+        memcpy(&pRam[addr+2*1024*1024],&pRam[addr],len);
+        memcpy(&pRam[addr+3*1024*1024],&pRam[addr],len);
+}
+
+void __fastcall _mem_MarkDirtyRange(unsigned int addr, unsigned int len)
+{
+        if(!len) return;
+        memset(&_mem_dirty[addr>>MEM_PAGE_SHIFT],1,((addr+len-1)>>MEM_PAGE_SHIFT)-(addr>>MEM_PAGE_SHIFT)+1);
+}
+
 unsigned short __fastcall _mem_read16(unsigned int addr)
 {
         return *((unsigned short*)&pRam[addr]);
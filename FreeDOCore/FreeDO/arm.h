@@ -42,6 +42,14 @@ Felix Lazarev
         unsigned char __fastcall _mem_read8(unsigned int addr);
         unsigned short __fastcall _mem_read16(unsigned int addr);
         unsigned int __fastcall _mem_read32(unsigned int addr);
+        void __fastcall _mem_mirror(unsigned int addr, unsigned int len); //after writing straight into RAM, also marks it dirty
+
+	// RAM is tracked in pages for incremental saves: every write into it
+	// marks its page, and _arm_SetSaveBase clears the marks.
+	#define MEM_PAGE_SHIFT  12
+	extern unsigned char *_mem_dirty;
+	#define _mem_MarkDirty(addr) (_mem_dirty[(addr)>>MEM_PAGE_SHIFT]=1)
+	void __fastcall _mem_MarkDirtyRange(unsigned int addr, unsigned int len);
 
 	void __fastcall WriteIO(unsigned int addr, unsigned int val);
 	unsigned int __fastcall ReadIO(unsigned int addr);
@@ -50,6 +58,15 @@ Felix Lazarev
         unsigned int _arm_SaveSize();
         void _arm_Save(void *buff);
         void _arm_Load(void *buff);
+        unsigned int _arm_LegacySaveSize();
+        void _arm_LoadLegacy(void *buff); //the layout before the BIOS was left out of states
+
+        // Incremental saves hold the CPU, NVRAM and only the RAM pages that
+        // changed since the base, which the core keeps a copy of.
+        void _arm_SetSaveBase();
+        unsigned int _arm_SaveIncrementalSize(); //worst case
+        unsigned int _arm_SaveIncremental(void *buff); //returns the bytes written
+        bool _arm_LoadIncremental(void *buff, unsigned int length);
 
 
 #endif 
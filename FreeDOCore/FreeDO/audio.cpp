@@ -0,0 +1,271 @@
+#include <math.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "freedoconfig.h"
+#include "freedocore.h"
+#include "audio.h"
+#include "audiocap.h"
+#include "scalers.h"
+
+extern _ext_Interface io_interface;
+
+static unsigned int samples[AUDIO_BLOCK_SAMPLES];
+static int sampleCount;
+
+// Resampler, owned by the emulation thread; outputLock only keeps
+// _audio_SetOutputRate from changing it under a running block.
+static CRITICAL_SECTION outputLock;
+static volatile int outputRate;
+static bool outputSSE;
+static double baseStep, phase;
+static float coefs[(AUDIO_PHASES + 1) * AUDIO_TAPS];
+static float historyL[AUDIO_TAPS * 2], historyR[AUDIO_TAPS * 2];
+static int historyPos;
+
+// Output ring. Both counters run freely; the producer only moves ringWrite
+// and the consumer only moves ringRead.
+static unsigned int ring[AUDIO_RING_SAMPLES];
+static volatile LONG ringWrite, ringRead;
+static HANDLE drainEvent;	// set by the consumer after every read
+static volatile LONG readers;	// consumers inside _audio_ReadOutput
+static volatile int pacedFill;	// fill the last _audio_WaitBelow ended at, -1 if the producer does not wait
+
+void _audio_Init()
+{
+	InitializeCriticalSection(&outputLock);
+	sampleCount = 0;
+	outputRate = 0;
+	ringWrite = ringRead = 0;
+	pacedFill = -1;
+	drainEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+void _audio_Destroy()
+{
+	// Turn the output off first, so no new read gets past its check, then
+	// let a read already under way finish with the event.
+	EnterCriticalSection(&outputLock);
+	outputRate = 0;
+	LeaveCriticalSection(&outputLock);
+	while (readers)
+		Sleep(0);
+
+	DeleteCriticalSection(&outputLock);
+	CloseHandle(drainEvent);
+	drainEvent = NULL;
+	sampleCount = 0;
+}
+
+// Blackman-windowed sinc, cutoff relative to the input Nyquist rate.
+static double Kernel(double x, double cutoff)
+{
+	const double pi = 3.14159265358979323846;
+	double half = AUDIO_TAPS / 2;
+
+	if (x <= -half || x >= half)
+		return 0;
+
+	double t = x * cutoff;
+	double sinc = (t == 0) ? 1 : sin(pi * t) / (pi * t);
+	double u = x / half;
+	double window = 0.42 + 0.5 * cos(pi * u) + 0.08 * cos(2 * pi * u);
+	return cutoff * sinc * window;
+}
+
+void _audio_SetOutputRate(int rate)
+{
+	EnterCriticalSection(&outputLock);
+
+	outputRate = rate;
+	if (rate > 0)
+	{
+		// Going down in rate the filter has to cut below the new Nyquist.
+		double cutoff = (rate < AUDIO_DSP_RATE ? (double)rate / AUDIO_DSP_RATE : 1.0) * 0.92;
+
+		// Row p filters for an output p/AUDIO_PHASES of the way past the
+		// sample AUDIO_TAPS/2 behind the newest one; column j is history j,
+		// oldest first. Rows are normalised to unity gain.
+		for (int p = 0; p <= AUDIO_PHASES; p++)
+		{
+			float* row = &coefs[p * AUDIO_TAPS];
+			double sum = 0;
+			for (int j = 0; j < AUDIO_TAPS; j++)
+			{
+				double x = AUDIO_TAPS / 2 - (AUDIO_TAPS - 1 - j) - (double)p / AUDIO_PHASES;
+				sum += row[j] = (float)Kernel(x, cutoff);
+			}
+			for (int j = 0; j < AUDIO_TAPS; j++)
+				row[j] = (float)(row[j] / sum);
+		}
+
+		memset(historyL, 0, sizeof(historyL));
+		memset(historyR, 0, sizeof(historyR));
+		historyPos = 0;
+		phase = 0;
+		baseStep = (double)AUDIO_DSP_RATE / rate;
+		pacedFill = -1;
+		outputSSE = cpuHasSSE2();
+	}
+
+	LeaveCriticalSection(&outputLock);
+}
+
+static inline short Clamp16(float v)
+{
+	int i = (int)(v < 0 ? v - 0.5f : v + 0.5f);
+	return (short)(i < -32768 ? -32768 : i > 32767 ? 32767 : i);
+}
+
+static unsigned int Filter(const float* row)
+{
+	const float* l = historyL + historyPos;
+	const float* r = historyR + historyPos;
+	float left, right;
+
+	if (outputSSE)
+	{
+		__m128 accL = _mm_setzero_ps();
+		__m128 accR = _mm_setzero_ps();
+		for (int j = 0; j < AUDIO_TAPS; j += 4)
+		{
+			__m128 c = _mm_loadu_ps(row + j);
+			accL = _mm_add_ps(accL, _mm_mul_ps(c, _mm_loadu_ps(l + j)));
+			accR = _mm_add_ps(accR, _mm_mul_ps(c, _mm_loadu_ps(r + j)));
+		}
+		// Horizontal sums: L in the low pair, R in the high pair.
+		__m128 lr = _mm_add_ps(_mm_unpacklo_ps(accL, accR), _mm_unpackhi_ps(accL, accR));
+		lr = _mm_add_ps(lr, _mm_movehl_ps(lr, lr));
+		float out[4];
+		_mm_storeu_ps(out, lr);
+		left = out[0];
+		right = out[1];
+	}
+	else
+	{
+		left = right = 0;
+		for (int j = 0; j < AUDIO_TAPS; j++)
+		{
+			left += row[j] * l[j];
+			right += row[j] * r[j];
+		}
+	}
+
+	return ((unsigned short)Clamp16(right) << 16) | (unsigned short)Clamp16(left);
+}
+
+static void Resample(const unsigned int* in, int count)
+{
+	// Steer the ring towards the target fill: a fuller ring means a bigger
+	// step through the input and so fewer output samples. A paced producer
+	// adds a frame at a time on top of where its wait left the ring, so
+	// that is the level to steer by; otherwise the fill right now.
+	LONG write = ringWrite;
+	double fill = (pacedFill >= 0) ? pacedFill : (double)(write - ringRead);
+	double target = (double)outputRate * AUDIO_LATENCY_MS / 1000;
+	double error = (fill - target) / target;
+	if (error > 1) error = 1;
+	if (error < -1) error = -1;
+	double step = baseStep * (1 + AUDIO_RATE_CONTROL * error);
+
+	int space = AUDIO_RING_SAMPLES - (int)(write - ringRead);
+
+	for (int i = 0; i < count; i++)
+	{
+		// The history is stored twice so the newest AUDIO_TAPS samples are
+		// always contiguous at historyPos.
+		float l = (float)(short)(in[i] & 0xffff);
+		float r = (float)(short)(in[i] >> 16);
+		historyL[historyPos] = historyL[historyPos + AUDIO_TAPS] = l;
+		historyR[historyPos] = historyR[historyPos + AUDIO_TAPS] = r;
+		historyPos = (historyPos + 1) % AUDIO_TAPS;
+
+		while (phase < 1.0)
+		{
+			unsigned int out = Filter(&coefs[(int)(phase * AUDIO_PHASES + 0.5) * AUDIO_TAPS]);
+			// With nobody draining the ring the newest output is dropped.
+			if (space > 0)
+			{
+				ring[write & (AUDIO_RING_SAMPLES - 1)] = out;
+				write++;
+				space--;
+			}
+			phase += step;
+		}
+		phase -= 1.0;
+	}
+
+	InterlockedExchange(&ringWrite, write);
+}
+
+int _audio_ReadOutput(unsigned int* buffer, int count)
+{
+	InterlockedIncrement(&readers);
+	if (outputRate <= 0)
+	{
+		InterlockedDecrement(&readers);
+		return 0;
+	}
+
+	LONG read = ringRead;
+	int available = (int)(ringWrite - read);
+	if (count > available)
+		count = available;
+
+	for (int i = 0; i < count; i++)
+		buffer[i] = ring[(read + i) & (AUDIO_RING_SAMPLES - 1)];
+
+	InterlockedExchange(&ringRead, read + count);
+	SetEvent(drainEvent);
+	InterlockedDecrement(&readers);
+	return count;
+}
+
+int _audio_Buffered()
+{
+	if (outputRate <= 0)
+		return 0;
+	return (int)(ringWrite - ringRead);
+}
+
+int _audio_WaitBelow(int watermark)
+{
+	if (outputRate <= 0)
+		return 0;
+	if (watermark <= 0)
+		watermark = outputRate * AUDIO_LATENCY_MS / 1000;
+
+	int buffered;
+	while ((buffered = (int)(ringWrite - ringRead)) > watermark)
+	{
+		if (WaitForSingleObject(drainEvent, AUDIO_WAIT_TIMEOUT_MS) == WAIT_TIMEOUT)
+			break;
+	}
+	pacedFill = buffered;
+	return buffered;
+}
+
+void __fastcall _audio_PushSample(unsigned int sample)
+{
+	samples[sampleCount++] = sample;
+	if (sampleCount == AUDIO_BLOCK_SAMPLES)
+		_audio_Flush();
+}
+
+void _audio_Flush()
+{
+	if (sampleCount == 0)
+		return;
+
+	SampleBlock block;
+	block.samples = samples;
+	block.count = sampleCount;
+	io_interface(EXT_PUSH_SAMPLES, &block);
+	_audiocap_Samples(samples, sampleCount);
+
+	EnterCriticalSection(&outputLock);
+	if (outputRate > 0)
+		Resample(samples, sampleCount);
+	LeaveCriticalSection(&outputLock);
+
+	sampleCount = 0;
+}
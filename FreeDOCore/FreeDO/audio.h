@@ -0,0 +1,58 @@
+// audio.h - Collects DSP output and hands it to the host.
+//
+// Every DSP tick produces one 32-bit sample (right channel in the high
+// half, left in the low half, as EXT_PUSH_SAMPLE used to deliver it).
+// Instead of one callback per sample the core fills a block and calls
+// EXT_PUSH_SAMPLES with a SampleBlock once it is full, and again at the end
+// of every frame with whatever is left.
+//
+// When the host selects an output rate the same blocks also go through a
+// polyphase windowed-sinc resampler into a single-producer/single-consumer
+// ring that the host's audio thread drains with _audio_ReadOutput. The
+// resampler runs slightly fast or slow depending on how full that ring is,
+// so the fill level settles at AUDIO_LATENCY_MS and the sound card clock
+// ends up pacing the emulation instead of drifting against it.
+//
+// The emulation thread can pace itself on that ring: _audio_WaitBelow
+// blocks until the consumer has drained it below a watermark, woken by
+// every _audio_ReadOutput. The rate control is then neutral when the wait
+// ends right at the target.
+
+#ifndef	AUDIO_3DO_HEADER
+#define AUDIO_3DO_HEADER
+
+#define AUDIO_BLOCK_SAMPLES    512
+
+#define AUDIO_DSP_RATE         44100
+#define AUDIO_RING_SAMPLES     16384   // power of two, ~340 ms at 48 kHz
+#define AUDIO_LATENCY_MS       64      // ring fill the rate control steers towards
+#define AUDIO_RATE_CONTROL     0.005   // largest relative pitch change it may apply
+
+#define AUDIO_WAIT_TIMEOUT_MS  100     // give up waiting when the consumer stalls
+
+#define AUDIO_TAPS             16      // multiple of 4
+#define AUDIO_PHASES           256
+
+void _audio_Init();
+void _audio_Destroy();
+
+void __fastcall _audio_PushSample(unsigned int sample);
+void _audio_Flush();
+
+// 0 turns the resampled output off.
+void _audio_SetOutputRate(int rate);
+// Called by the consumer only; returns the number of samples copied, 0
+// while the output is off. The consumer may still be calling it when the
+// core is destroyed.
+int _audio_ReadOutput(unsigned int* buffer, int count);
+
+// Samples queued in the output ring, 0 while the output is off.
+int _audio_Buffered();
+// Waits until at most watermark samples are queued (0 means the rate
+// control's own target) and returns how many are; returns at once while
+// the output is off. Once the producer waits, the rate control goes by the
+// fill each wait ends at rather than the fill mid-frame, which is always
+// up to a frame higher.
+int _audio_WaitBelow(int watermark);
+
+#endif
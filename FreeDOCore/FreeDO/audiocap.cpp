@@ -0,0 +1,469 @@
+#include <stdio.h>
+#include <string.h>
+#include "freedoconfig.h"
+#include "freedocore.h"
+#include "audio.h"
+#include "audiocap.h"
+#include "Worker.h"
+
+#define AUDIOCAP_WRITE_BUFFER  (1 << 16)
+#define AUDIOCAP_FRAME_BYTES   (AUDIOCAP_BLOCK * 4 + 64)   // a verbatim frame plus headers
+#define AUDIOCAP_MAX_ORDER     4
+#define AUDIOCAP_MAX_RICE      14
+
+#define WAV_HEADER_SIZE        44
+#define FLAC_STREAMINFO_OFFSET 8
+#define FLAC_STREAMINFO_SIZE   34
+
+static CRITICAL_SECTION captureLock;    // held by the emulation thread while queueing
+static HANDLE ringEvent;
+static Worker* writer;
+
+static volatile bool capturing;
+static volatile bool stopping;
+
+static FILE* captureFile;
+static bool flac;
+static unsigned int droppedSamples;
+
+// Both counters run freely; the emulation thread only moves ringWrite and
+// the writer only moves ringRead.
+static unsigned int* ring;
+static volatile LONG ringWrite, ringRead;
+
+// Writer thread state.
+static unsigned int block[AUDIOCAP_BLOCK];
+static unsigned char frame[AUDIOCAP_FRAME_BYTES];
+static int channel[AUDIOCAP_BLOCK], residual[AUDIOCAP_BLOCK];
+static unsigned int totalSamples, frameNumber, minFrameSize, maxFrameSize;
+
+static unsigned char crc8Table[256];
+static unsigned short crc16Table[256];
+
+struct BitWriter
+{
+	unsigned char* out;
+	int pos;
+	unsigned long long acc;
+	int bits;
+};
+
+static void PutBits(BitWriter* w, unsigned int value, int count)
+{
+	if (count == 0)
+		return;
+	w->acc = (w->acc << count) | (value & (0xFFFFFFFFu >> (32 - count)));
+	w->bits += count;
+	while (w->bits >= 8)
+	{
+		w->bits -= 8;
+		w->out[w->pos++] = (unsigned char)(w->acc >> w->bits);
+	}
+}
+
+static void PutZeros(BitWriter* w, unsigned int count)
+{
+	for (; count > 32; count -= 32)
+		PutBits(w, 0, 32);
+	PutBits(w, 0, count);
+}
+
+static void AlignBits(BitWriter* w)
+{
+	if (w->bits)
+		PutBits(w, 0, 8 - w->bits);
+}
+
+static void BuildCRCTables()
+{
+	for (int i = 0; i < 256; i++)
+	{
+		unsigned int c8 = i, c16 = i << 8;
+		for (int b = 0; b < 8; b++)
+		{
+			c8 = (c8 & 0x80) ? (c8 << 1) ^ 0x07 : (c8 << 1);
+			c16 = (c16 & 0x8000) ? (c16 << 1) ^ 0x8005 : (c16 << 1);
+		}
+		crc8Table[i] = (unsigned char)c8;
+		crc16Table[i] = (unsigned short)c16;
+	}
+}
+
+static unsigned char CRC8(const unsigned char* data, int size)
+{
+	unsigned char crc = 0;
+	for (int i = 0; i < size; i++)
+		crc = crc8Table[crc ^ data[i]];
+	return crc;
+}
+
+static unsigned short CRC16(const unsigned char* data, int size)
+{
+	unsigned short crc = 0;
+	for (int i = 0; i < size; i++)
+		crc = (unsigned short)((crc << 8) ^ crc16Table[(crc >> 8) ^ data[i]]);
+	return crc;
+}
+
+// FLAC frame numbers use the extended UTF-8 byte layout.
+static void PutUTF8(BitWriter* w, unsigned int value)
+{
+	if (value < 0x80)
+	{
+		PutBits(w, value, 8);
+		return;
+	}
+
+	int extra = (value < 0x800) ? 1 : (value < 0x10000) ? 2 : (value < 0x200000) ? 3 : (value < 0x4000000) ? 4 : 5;
+	unsigned int lead = (0xFF00 >> (extra + 1)) & 0xFF;
+	PutBits(w, lead | (value >> (6 * extra)), 8);
+	for (int i = extra - 1; i >= 0; i--)
+		PutBits(w, 0x80 | ((value >> (6 * i)) & 0x3F), 8);
+}
+
+static void FixedResidual(const int* x, int* r, int n, int order)
+{
+	for (int i = order; i < n; i++)
+	{
+		switch (order)
+		{
+		case 0: r[i] = x[i]; break;
+		case 1: r[i] = x[i] - x[i-1]; break;
+		case 2: r[i] = x[i] - 2*x[i-1] + x[i-2]; break;
+		case 3: r[i] = x[i] - 3*x[i-1] + 3*x[i-2] - x[i-3]; break;
+		default: r[i] = x[i] - 4*x[i-1] + 6*x[i-2] - 4*x[i-3] + x[i-4]; break;
+		}
+	}
+}
+
+// Picks the predictor order with the smallest absolute residual, the way
+// the reference encoder does, then the Rice parameter by exact bit count.
+static void EncodeSubframe(BitWriter* w, const int* x, int n)
+{
+	bool constant = true;
+	for (int i = 1; i < n && constant; i++)
+		constant = (x[i] == x[0]);
+	if (constant)
+	{
+		PutBits(w, 0x00, 8);
+		PutBits(w, x[0], 16);
+		return;
+	}
+
+	int order = 0;
+	if (n > AUDIOCAP_MAX_ORDER)
+	{
+		unsigned long long sums[AUDIOCAP_MAX_ORDER + 1] = { 0 };
+		for (int i = AUDIOCAP_MAX_ORDER; i < n; i++)
+		{
+			int e0 = x[i];
+			int e1 = e0 - x[i-1];
+			int e2 = e1 - (x[i-1] - x[i-2]);
+			int e3 = e2 - (x[i-1] - 2*x[i-2] + x[i-3]);
+			int e4 = e3 - (x[i-1] - 3*x[i-2] + 3*x[i-3] - x[i-4]);
+			sums[0] += (e0 < 0) ? -e0 : e0;
+			sums[1] += (e1 < 0) ? -e1 : e1;
+			sums[2] += (e2 < 0) ? -e2 : e2;
+			sums[3] += (e3 < 0) ? -e3 : e3;
+			sums[4] += (e4 < 0) ? -e4 : e4;
+		}
+		for (int o = 1; o <= AUDIOCAP_MAX_ORDER; o++)
+			if (sums[o] < sums[order])
+				order = o;
+	}
+	FixedResidual(x, residual, n, order);
+
+	unsigned long long riceBits[AUDIOCAP_MAX_RICE + 1] = { 0 };
+	for (int i = order; i < n; i++)
+	{
+		unsigned int u = ((unsigned int)residual[i] << 1) ^ (unsigned int)(residual[i] >> 31);
+		for (int k = 0; k <= AUDIOCAP_MAX_RICE; k++)
+			riceBits[k] += u >> k;
+	}
+	int k = 0;
+	for (int p = 0; p <= AUDIOCAP_MAX_RICE; p++)
+	{
+		riceBits[p] += (unsigned long long)(n - order) * (p + 1);
+		if (riceBits[p] < riceBits[k])
+			k = p;
+	}
+
+	unsigned long long fixedBits = 16 * order + 2 + 4 + 4 + riceBits[k];
+	if (fixedBits >= 16ull * n)
+	{
+		PutBits(w, 0x02, 8);
+		for (int i = 0; i < n; i++)
+			PutBits(w, x[i], 16);
+		return;
+	}
+
+	PutBits(w, 0x10 | (order << 1), 8);
+	for (int i = 0; i < order; i++)
+		PutBits(w, x[i], 16);
+	PutBits(w, 0, 2);   // Rice, 4-bit parameters
+	PutBits(w, 0, 4);   // partition order 0
+	PutBits(w, k, 4);
+	for (int i = order; i < n; i++)
+	{
+		unsigned int u = ((unsigned int)residual[i] << 1) ^ (unsigned int)(residual[i] >> 31);
+		PutZeros(w, u >> k);
+		PutBits(w, (1u << k) | (u & ((1u << k) - 1)), k + 1);
+	}
+}
+
+static int EncodeFrame(const unsigned int* samples, int n)
+{
+	BitWriter w = { frame, 0, 0, 0 };
+
+	PutBits(&w, 0x3FFE, 14);    // sync
+	PutBits(&w, 0, 2);          // reserved, fixed block size
+	PutBits(&w, (n == AUDIOCAP_BLOCK) ? 0xC : 0x7, 4);
+	PutBits(&w, 0x9, 4);        // 44.1 kHz
+	PutBits(&w, 0x1, 4);        // left, right
+	PutBits(&w, 0x4, 3);        // 16 bits per sample
+	PutBits(&w, 0, 1);
+	PutUTF8(&w, frameNumber);
+	if (n != AUDIOCAP_BLOCK)
+		PutBits(&w, n - 1, 16);
+	PutBits(&w, CRC8(frame, w.pos), 8);
+
+	for (int shift = 0; shift < 32; shift += 16)
+	{
+		for (int i = 0; i < n; i++)
+			channel[i] = (short)(samples[i] >> shift);
+		EncodeSubframe(&w, channel, n);
+	}
+
+	AlignBits(&w);
+	PutBits(&w, CRC16(frame, w.pos), 16);
+	return w.pos;
+}
+
+static void WriteStreamInfo()
+{
+	unsigned char info[FLAC_STREAMINFO_SIZE];
+	BitWriter w = { info, 0, 0, 0 };
+
+	PutBits(&w, AUDIOCAP_BLOCK, 16);
+	PutBits(&w, AUDIOCAP_BLOCK, 16);
+	PutBits(&w, minFrameSize, 24);
+	PutBits(&w, maxFrameSize, 24);
+	PutBits(&w, AUDIO_DSP_RATE, 20);
+	PutBits(&w, 2 - 1, 3);
+	PutBits(&w, 16 - 1, 5);
+	PutBits(&w, 0, 4);          // top bits of the 36-bit sample count
+	PutBits(&w, totalSamples, 32);
+	memset(info + w.pos, 0, FLAC_STREAMINFO_SIZE - w.pos);   // MD5 not computed
+
+	fwrite(info, 1, sizeof(info), captureFile);
+}
+
+static void WriteLE32(unsigned char* out, unsigned int value)
+{
+	out[0] = (unsigned char)value;
+	out[1] = (unsigned char)(value >> 8);
+	out[2] = (unsigned char)(value >> 16);
+	out[3] = (unsigned char)(value >> 24);
+}
+
+static void WriteHeader()
+{
+	if (flac)
+	{
+		static const unsigned char marker[8] = { 'f', 'L', 'a', 'C', 0x80, 0, 0, FLAC_STREAMINFO_SIZE };
+		fwrite(marker, 1, sizeof(marker), captureFile);
+		WriteStreamInfo();
+		return;
+	}
+
+	unsigned int dataSize = totalSamples * 4;
+	unsigned char header[WAV_HEADER_SIZE];
+	memcpy(header, "RIFF", 4);
+	WriteLE32(header + 4, 36 + dataSize);
+	memcpy(header + 8, "WAVEfmt ", 8);
+	WriteLE32(header + 16, 16);
+	WriteLE32(header + 20, 1 | (2 << 16));         // PCM, stereo
+	WriteLE32(header + 24, AUDIO_DSP_RATE);
+	WriteLE32(header + 28, AUDIO_DSP_RATE * 4);
+	WriteLE32(header + 32, 4 | (16 << 16));        // block align, bits per sample
+	memcpy(header + 36, "data", 4);
+	WriteLE32(header + 40, dataSize);
+	fwrite(header, 1, sizeof(header), captureFile);
+}
+
+static void WriteBlock(const unsigned int* samples, int n)
+{
+	if (flac)
+	{
+		unsigned int size = EncodeFrame(samples, n);
+		fwrite(frame, 1, size, captureFile);
+		if (frameNumber == 0 || size < minFrameSize)
+			minFrameSize = size;
+		if (size > maxFrameSize)
+			maxFrameSize = size;
+		frameNumber++;
+	}
+	else
+		// DSP samples already are little-endian left/right 16-bit pairs.
+		fwrite(samples, 4, n, captureFile);
+
+	totalSamples += n;
+}
+
+static void CaptureWriter(void* unused)
+{
+	for (;;)
+	{
+		WaitForSingleObject(ringEvent, INFINITE);
+		// Read the flag first: everything queued before it was set is drained.
+		bool done = stopping;
+
+		for (;;)
+		{
+			LONG read = ringRead;
+			int available = ringWrite - read;
+			if (available < AUDIOCAP_BLOCK && !(done && available > 0))
+				break;
+
+			int n = (available < AUDIOCAP_BLOCK) ? available : AUDIOCAP_BLOCK;
+			for (int i = 0; i < n; i++)
+				block[i] = ring[(read + i) & (AUDIOCAP_RING_SAMPLES - 1)];
+			InterlockedExchange(&ringRead, read + n);
+
+			WriteBlock(block, n);
+		}
+
+		if (done)
+			return;
+	}
+}
+
+void _audiocap_Init()
+{
+	InitializeCriticalSection(&captureLock);
+	BuildCRCTables();
+	capturing = false;
+	captureFile = NULL;
+	writer = NULL;
+	ring = NULL;
+}
+
+void _audiocap_Destroy()
+{
+	_audiocap_Stop();
+	DeleteCriticalSection(&captureLock);
+}
+
+static bool EndsWith(const char* text, const char* suffix)
+{
+	size_t length = strlen(text), suffixLength = strlen(suffix);
+	if (length < suffixLength)
+		return false;
+	for (size_t i = 0; i < suffixLength; i++)
+	{
+		char c = text[length - suffixLength + i];
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		if (c != suffix[i])
+			return false;
+	}
+	return true;
+}
+
+bool _audiocap_Start(const char* path)
+{
+	EnterCriticalSection(&captureLock);
+
+	if (capturing)
+	{
+		LeaveCriticalSection(&captureLock);
+		return true;
+	}
+
+	captureFile = fopen(path, "wb");
+	if (captureFile == NULL)
+	{
+		LeaveCriticalSection(&captureLock);
+		return false;
+	}
+	setvbuf(captureFile, NULL, _IOFBF, AUDIOCAP_WRITE_BUFFER);
+
+	flac = EndsWith(path, ".flac");
+	totalSamples = frameNumber = minFrameSize = maxFrameSize = 0;
+	WriteHeader();
+
+	ring = new unsigned int[AUDIOCAP_RING_SAMPLES];
+	ringWrite = ringRead = 0;
+	droppedSamples = 0;
+	stopping = false;
+
+	ringEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	writer = new Worker(CaptureWriter, NULL);
+	writer->Run();
+
+	capturing = true;
+	LeaveCriticalSection(&captureLock);
+	return true;
+}
+
+unsigned int _audiocap_Stop()
+{
+	EnterCriticalSection(&captureLock);
+
+	if (!capturing)
+	{
+		LeaveCriticalSection(&captureLock);
+		return 0;
+	}
+	capturing = false;
+
+	// Let the writer encode what is queued, then fill in the header.
+	stopping = true;
+	SetEvent(ringEvent);
+	writer->Wait();
+	delete writer;
+	writer = NULL;
+	CloseHandle(ringEvent);
+
+	fseek(captureFile, 0, SEEK_SET);
+	WriteHeader();
+	fclose(captureFile);
+	captureFile = NULL;
+
+	delete[] ring;
+	ring = NULL;
+
+	unsigned int dropped = droppedSamples;
+	LeaveCriticalSection(&captureLock);
+	return dropped;
+}
+
+void _audiocap_Samples(const unsigned int* samples, int count)
+{
+	if (!capturing)
+		return;
+
+	EnterCriticalSection(&captureLock);
+	if (!capturing)
+	{
+		LeaveCriticalSection(&captureLock);
+		return;
+	}
+
+	// Never wait for the writer: whatever does not fit is dropped.
+	LONG write = ringWrite;
+	int space = AUDIOCAP_RING_SAMPLES - (write - ringRead);
+	if (count > space)
+	{
+		droppedSamples += count - space;
+		count = space;
+	}
+	for (int i = 0; i < count; i++)
+		ring[(write + i) & (AUDIOCAP_RING_SAMPLES - 1)] = samples[i];
+	InterlockedExchange(&ringWrite, write + count);
+
+	if (ringWrite - ringRead >= AUDIOCAP_BLOCK)
+		SetEvent(ringEvent);
+
+	LeaveCriticalSection(&captureLock);
+}
@@ -0,0 +1,30 @@
+// audiocap.h - Records the DSP output to a WAV or FLAC file.
+//
+// _audio_Flush hands every block of 44.1 kHz samples to _audiocap_Samples,
+// which only copies them into a ring. A background thread drains the ring
+// in AUDIOCAP_BLOCK sample chunks, encodes them and writes them out, so a
+// slow disk never stalls the emulation thread; when the ring is full the
+// newest samples are dropped and counted instead.
+//
+// A path ending in ".flac" selects FLAC, anything else a 16-bit stereo
+// WAV. The FLAC stream uses fixed 4096 sample blocks, independent
+// channels, constant/fixed-predictor/verbatim subframes and a single Rice
+// partition; the STREAMINFO MD5 is left zero ("not computed"). Both
+// headers are completed when the capture stops.
+
+#ifndef	AUDIOCAP_3DO_HEADER
+#define AUDIOCAP_3DO_HEADER
+
+#define AUDIOCAP_BLOCK         4096    // samples per FLAC frame / WAV write
+#define AUDIOCAP_RING_SAMPLES  (1 << 17)   // power of two, ~3 s
+
+void _audiocap_Init();
+void _audiocap_Destroy();
+
+// Starting while a capture runs keeps that capture going.
+bool _audiocap_Start(const char* path);
+unsigned int _audiocap_Stop();   // returns the number of dropped samples
+
+void _audiocap_Samples(const unsigned int* samples, int count);
+
+#endif
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <string.h>
+#include "freedoconfig.h"
+#include "freedocore.h"
+#include "capture.h"
+#include "Worker.h"
+
+#define CAPTURE_MAX_WIDTH   640
+#define CAPTURE_MAX_HEIGHT  480
+#define CAPTURE_CONTROL_SIZE (3*sizeof(unsigned int))
+#define CAPTURE_SLOT_SIZE   (sizeof(CaptureFrameHeader) + CAPTURE_MAX_HEIGHT*(1 + 3*32 + CAPTURE_CONTROL_SIZE + CAPTURE_MAX_WIDTH*2))
+
+struct CaptureSlot
+{
+	unsigned char* data;
+	unsigned int size;
+};
+
+static CRITICAL_SECTION captureLock;    // held by the emulation thread while encoding
+static CRITICAL_SECTION queueLock;
+static HANDLE queueEvent;
+static Worker* writer;
+
+static volatile bool capturing;
+static volatile bool stopping;
+
+static FILE* captureFile;
+static CaptureSlot slots[CAPTURE_QUEUE_SLOTS];
+static int queueHead, queueCount;
+
+static unsigned int frameNumber, framesSinceKey, droppedFrames;
+static unsigned short* previousPixels;
+static int previousWidth, previousHeight;
+
+void _capture_Init()
+{
+	InitializeCriticalSection(&captureLock);
+	InitializeCriticalSection(&queueLock);
+	capturing = false;
+	captureFile = NULL;
+	writer = NULL;
+	previousPixels = NULL;
+}
+
+void _capture_Destroy()
+{
+	_capture_Stop();
+	DeleteCriticalSection(&queueLock);
+	DeleteCriticalSection(&captureLock);
+}
+
+static void CaptureWriter(void* unused)
+{
+	for (;;)
+	{
+		WaitForSingleObject(queueEvent, INFINITE);
+
+		// Drain everything queued; only quit once the queue is empty.
+		for (;;)
+		{
+			EnterCriticalSection(&queueLock);
+			if (queueCount == 0)
+			{
+				bool done = stopping;
+				LeaveCriticalSection(&queueLock);
+				if (done)
+					return;
+				break;
+			}
+			CaptureSlot* slot = &slots[queueHead];
+			LeaveCriticalSection(&queueLock);
+
+			fwrite(slot->data, 1, slot->size, captureFile);
+
+			EnterCriticalSection(&queueLock);
+			queueHead = (queueHead + 1) % CAPTURE_QUEUE_SLOTS;
+			queueCount--;
+			LeaveCriticalSection(&queueLock);
+		}
+	}
+}
+
+bool _capture_Start(const char* path)
+{
+	_capture_Stop();
+
+	EnterCriticalSection(&captureLock);
+
+	captureFile = fopen(path, "wb");
+	if (captureFile == NULL)
+	{
+		LeaveCriticalSection(&captureLock);
+		return false;
+	}
+
+	CaptureFileHeader header;
+	memcpy(header.magic, "4DOV", 4);
+	header.version = CAPTURE_VERSION;
+	fwrite(&header, sizeof(header), 1, captureFile);
+
+	for (int i = 0; i < CAPTURE_QUEUE_SLOTS; i++)
+		slots[i].data = new unsigned char[CAPTURE_SLOT_SIZE];
+	previousPixels = new unsigned short[CAPTURE_MAX_WIDTH * CAPTURE_MAX_HEIGHT];
+	previousWidth = previousHeight = 0;
+
+	queueHead = queueCount = 0;
+	frameNumber = framesSinceKey = droppedFrames = 0;
+	stopping = false;
+
+	queueEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	writer = new Worker(CaptureWriter, NULL);
+	writer->Run();
+
+	capturing = true;
+	LeaveCriticalSection(&captureLock);
+	return true;
+}
+
+unsigned int _capture_Stop()
+{
+	EnterCriticalSection(&captureLock);
+
+	if (!capturing)
+	{
+		LeaveCriticalSection(&captureLock);
+		return 0;
+	}
+	capturing = false;
+
+	// Let the writer flush what is queued, then tear everything down.
+	EnterCriticalSection(&queueLock);
+	stopping = true;
+	LeaveCriticalSection(&queueLock);
+	SetEvent(queueEvent);
+	writer->Wait();
+	delete writer;
+	writer = NULL;
+	CloseHandle(queueEvent);
+
+	fclose(captureFile);
+	captureFile = NULL;
+
+	for (int i = 0; i < CAPTURE_QUEUE_SLOTS; i++)
+	{
+		delete[] slots[i].data;
+		slots[i].data = NULL;
+	}
+	delete[] previousPixels;
+	previousPixels = NULL;
+
+	unsigned int dropped = droppedFrames;
+	LeaveCriticalSection(&captureLock);
+	return dropped;
+}
+
+static unsigned int EncodeFrame(VDLFrame* frame, unsigned char* out)
+{
+	int width = 320 << RESSCALE;
+	int height = 240 << RESSCALE;
+	int lineBytes = width * sizeof(unsigned short);
+
+	bool key = (framesSinceKey == 0) || width != previousWidth || height != previousHeight;
+	framesSinceKey = (framesSinceKey + 1) % CAPTURE_KEY_INTERVAL;
+	previousWidth = width;
+	previousHeight = height;
+
+	CaptureFrameHeader* header = (CaptureFrameHeader*)out;
+	header->frame = frameNumber;
+	header->width = (unsigned short)width;
+	header->height = (unsigned short)height;
+	header->flags = key ? CAPTURE_FRAME_KEY : 0;
+
+	unsigned char* ptr = out + sizeof(CaptureFrameHeader);
+	VDLLine* lastLine = NULL;
+	for (int line = 0; line < height; line++)
+	{
+		VDLLine* linePtr = &frame->lines[line];
+		unsigned short* previous = previousPixels + line * width;
+		unsigned char* flags = ptr++;
+
+		*flags = 0;
+		// VDLP emits a new CLUT set only when the CLUT changed.
+		if (lastLine == NULL || linePtr->xCLUTSET != lastLine->xCLUTSET)
+		{
+			*flags |= CAPTURE_LINE_CLUT;
+			memcpy(ptr, &frame->cluts[linePtr->xCLUTSET], sizeof(VDLClut));
+			ptr += sizeof(VDLClut);
+		}
+		if (lastLine == NULL || memcmp(&linePtr->xOUTCONTROLL, &lastLine->xOUTCONTROLL, CAPTURE_CONTROL_SIZE) != 0)
+		{
+			*flags |= CAPTURE_LINE_CONTROL;
+			memcpy(ptr, &linePtr->xOUTCONTROLL, CAPTURE_CONTROL_SIZE);
+			ptr += CAPTURE_CONTROL_SIZE;
+		}
+		if (key || memcmp(linePtr->line, previous, lineBytes) != 0)
+		{
+			*flags |= CAPTURE_LINE_PIXELS;
+			memcpy(ptr, linePtr->line, lineBytes);
+			memcpy(previous, linePtr->line, lineBytes);
+			ptr += lineBytes;
+		}
+		lastLine = linePtr;
+	}
+
+	header->size = (unsigned int)(ptr - out - sizeof(CaptureFrameHeader));
+	return (unsigned int)(ptr - out);
+}
+
+void _capture_Frame(VDLFrame* frame)
+{
+	if (!capturing)
+		return;
+
+	EnterCriticalSection(&captureLock);
+	if (!capturing)
+	{
+		LeaveCriticalSection(&captureLock);
+		return;
+	}
+
+	// Never wait for the disk: with the queue full the frame is dropped, and
+	// the next encoded frame still deltas against the last one written.
+	EnterCriticalSection(&queueLock);
+	bool full = (queueCount == CAPTURE_QUEUE_SLOTS);
+	int index = (queueHead + queueCount) % CAPTURE_QUEUE_SLOTS;
+	LeaveCriticalSection(&queueLock);
+
+	if (full)
+		droppedFrames++;
+	else
+	{
+		slots[index].size = EncodeFrame(frame, slots[index].data);
+
+		EnterCriticalSection(&queueLock);
+		queueCount++;
+		LeaveCriticalSection(&queueLock);
+		SetEvent(queueEvent);
+	}
+
+	frameNumber++;
+	LeaveCriticalSection(&captureLock);
+}
@@ -0,0 +1,58 @@
+// capture.h - Streams finished VDL frames to a file from a background thread.
+//
+// The file is the raw scan-out, not RGB:
+//
+//   CaptureFileHeader
+//   per frame:  CaptureFrameHeader, then frame.height line records
+//   per line:   one flags byte, followed by (in this order, when flagged)
+//                 CAPTURE_LINE_CLUT     xCLUTB, xCLUTG, xCLUTR (96 bytes)
+//                 CAPTURE_LINE_CONTROL  xOUTCONTROLL, xCLUTDMA, xBACKGROUND
+//                 CAPTURE_LINE_PIXELS   width 16-bit VDL pixels
+//
+// A line without CLUT/CONTROL repeats the previous line's values (the first
+// line of a frame always carries them). A line without PIXELS repeats the
+// same line of the previous frame in the file; key frames carry every line.
+
+#ifndef	CAPTURE_3DO_HEADER
+#define CAPTURE_3DO_HEADER
+
+#include "freedocore.h"
+
+#define CAPTURE_VERSION        1
+#define CAPTURE_KEY_INTERVAL   60
+#define CAPTURE_QUEUE_SLOTS    8
+
+#define CAPTURE_FRAME_KEY      0x01
+
+#define CAPTURE_LINE_CLUT      0x01
+#define CAPTURE_LINE_CONTROL   0x02
+#define CAPTURE_LINE_PIXELS    0x04
+
+#pragma pack(push,1)
+
+struct CaptureFileHeader
+{
+	char magic[4];          // "4DOV"
+	unsigned int version;
+};
+
+struct CaptureFrameHeader
+{
+	unsigned int frame;     // emulated frame number, gaps are dropped frames
+	unsigned short width;
+	unsigned short height;
+	unsigned int flags;
+	unsigned int size;      // bytes of line records that follow
+};
+
+#pragma pack(pop)
+
+void _capture_Init();
+void _capture_Destroy();
+
+bool _capture_Start(const char* path);
+unsigned int _capture_Stop();   // returns the number of dropped frames
+
+void _capture_Frame(VDLFrame* frame);
+
+#endif
@@ -0,0 +1,324 @@
+#include <string.h>
+#include "freedoconfig.h"
+#include "cdcache.h"
+#include "disc.h"
+#include "cdtrace.h"
+#include "Worker.h"
+
+#define CDCACHE_EMPTY          0xFFFFFFFF
+
+extern void _3do_Read2048(void *buff);
+extern void _3do_OnSector(unsigned int sector);
+extern unsigned int _3do_DiscSize();
+
+struct CacheSlot
+{
+	unsigned int sector;
+	bool loading;           // claimed, the data is still on its way
+	unsigned char data[CDCACHE_SECTOR_SIZE];
+};
+
+static CRITICAL_SECTION cacheLock;      // slots and the read-ahead window
+static CRITICAL_SECTION hostLock;       // keeps each OnSector/Read2048 pair together
+static HANDLE workEvent, loadedEvent;
+static Worker* reader;
+static bool stopping;
+
+static CacheSlot slots[CDCACHE_SLOTS];
+static unsigned int wantFrom, wantTo, requestEnd;
+static unsigned char readerBuffer[CDCACHE_SECTOR_SIZE];
+
+// Filled before the core runs and only read while it does.
+static CDCacheRun* preloadRuns;
+static unsigned int* preloadOffsets;    // first sector of each run in preloadData
+static int preloadRunCount;
+static unsigned char* preloadData;
+
+// From a compressed image when one is open, so the read-ahead thread is
+// the one decompressing; otherwise from the host.
+static void ReadFromSource(unsigned int sector, unsigned char* buff)
+{
+	if (_disc_IsOpen())
+	{
+		_disc_Read(sector, buff);
+		return;
+	}
+
+	EnterCriticalSection(&hostLock);
+	_3do_OnSector(sector);
+	_3do_Read2048(buff);
+	LeaveCriticalSection(&hostLock);
+}
+
+static const unsigned char* FindPreloaded(unsigned int sector)
+{
+	int low = 0, high = preloadRunCount - 1;
+
+	while (low <= high)
+	{
+		int middle = (low + high) / 2;
+		const CDCacheRun* run = &preloadRuns[middle];
+
+		if (sector < run->sector)
+			high = middle - 1;
+		else if (sector >= run->sector + run->count)
+			low = middle + 1;
+		else
+			return preloadData + (preloadOffsets[middle] + sector - run->sector) * CDCACHE_SECTOR_SIZE;
+	}
+
+	return NULL;
+}
+
+static void FreePreload()
+{
+	delete[] preloadData;
+	delete[] preloadOffsets;
+	delete[] preloadRuns;
+	preloadData = NULL;
+	preloadOffsets = NULL;
+	preloadRuns = NULL;
+	preloadRunCount = 0;
+}
+
+static void CacheReader(void* unused)
+{
+	for (;;)
+	{
+		WaitForSingleObject(workEvent, INFINITE);
+
+		for (;;)
+		{
+			EnterCriticalSection(&cacheLock);
+			if (stopping)
+			{
+				LeaveCriticalSection(&cacheLock);
+				return;
+			}
+
+			// The nearest sector of the window that nobody has claimed yet.
+			CacheSlot* slot = NULL;
+			unsigned int sector;
+			for (sector = wantFrom; sector < wantTo; sector++)
+			{
+				if (slots[sector & (CDCACHE_SLOTS - 1)].sector != sector && FindPreloaded(sector) == NULL)
+				{
+					slot = &slots[sector & (CDCACHE_SLOTS - 1)];
+					slot->sector = sector;
+					slot->loading = true;
+					break;
+				}
+			}
+			LeaveCriticalSection(&cacheLock);
+
+			if (slot == NULL)
+				break;
+
+			ReadFromSource(sector, readerBuffer);
+
+			// A flush while reading leaves the slot to someone else.
+			EnterCriticalSection(&cacheLock);
+			if (slot->sector == sector && slot->loading)
+			{
+				memcpy(slot->data, readerBuffer, CDCACHE_SECTOR_SIZE);
+				slot->loading = false;
+			}
+			LeaveCriticalSection(&cacheLock);
+			SetEvent(loadedEvent);
+		}
+	}
+}
+
+void _cdcache_Init()
+{
+	InitializeCriticalSection(&cacheLock);
+	InitializeCriticalSection(&hostLock);
+	workEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	loadedEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	stopping = false;
+	_cdcache_Flush();
+
+	reader = new Worker(CacheReader, NULL);
+	reader->Run();
+}
+
+void _cdcache_Destroy()
+{
+	EnterCriticalSection(&cacheLock);
+	stopping = true;
+	LeaveCriticalSection(&cacheLock);
+	SetEvent(workEvent);
+	reader->Wait();
+	delete reader;
+	reader = NULL;
+	FreePreload();
+
+	CloseHandle(loadedEvent);
+	CloseHandle(workEvent);
+	DeleteCriticalSection(&hostLock);
+	DeleteCriticalSection(&cacheLock);
+}
+
+void _cdcache_Flush()
+{
+	EnterCriticalSection(&cacheLock);
+	for (int i = 0; i < CDCACHE_SLOTS; i++)
+	{
+		slots[i].sector = CDCACHE_EMPTY;
+		slots[i].loading = false;
+	}
+	wantFrom = wantTo = requestEnd = 0;
+	LeaveCriticalSection(&cacheLock);
+}
+
+// Called with cacheLock held.
+static void SetWindow(unsigned int from)
+{
+	wantFrom = from;
+	if (from >= requestEnd)
+		wantTo = from;
+	else
+		wantTo = (requestEnd - from > CDCACHE_READAHEAD) ? from + CDCACHE_READAHEAD : requestEnd;
+}
+
+void _cdcache_Prefetch(unsigned int sector, unsigned int count)
+{
+	// A mapped image is read ahead by the OS.
+	if (_disc_IsMapped())
+		return;
+
+	EnterCriticalSection(&cacheLock);
+	requestEnd = sector + count;
+	SetWindow(sector);
+	LeaveCriticalSection(&cacheLock);
+	SetEvent(workEvent);
+}
+
+void _cdcache_Read(unsigned int sector, void *buff)
+{
+	_cdtrace_Read(sector);
+
+	if (_disc_IsMapped())
+	{
+		const unsigned char* data = _disc_Sector(sector);
+		if (data)
+			memcpy(buff, data, CDCACHE_SECTOR_SIZE);
+		else
+			memset(buff, 0, CDCACHE_SECTOR_SIZE);
+		return;
+	}
+
+	const unsigned char* preloaded = FindPreloaded(sector);
+	if (preloaded)
+	{
+		memcpy(buff, preloaded, CDCACHE_SECTOR_SIZE);
+		EnterCriticalSection(&cacheLock);
+		SetWindow(sector + 1);
+		LeaveCriticalSection(&cacheLock);
+		SetEvent(workEvent);
+		return;
+	}
+
+	CacheSlot* slot = &slots[sector & (CDCACHE_SLOTS - 1)];
+
+	EnterCriticalSection(&cacheLock);
+	while (slot->sector == sector && slot->loading)
+	{
+		LeaveCriticalSection(&cacheLock);
+		WaitForSingleObject(loadedEvent, INFINITE);
+		EnterCriticalSection(&cacheLock);
+	}
+
+	if (slot->sector == sector)
+	{
+		memcpy(buff, slot->data, CDCACHE_SECTOR_SIZE);
+		SetWindow(sector + 1);
+		LeaveCriticalSection(&cacheLock);
+	}
+	else
+	{
+		// Claim the slot first so the reader does not fetch it a second time.
+		slot->sector = sector;
+		slot->loading = true;
+		SetWindow(sector + 1);
+		LeaveCriticalSection(&cacheLock);
+
+		ReadFromSource(sector, (unsigned char*)buff);
+
+		EnterCriticalSection(&cacheLock);
+		if (slot->sector == sector)
+		{
+			memcpy(slot->data, buff, CDCACHE_SECTOR_SIZE);
+			slot->loading = false;
+		}
+		LeaveCriticalSection(&cacheLock);
+	}
+
+	SetEvent(workEvent);
+}
+
+unsigned int _cdcache_Preload(const CDCacheRun* runs, int count)
+{
+	unsigned int discSize = _3do_DiscSize();
+	unsigned int total = 0;
+
+	EnterCriticalSection(&cacheLock);
+	FreePreload();
+	LeaveCriticalSection(&cacheLock);
+
+	// Clip the runs to the disc and to the size of the store.
+	CDCacheRun* kept = new CDCacheRun[count > 0 ? count : 1];
+	unsigned int* offsets = new unsigned int[count > 0 ? count : 1];
+	int keptCount = 0;
+	for (int i = 0; i < count && total < CDCACHE_PRELOAD_MAX; i++)
+	{
+		if (runs[i].sector >= discSize)
+			break;
+
+		kept[keptCount] = runs[i];
+		if (kept[keptCount].count > discSize - kept[keptCount].sector)
+			kept[keptCount].count = discSize - kept[keptCount].sector;
+		if (kept[keptCount].count > CDCACHE_PRELOAD_MAX - total)
+			kept[keptCount].count = CDCACHE_PRELOAD_MAX - total;
+
+		offsets[keptCount] = total;
+		total += kept[keptCount].count;
+		keptCount++;
+	}
+
+	if (_disc_IsMapped())
+	{
+		// Touching every sector in order is the sequential read; the page
+		// cache keeps the result.
+		volatile unsigned char sink = 0;
+		for (int i = 0; i < keptCount; i++)
+		{
+			for (unsigned int sector = kept[i].sector; sector < kept[i].sector + kept[i].count; sector++)
+			{
+				const unsigned char* data = _disc_Sector(sector);
+				if (data)
+					sink += data[0];
+			}
+		}
+
+		delete[] offsets;
+		delete[] kept;
+		return total;
+	}
+
+	unsigned char* data = new unsigned char[total ? total * CDCACHE_SECTOR_SIZE : 1];
+	for (int i = 0; i < keptCount; i++)
+	{
+		for (unsigned int j = 0; j < kept[i].count; j++)
+			ReadFromSource(kept[i].sector + j, data + (offsets[i] + j) * CDCACHE_SECTOR_SIZE);
+	}
+
+	EnterCriticalSection(&cacheLock);
+	preloadRuns = kept;
+	preloadOffsets = offsets;
+	preloadRunCount = keptCount;
+	preloadData = data;
+	LeaveCriticalSection(&cacheLock);
+
+	return total;
+}
@@ -0,0 +1,48 @@
+// cdcache.h - Read-ahead sector cache between the CD drive and the host.
+//
+// Every sector still comes from the host as an EXT_ON_SECTOR/EXT_READ2048
+// pair, but once a read command tells the drive how many sectors it wants,
+// a background thread fetches up to CDCACHE_READAHEAD of them ahead of the
+// drive. _cdcache_Read then usually finds its sector already in memory
+// instead of waiting for the host to seek and read on the emulation thread.
+//
+// The pairs may now arrive on that thread; they never interleave. With a
+// disc image opened by disc.cpp the host is not involved at all: a plain
+// image is read straight from its mapping, a compressed one goes through
+// the cache so that the thread does the decompressing.
+//
+// _cdcache_Preload reads a list of runs (a boot profile, see cdtrace.h)
+// ahead of time, in sector order, into a store that _cdcache_Read looks in
+// first. For a mapped image it only touches the sectors so the OS pulls
+// them into the page cache in one sequential sweep.
+
+#ifndef	CDCACHE_3DO_HEADER
+#define CDCACHE_3DO_HEADER
+
+#define CDCACHE_SECTOR_SIZE    2048
+#define CDCACHE_SLOTS          64      // power of two, more than CDCACHE_READAHEAD
+#define CDCACHE_READAHEAD      32
+#define CDCACHE_PRELOAD_MAX    16384   // sectors, 32 MB
+
+struct CDCacheRun
+{
+	unsigned int sector;
+	unsigned int count;
+};
+
+void _cdcache_Init();
+void _cdcache_Destroy();
+
+// Forget everything cached, for a new disc.
+void _cdcache_Flush();
+
+// A read command for count sectors starting at sector was issued.
+void _cdcache_Prefetch(unsigned int sector, unsigned int count);
+// Copies one sector into buff, from the cache or straight from the host.
+void _cdcache_Read(unsigned int sector, void *buff);
+
+// runs must be sorted and must not overlap. Replaces any earlier preload;
+// call while the core is not running. Returns the number of sectors read.
+unsigned int _cdcache_Preload(const CDCacheRun* runs, int count);
+
+#endif
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freedoconfig.h"
+#include "freedocore.h"
+#include "cdtrace.h"
+#include "cdcache.h"
+
+struct TraceBurst
+{
+	unsigned int frame;
+	unsigned int sector;
+	unsigned int count;
+};
+
+// Only the emulation thread records; the host starts and stops the trace
+// while the core is not running.
+static TraceBurst* bursts;
+static unsigned int burstCount;
+static unsigned int droppedSectors;
+static unsigned int frame;
+static bool tracing;
+static bool bootValid;
+
+bool _cdtrace_Start()
+{
+	if (tracing)
+		return true;
+
+	bursts = new TraceBurst[CDTRACE_MAX_BURSTS];
+	burstCount = 0;
+	droppedSectors = 0;
+	frame = 0;
+	bootValid = true;
+	tracing = true;
+	return true;
+}
+
+void _cdtrace_Frame()
+{
+	frame++;
+}
+
+void _cdtrace_StateLoaded()
+{
+	bootValid = false;
+}
+
+void _cdtrace_Read(unsigned int sector)
+{
+	if (!tracing)
+		return;
+
+	if (burstCount)
+	{
+		TraceBurst* last = &bursts[burstCount - 1];
+		if (last->sector + last->count == sector && frame - last->frame < CDTRACE_BURST_FRAMES)
+		{
+			last->count++;
+			return;
+		}
+	}
+
+	if (burstCount == CDTRACE_MAX_BURSTS)
+	{
+		droppedSectors++;
+		return;
+	}
+
+	bursts[burstCount].frame = frame;
+	bursts[burstCount].sector = sector;
+	bursts[burstCount].count = 1;
+	burstCount++;
+}
+
+static int CompareRuns(const void* a, const void* b)
+{
+	unsigned int sectorA = ((const CDCacheRun*)a)->sector;
+	unsigned int sectorB = ((const CDCacheRun*)b)->sector;
+	return (sectorA > sectorB) - (sectorA < sectorB);
+}
+
+// Sorts runs by sector and merges the ones that overlap or touch. Returns
+// the new count.
+static int MergeRuns(CDCacheRun* runs, int count)
+{
+	int merged = 0;
+
+	if (count == 0)
+		return 0;
+
+	qsort(runs, count, sizeof(CDCacheRun), CompareRuns);
+	for (int i = 1; i < count; i++)
+	{
+		CDCacheRun* last = &runs[merged];
+		if (runs[i].sector <= last->sector + last->count)
+		{
+			unsigned int end = runs[i].sector + runs[i].count;
+			if (end > last->sector + last->count)
+				last->count = end - last->sector;
+		}
+		else
+			runs[++merged] = runs[i];
+	}
+
+	return merged + 1;
+}
+
+static bool WriteTrace(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "# frame sector count\n");
+	for (unsigned int i = 0; i < burstCount; i++)
+		fprintf(file, "%u %u %u\n", bursts[i].frame, bursts[i].sector, bursts[i].count);
+	if (droppedSectors)
+		fprintf(file, "# trace full, %u more sectors not recorded\n", droppedSectors);
+
+	return fclose(file) == 0;
+}
+
+static bool WriteProfile(const char* path, unsigned int bootFrames)
+{
+	CDCacheRun* runs = new CDCacheRun[burstCount + 1];
+	int count = 0;
+
+	for (unsigned int i = 0; i < burstCount && bursts[i].frame < bootFrames; i++)
+	{
+		runs[count].sector = bursts[i].sector;
+		runs[count].count = bursts[i].count;
+		count++;
+	}
+	count = MergeRuns(runs, count);
+
+	FILE* file = fopen(path, "w");
+	bool written = false;
+	if (file != NULL)
+	{
+		fprintf(file, "# sector count, read in the first %u frames\n", bootFrames);
+		for (int i = 0; i < count; i++)
+			fprintf(file, "%u %u\n", runs[i].sector, runs[i].count);
+		written = fclose(file) == 0;
+	}
+
+	delete[] runs;
+	return written;
+}
+
+bool _cdtrace_Stop(const SectorTraceRequest* request)
+{
+	bool profiled = false;
+
+	if (!tracing)
+		return false;
+	tracing = false;
+
+	if (request != NULL)
+	{
+		unsigned int bootFrames = request->bootSeconds * 60;
+
+		if (request->tracePath != NULL)
+			WriteTrace(request->tracePath);
+
+		if (request->profilePath != NULL && bootValid)
+		{
+			// A short session only makes a profile when there is none yet.
+			FILE* existing = (frame < bootFrames) ? fopen(request->profilePath, "r") : NULL;
+			if (existing != NULL)
+				fclose(existing);
+			else
+				profiled = WriteProfile(request->profilePath, bootFrames);
+		}
+	}
+
+	delete[] bursts;
+	bursts = NULL;
+	burstCount = 0;
+	return profiled;
+}
+
+unsigned int _cdtrace_Preload(const char* profilePath)
+{
+	FILE* file = fopen(profilePath, "r");
+	if (file == NULL)
+		return 0;
+
+	CDCacheRun* runs = new CDCacheRun[CDTRACE_MAX_RUNS];
+	int count = 0;
+	char line[128];
+
+	while (count < CDTRACE_MAX_RUNS && fgets(line, sizeof(line), file) != NULL)
+	{
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%u %u", &runs[count].sector, &runs[count].count) == 2 && runs[count].count)
+			count++;
+	}
+	fclose(file);
+
+	// Profiles are written sorted, but one edited by hand may not be.
+	count = MergeRuns(runs, count);
+
+	unsigned int preloaded = _cdcache_Preload(runs, count);
+	delete[] runs;
+	return preloaded;
+}
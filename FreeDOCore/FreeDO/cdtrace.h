@@ -0,0 +1,44 @@
+// cdtrace.h - Records which disc sectors a game reads, and preloads the
+// ones it needs to boot.
+//
+// While a trace runs, every sector the drive takes from _cdcache_Read is
+// logged against the emulated time, counted in frames (1/60 s) since the
+// trace started. Sequential reads are folded into bursts; a burst is cut
+// after CDTRACE_BURST_FRAMES so a long stream still shows when it was read.
+//
+// _cdtrace_Stop writes two text files:
+//
+//   trace    one burst per line:  <frame> <sector> <count>
+//   profile  the sectors read in the first bootSeconds after power on,
+//            sorted and merged into runs, one per line:  <sector> <count>
+//
+// Lines starting with '#' are comments. _cdtrace_Preload reads a profile
+// back and hands its runs to _cdcache_Preload, which reads them all in one
+// pass in sector order before the game asks for any of them.
+
+#ifndef	CDTRACE_3DO_HEADER
+#define CDTRACE_3DO_HEADER
+
+#include "freedocore.h"
+
+#define CDTRACE_MAX_BURSTS     65536
+#define CDTRACE_BURST_FRAMES   60
+#define CDTRACE_MAX_RUNS       4096    // runs read from a profile
+
+// Start tracing from this frame on; call right after _3do_Init so that the
+// boot profile starts at power on.
+bool _cdtrace_Start();
+// Writes the files named by the request and stops. Returns true if the
+// profile was written: it is not when a state was loaded during the trace,
+// nor when the trace is shorter than the boot window and a profile exists.
+bool _cdtrace_Stop(const SectorTraceRequest* request);
+
+void _cdtrace_Frame();
+void _cdtrace_Read(unsigned int sector);
+// A state load jumps in time, so what follows is no longer a boot.
+void _cdtrace_StateLoaded();
+
+// Returns the number of sectors preloaded.
+unsigned int _cdtrace_Preload(const char* profilePath);
+
+#endif
@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <string.h>
+#include <windows.h>
+#include "freedoconfig.h"
+#include "disc.h"
+#include "discz.h"
+
+#define DISC_RAW_SECTOR_SIZE   2352
+#define DISC_RAW_DATA_OFFSET   16      // sync and header of a MODE1 raw sector
+#define DISC_MAX_PATH          1024
+#define DISC_MAX_CUE_SIZE      65536
+#define DISC_LABEL_BLOCKCOUNT  80      // big-endian block count in the volume label
+
+struct DiscImage
+{
+	HANDLE file;
+	HANDLE mapping;
+	const unsigned char* view;
+	DiscZ* packed;              // set for compressed images
+	unsigned int sectors;
+	unsigned int sectorSize;
+	unsigned int dataOffset;
+};
+
+static DiscImage disc = { INVALID_HANDLE_VALUE, NULL, NULL, NULL };
+static unsigned int discBlockCount;
+
+static bool HasExtension(const char* path, const char* extension)
+{
+	const char* dot = strrchr(path, '.');
+	if (dot == NULL || strchr(dot, '\\') || strchr(dot, '/'))
+		return false;
+	return _stricmp(dot, extension) == 0;
+}
+
+static void ReplaceExtension(char* path, const char* extension)
+{
+	char* dot = strrchr(path, '.');
+	if (dot == NULL || strchr(dot, '\\') || strchr(dot, '/'))
+		dot = path + strlen(path);
+	strcpy(dot, extension);
+}
+
+static const char* SkipSpaces(const char* text)
+{
+	while (*text == ' ' || *text == '\t')
+		text++;
+	return text;
+}
+
+static bool Keyword(const char** text, const char* keyword)
+{
+	size_t length = strlen(keyword);
+	if (_strnicmp(*text, keyword, length) != 0)
+		return false;
+	*text = SkipSpaces(*text + length);
+	return true;
+}
+
+// Accepts the same cue sheets the host does: one BINARY file holding one
+// MODE1 track.
+static bool ReadCue(const char* cuePath, char* dataPath, unsigned int* sectorSize)
+{
+	FILE* cue = fopen(cuePath, "rb");
+	if (cue == NULL)
+		return false;
+
+	static char text[DISC_MAX_CUE_SIZE + 1];
+	size_t size = fread(text, 1, DISC_MAX_CUE_SIZE, cue);
+	fclose(cue);
+	text[size] = 0;
+
+	char fileName[DISC_MAX_PATH] = "";
+	int files = 0, tracks = 0;
+	bool binary = false;
+	*sectorSize = 0;
+
+	for (char* line = strtok(text, "\r\n"); line != NULL; line = strtok(NULL, "\r\n"))
+	{
+		const char* p = SkipSpaces(line);
+		if (Keyword(&p, "FILE"))
+		{
+			files++;
+			const char* end;
+			if (*p == '"')
+				end = strchr(++p, '"');
+			else
+				end = p + strcspn(p, " \t");
+			if (end == NULL || end - p >= DISC_MAX_PATH)
+				return false;
+			memcpy(fileName, p, end - p);
+			fileName[end - p] = 0;
+
+			p = SkipSpaces(*end == '"' ? end + 1 : end);
+			binary = Keyword(&p, "BINARY");
+		}
+		else if (Keyword(&p, "TRACK"))
+		{
+			tracks++;
+			p += strcspn(p, " \t");
+			p = SkipSpaces(p);
+			if (Keyword(&p, "MODE1/2048"))
+				*sectorSize = DISC_SECTOR_SIZE;
+			else if (Keyword(&p, "MODE1/2352"))
+				*sectorSize = DISC_RAW_SECTOR_SIZE;
+		}
+	}
+
+	if (files != 1 || tracks != 1 || !binary || *sectorSize == 0)
+		return false;
+
+	// The file name is relative to the cue sheet.
+	strcpy(dataPath, cuePath);
+	char* slash = strrchr(dataPath, '\\');
+	char* otherSlash = strrchr(dataPath, '/');
+	if (otherSlash > slash)
+		slash = otherSlash;
+	char* name = (slash == NULL) ? dataPath : slash + 1;
+	if ((name - dataPath) + strlen(fileName) >= DISC_MAX_PATH)
+		return false;
+	strcpy(name, fileName);
+	return true;
+}
+
+// No usable cue sheet: the same guess the host makes from name and size.
+static unsigned int GuessSectorSize(const char* path, LONGLONG size)
+{
+	if (HasExtension(path, ".iso"))
+		return (size % DISC_SECTOR_SIZE != 0 && size % DISC_RAW_SECTOR_SIZE == 0) ? DISC_RAW_SECTOR_SIZE : DISC_SECTOR_SIZE;
+	return (size % DISC_RAW_SECTOR_SIZE != 0 && size % DISC_SECTOR_SIZE == 0) ? DISC_SECTOR_SIZE : DISC_RAW_SECTOR_SIZE;
+}
+
+static void CloseImage(DiscImage* image)
+{
+	_discz_Close(image->packed);
+	if (image->view != NULL)
+		UnmapViewOfFile(image->view);
+	if (image->mapping != NULL)
+		CloseHandle(image->mapping);
+	if (image->file != INVALID_HANDLE_VALUE)
+		CloseHandle(image->file);
+
+	image->file = INVALID_HANDLE_VALUE;
+	image->mapping = NULL;
+	image->view = NULL;
+	image->packed = NULL;
+	image->sectors = 0;
+}
+
+static bool OpenImage(DiscImage* image, const char* path)
+{
+	if (strlen(path) >= DISC_MAX_PATH - 4)
+		return false;
+
+	char dataPath[DISC_MAX_PATH];
+	char cuePath[DISC_MAX_PATH];
+	unsigned int sectorSize = 0;
+
+	strcpy(cuePath, path);
+	ReplaceExtension(cuePath, ".cue");
+	if (!ReadCue(cuePath, dataPath, &sectorSize))
+	{
+		strcpy(dataPath, path);
+		sectorSize = 0;
+	}
+
+	image->file = CreateFileA(dataPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (image->file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(image->file, &size) || size.QuadPart < DISC_SECTOR_SIZE)
+	{
+		CloseImage(image);
+		return false;
+	}
+
+	image->mapping = CreateFileMappingA(image->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (image->mapping != NULL)
+		image->view = (const unsigned char*)MapViewOfFile(image->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (image->view == NULL)
+	{
+		// Typically no room for the whole image in a 32-bit address space.
+		CloseImage(image);
+		return false;
+	}
+
+	image->packed = _discz_Open(image->view, size.QuadPart);
+	if (image->packed != NULL)
+	{
+		image->sectors = _discz_SectorCount(image->packed);
+		return true;
+	}
+
+	if (sectorSize == 0)
+		sectorSize = GuessSectorSize(dataPath, size.QuadPart);
+	image->sectorSize = sectorSize;
+	image->dataOffset = (sectorSize == DISC_RAW_SECTOR_SIZE) ? DISC_RAW_DATA_OFFSET : 0;
+	image->sectors = (unsigned int)(size.QuadPart / sectorSize);
+	return true;
+}
+
+static bool ReadImage(DiscImage* image, unsigned int sector, void* buff)
+{
+	if (image->packed != NULL)
+		return _discz_Read(image->packed, sector, buff);
+	if (sector >= image->sectors)
+		return false;
+	memcpy(buff, image->view + (size_t)sector * image->sectorSize + image->dataOffset, DISC_SECTOR_SIZE);
+	return true;
+}
+
+bool _disc_Open(const char* path)
+{
+	_disc_Close();
+	if (!OpenImage(&disc, path))
+		return false;
+
+	unsigned char label[DISC_SECTOR_SIZE];
+	if (!ReadImage(&disc, 0, label))
+	{
+		_disc_Close();
+		return false;
+	}
+	const unsigned char* count = label + DISC_LABEL_BLOCKCOUNT;
+	discBlockCount = (count[0] << 24) | (count[1] << 16) | (count[2] << 8) | count[3];
+	return true;
+}
+
+void _disc_Close()
+{
+	CloseImage(&disc);
+	discBlockCount = 0;
+}
+
+bool _disc_IsOpen()
+{
+	return disc.view != NULL;
+}
+
+bool _disc_IsMapped()
+{
+	return disc.view != NULL && disc.packed == NULL;
+}
+
+unsigned int _disc_BlockCount()
+{
+	return discBlockCount;
+}
+
+const unsigned char* _disc_Sector(unsigned int sector)
+{
+	if (disc.packed != NULL || sector >= disc.sectors)
+		return NULL;
+	return disc.view + (size_t)sector * disc.sectorSize + disc.dataOffset;
+}
+
+bool _disc_Read(unsigned int sector, void* buff)
+{
+	if (disc.view != NULL && ReadImage(&disc, sector, buff))
+		return true;
+	memset(buff, 0, DISC_SECTOR_SIZE);
+	return false;
+}
+
+static bool CompressSource(void* context, unsigned int sector, void* buff)
+{
+	return ReadImage((DiscImage*)context, sector, buff);
+}
+
+bool _disc_Compress(const char* source, const char* target)
+{
+	DiscImage image = { INVALID_HANDLE_VALUE, NULL, NULL, NULL };
+	if (!OpenImage(&image, source))
+		return false;
+
+	bool ok = _discz_Write(target, image.sectors, CompressSource, &image);
+	CloseImage(&image);
+	return ok;
+}
@@ -0,0 +1,39 @@
+// disc.h - Serves disc sectors straight from a memory-mapped image.
+//
+// The host can hand the core the path of the image it is about to run. An
+// .iso or a single-track BIN/CUE (MODE1/2048 or MODE1/2352, the .cue being
+// the image's name with the extension changed) is mapped read-only and
+// every sector is then read from the mapping, without calling back into
+// the host; the OS page cache takes care of repeated reads. A compressed
+// .4doz image (see discz.h) is mapped the same way and decompressed a hunk
+// at a time as sectors are read. Anything the core cannot open leaves the
+// host's EXT_READ2048 path in charge.
+//
+// The disc lives outside _3do_Init/_3do_Destroy: open it before the core
+// starts, so the drive sees its size, and close it once the core is gone.
+
+#ifndef	DISC_3DO_HEADER
+#define DISC_3DO_HEADER
+
+#define DISC_SECTOR_SIZE       2048
+
+bool _disc_Open(const char* path);
+void _disc_Close();
+
+bool _disc_IsOpen();
+// The size the volume label gives, as the host reports it for EXT_GET_DISC_SIZE.
+unsigned int _disc_BlockCount();
+// True when sectors can be used in place, i.e. the image is not compressed.
+bool _disc_IsMapped();
+// The user data of one sector, NULL past the end of the disc or when the
+// image is not mapped.
+const unsigned char* _disc_Sector(unsigned int sector);
+// Copies one sector from any kind of image; zeroes and false past the end.
+// Safe to call from several threads.
+bool _disc_Read(unsigned int sector, void* buff);
+
+// Writes the image at source to target as a compressed image. Does not
+// touch the open disc.
+bool _disc_Compress(const char* source, const char* target);
+
+#endif
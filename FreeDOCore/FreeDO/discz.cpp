@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <string.h>
+#include <windows.h>
+#include "freedoconfig.h"
+#include "discz.h"
+
+#define DISCZ_EMPTY            0xFFFFFFFF
+
+#define LZ4_MIN_MATCH          4
+#define LZ4_LAST_LITERALS      5       // a block always ends in this many literals
+#define LZ4_MATCH_LIMIT        12      // no match may start closer to the end
+#define LZ4_MAX_OFFSET         65535
+#define LZ4_HASH_BITS          12
+
+struct CachedHunk
+{
+	unsigned int hunk;
+	unsigned int lastUse;
+	unsigned char data[DISCZ_HUNK_SIZE];
+};
+
+struct DiscZ
+{
+	const unsigned char* data;
+	unsigned long long size;
+	DiscZHeader header;
+	const unsigned char* offsets;
+
+	CRITICAL_SECTION lock;      // the hunk cache
+	unsigned int useCounter;
+	CachedHunk cache[DISCZ_CACHE_HUNKS];
+};
+
+static unsigned long long ReadOffset(const unsigned char* p)
+{
+	unsigned long long value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static unsigned int Read32(const unsigned char* p)
+{
+	unsigned int value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+// Decodes one LZ4 block, refusing anything that would read or write out
+// of bounds. Returns the decoded size or -1.
+static int LZ4Decode(const unsigned char* src, int srcSize, unsigned char* dst, int dstSize)
+{
+	const unsigned char* ip = src;
+	const unsigned char* iend = src + srcSize;
+	unsigned char* op = dst;
+	unsigned char* oend = dst + dstSize;
+
+	while (ip < iend)
+	{
+		unsigned int token = *ip++;
+
+		unsigned int literals = token >> 4;
+		if (literals == 15)
+		{
+			unsigned int b;
+			do
+			{
+				if (ip >= iend)
+					return -1;
+				b = *ip++;
+				literals += b;
+			} while (b == 255);
+		}
+		if (literals > (unsigned int)(iend - ip) || literals > (unsigned int)(oend - op))
+			return -1;
+		memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+
+		// The last sequence has no match.
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return -1;
+		unsigned int offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (unsigned int)(op - dst))
+			return -1;
+
+		unsigned int length = token & 15;
+		if (length == 15)
+		{
+			unsigned int b;
+			do
+			{
+				if (ip >= iend)
+					return -1;
+				b = *ip++;
+				length += b;
+			} while (b == 255);
+		}
+		length += LZ4_MIN_MATCH;
+		if (length > (unsigned int)(oend - op))
+			return -1;
+
+		// Byte by byte: the match may overlap what it produces.
+		const unsigned char* match = op - offset;
+		while (length--)
+			*op++ = *match++;
+	}
+
+	return (int)(op - dst);
+}
+
+static unsigned char* PutLength(unsigned char* op, unsigned int length)
+{
+	for (; length >= 255; length -= 255)
+		*op++ = 255;
+	*op++ = (unsigned char)length;
+	return op;
+}
+
+// Greedy single-probe LZ4 compressor. Returns the block size, or 0 when
+// the block would not fit in dstCapacity.
+static int LZ4Encode(const unsigned char* src, int srcSize, unsigned char* dst, int dstCapacity)
+{
+	int table[1 << LZ4_HASH_BITS];
+	for (int i = 0; i < (1 << LZ4_HASH_BITS); i++)
+		table[i] = -1;
+
+	unsigned char* op = dst;
+	unsigned char* oend = dst + dstCapacity;
+	int anchor = 0;
+
+	for (int pos = 0; pos + LZ4_MATCH_LIMIT < srcSize; )
+	{
+		unsigned int sequence = Read32(src + pos);
+		unsigned int hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+		int candidate = table[hash];
+		table[hash] = pos;
+
+		if (candidate < 0 || pos - candidate > LZ4_MAX_OFFSET || Read32(src + candidate) != sequence)
+		{
+			pos++;
+			continue;
+		}
+
+		int length = LZ4_MIN_MATCH;
+		int limit = srcSize - LZ4_LAST_LITERALS;
+		while (pos + length < limit && src[candidate + length] == src[pos + length])
+			length++;
+
+		// Token, both length extensions, the literals and the offset.
+		unsigned int literals = pos - anchor;
+		if ((oend - op) < (int)(1 + literals / 255 + 1 + literals + 2 + (length - LZ4_MIN_MATCH) / 255 + 1))
+			return 0;
+
+		unsigned int matchCode = length - LZ4_MIN_MATCH;
+		unsigned char* token = op++;
+		*token = (unsigned char)(((literals < 15) ? literals : 15) << 4);
+		if (literals >= 15)
+			op = PutLength(op, literals - 15);
+		memcpy(op, src + anchor, literals);
+		op += literals;
+
+		unsigned int offset = pos - candidate;
+		*op++ = (unsigned char)offset;
+		*op++ = (unsigned char)(offset >> 8);
+
+		*token |= (matchCode < 15) ? matchCode : 15;
+		if (matchCode >= 15)
+			op = PutLength(op, matchCode - 15);
+
+		pos += length;
+		anchor = pos;
+	}
+
+	unsigned int literals = srcSize - anchor;
+	if ((oend - op) < (int)(1 + literals / 255 + 1 + literals))
+		return 0;
+	*op++ = (unsigned char)(((literals < 15) ? literals : 15) << 4);
+	if (literals >= 15)
+		op = PutLength(op, literals - 15);
+	memcpy(op, src + anchor, literals);
+	op += literals;
+
+	return (int)(op - dst);
+}
+
+DiscZ* _discz_Open(const unsigned char* data, unsigned long long size)
+{
+	DiscZHeader header;
+	if (size < sizeof(header))
+		return NULL;
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, "4DOZ", 4) != 0 || header.version != DISCZ_VERSION
+		|| header.sectorSize != DISCZ_SECTOR_SIZE
+		|| header.hunkSectors == 0 || header.hunkSectors > DISCZ_HUNK_SECTORS
+		|| header.hunks != (header.sectors + header.hunkSectors - 1) / header.hunkSectors
+		|| size < sizeof(header) + (header.hunks + 1ull) * sizeof(unsigned long long))
+		return NULL;
+
+	DiscZ* image = new DiscZ;
+	image->data = data;
+	image->size = size;
+	image->header = header;
+	image->offsets = data + sizeof(header);
+	InitializeCriticalSection(&image->lock);
+	image->useCounter = 0;
+	for (int i = 0; i < DISCZ_CACHE_HUNKS; i++)
+		image->cache[i].hunk = DISCZ_EMPTY;
+	return image;
+}
+
+void _discz_Close(DiscZ* image)
+{
+	if (image == NULL)
+		return;
+	DeleteCriticalSection(&image->lock);
+	delete image;
+}
+
+unsigned int _discz_SectorCount(DiscZ* image)
+{
+	return image->header.sectors;
+}
+
+// Called with the lock held.
+static bool DecodeHunk(DiscZ* image, unsigned int hunk, unsigned char* out)
+{
+	unsigned long long start = ReadOffset(image->offsets + hunk * sizeof(unsigned long long));
+	unsigned long long end = ReadOffset(image->offsets + (hunk + 1) * sizeof(unsigned long long));
+	if (start > end || end > image->size || end - start > DISCZ_HUNK_SIZE)
+		return false;
+
+	unsigned int sectors = image->header.sectors - hunk * image->header.hunkSectors;
+	if (sectors > image->header.hunkSectors)
+		sectors = image->header.hunkSectors;
+	int bytes = sectors * DISCZ_SECTOR_SIZE;
+	int packed = (int)(end - start);
+
+	if (packed == bytes)
+	{
+		memcpy(out, image->data + start, bytes);
+		return true;
+	}
+	return LZ4Decode(image->data + start, packed, out, bytes) == bytes;
+}
+
+bool _discz_Read(DiscZ* image, unsigned int sector, void* buff)
+{
+	if (sector >= image->header.sectors)
+		return false;
+
+	unsigned int hunk = sector / image->header.hunkSectors;
+	unsigned int index = sector % image->header.hunkSectors;
+
+	EnterCriticalSection(&image->lock);
+
+	CachedHunk* entry = NULL;
+	CachedHunk* oldest = &image->cache[0];
+	for (int i = 0; i < DISCZ_CACHE_HUNKS; i++)
+	{
+		CachedHunk* candidate = &image->cache[i];
+		if (candidate->hunk == hunk)
+		{
+			entry = candidate;
+			break;
+		}
+		if (candidate->hunk == DISCZ_EMPTY || (oldest->hunk != DISCZ_EMPTY && candidate->lastUse < oldest->lastUse))
+			oldest = candidate;
+	}
+
+	if (entry == NULL)
+	{
+		entry = oldest;
+		if (!DecodeHunk(image, hunk, entry->data))
+		{
+			entry->hunk = DISCZ_EMPTY;
+			LeaveCriticalSection(&image->lock);
+			return false;
+		}
+		entry->hunk = hunk;
+	}
+
+	entry->lastUse = ++image->useCounter;
+	memcpy(buff, entry->data + index * DISCZ_SECTOR_SIZE, DISCZ_SECTOR_SIZE);
+
+	LeaveCriticalSection(&image->lock);
+	return true;
+}
+
+bool _discz_Write(const char* path, unsigned int sectors, DiscZSource source, void* context)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+
+	DiscZHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "4DOZ", 4);
+	header.version = DISCZ_VERSION;
+	header.sectorSize = DISCZ_SECTOR_SIZE;
+	header.sectors = sectors;
+	header.hunkSectors = DISCZ_HUNK_SECTORS;
+	header.hunks = (sectors + DISCZ_HUNK_SECTORS - 1) / DISCZ_HUNK_SECTORS;
+
+	unsigned long long* offsets = new unsigned long long[header.hunks + 1];
+	unsigned char* hunkData = new unsigned char[DISCZ_HUNK_SIZE];
+	unsigned char* packedData = new unsigned char[DISCZ_HUNK_SIZE];
+
+	// The index is written again once every offset is known.
+	unsigned long long position = sizeof(header) + (header.hunks + 1ull) * sizeof(unsigned long long);
+	memset(offsets, 0, (header.hunks + 1) * sizeof(unsigned long long));
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(offsets, sizeof(unsigned long long), header.hunks + 1, file) == header.hunks + 1;
+
+	for (unsigned int hunk = 0; ok && hunk < header.hunks; hunk++)
+	{
+		unsigned int first = hunk * DISCZ_HUNK_SECTORS;
+		unsigned int count = (sectors - first < DISCZ_HUNK_SECTORS) ? sectors - first : DISCZ_HUNK_SECTORS;
+		int bytes = count * DISCZ_SECTOR_SIZE;
+
+		for (unsigned int i = 0; ok && i < count; i++)
+			ok = source(context, first + i, hunkData + i * DISCZ_SECTOR_SIZE);
+		if (!ok)
+			break;
+
+		// A hunk that does not shrink is stored as it is; its size tells.
+		int packed = LZ4Encode(hunkData, bytes, packedData, bytes - 1);
+		const unsigned char* out = (packed > 0) ? packedData : hunkData;
+		int size = (packed > 0) ? packed : bytes;
+
+		offsets[hunk] = position;
+		ok = fwrite(out, 1, size, file) == (size_t)size;
+		position += size;
+	}
+	offsets[header.hunks] = position;
+
+	if (ok)
+		ok = fseek(file, sizeof(header), SEEK_SET) == 0
+			&& fwrite(offsets, sizeof(unsigned long long), header.hunks + 1, file) == header.hunks + 1;
+	ok = (fclose(file) == 0) && ok;
+	if (!ok)
+		remove(path);
+
+	delete[] packedData;
+	delete[] hunkData;
+	delete[] offsets;
+	return ok;
+}
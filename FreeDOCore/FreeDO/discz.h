@@ -0,0 +1,55 @@
+// discz.h - Compressed disc images (.4doz) with random access to sectors.
+//
+// The image holds the 2048-byte user data of every sector, cut into hunks
+// of DISCZ_HUNK_SECTORS sectors that are compressed on their own, so a
+// seek only ever decompresses the one hunk it lands in:
+//
+//   DiscZHeader
+//   unsigned long long offsets[hunks + 1]   file offset of every hunk, and
+//                                           the end of the last one
+//   hunk data                               an LZ4 block, or the plain
+//                                           sectors when that is no smaller
+//
+// All numbers are little-endian. Readers keep the last DISCZ_CACHE_HUNKS
+// decompressed hunks; _discz_Read may be called from several threads.
+
+#ifndef	DISCZ_3DO_HEADER
+#define DISCZ_3DO_HEADER
+
+#define DISCZ_VERSION          1
+#define DISCZ_SECTOR_SIZE      2048
+#define DISCZ_HUNK_SECTORS     16
+#define DISCZ_HUNK_SIZE        (DISCZ_HUNK_SECTORS * DISCZ_SECTOR_SIZE)
+#define DISCZ_CACHE_HUNKS      8
+
+#pragma pack(push,1)
+
+struct DiscZHeader
+{
+	char magic[4];              // "4DOZ"
+	unsigned int version;
+	unsigned int sectorSize;
+	unsigned int sectors;
+	unsigned int hunkSectors;
+	unsigned int hunks;
+	unsigned int reserved[2];
+};
+
+#pragma pack(pop)
+
+struct DiscZ;
+
+// Reads the image from memory that stays valid until _discz_Close, such
+// as a file mapping. NULL if it is not a compressed image.
+DiscZ* _discz_Open(const unsigned char* data, unsigned long long size);
+void _discz_Close(DiscZ* image);
+
+unsigned int _discz_SectorCount(DiscZ* image);
+// False past the end or on a damaged hunk.
+bool _discz_Read(DiscZ* image, unsigned int sector, void* buff);
+
+// Fills buff with one sector of the image being written.
+typedef bool (*DiscZSource)(void* context, unsigned int sector, void* buff);
+bool _discz_Write(const char* path, unsigned int sectors, DiscZSource source, void* context);
+
+#endif
@@ -1,22 +1,92 @@
+#include <string.h>
 #include "freedoconfig.h"
 #include "freedocore.h"
 #include "frame.h"
 
 #include "hqx.h"
+#include "scalers.h"
 
 unsigned char FIXED_CLUTR[32];
 unsigned char FIXED_CLUTG[32];
 unsigned char FIXED_CLUTB[32];
 
+typedef void (*ScalerFunc)(uint32_t* src, uint32_t* dest, int width, int height);
+
+// Scaler registry. Engines sharing an init/destroy pair (the hqx family)
+// keep their tables alive while switching between each other.
+struct ScalerEngine
+{
+	ScalingAlgorithm algorithm;
+	const char* name;
+	int factor;
+	void (*init)(void);
+	void (*destroy)(void);
+	ScalerFunc scale;
+
+	// Throughput, accumulated since the engine was last selected.
+	unsigned int frames;
+	LONGLONG pixels;
+	LONGLONG ticks;
+};
+
+static ScalerEngine scalers[] =
+{
+	{ ScalingAlgorithm::None,       "none",       1, NULL,    NULL,       NULL },
+	{ ScalingAlgorithm::HQ2X,       "hq2x",       2, hqxInit, hqxDestroy, hq2x_32 },
+	{ ScalingAlgorithm::HQ3X,       "hq3x",       3, hqxInit, hqxDestroy, hq3x_32 },
+	{ ScalingAlgorithm::HQ4X,       "hq4x",       4, hqxInit, hqxDestroy, hq4x_32 },
+	{ ScalingAlgorithm::NEAREST2X,  "nearest2x",  2, NULL,    NULL,       nearest2x_32 },
+	{ ScalingAlgorithm::BILINEAR2X, "bilinear2x", 2, NULL,    NULL,       bilinear2x_32 },
+	{ ScalingAlgorithm::XBR2X,      "xbr2x",      2, xbrInit, xbrDestroy, xbr2x_32 },
+};
+#define SCALER_COUNT (sizeof(scalers) / sizeof(scalers[0]))
+
+// Expanded 15-bit -> BGRX palettes, one per recently seen CLUT set. A set is
+// only expanded when it covers enough lines to pay for the 32K entries;
+// since games rarely change CLUTs between frames it is then reused for
+// many frames.
+#define PALETTE_CACHE_SIZE  4
+#define PALETTE_MIN_LINES   32
+
+struct PaletteEntry
+{
+	VDLClut clut;
+	bool valid;
+	unsigned int lastUse;
+	unsigned int rgb[32768];
+};
+
+static PaletteEntry* paletteCache;
+static unsigned int paletteClock;
+
 static void* tempBitmap;
-static ScalingAlgorithm currentAlgorithm;
+static ScalerEngine* currentScaler;
+static LONGLONG tickFrequency;
 
 void setCurrentAlgorithm(ScalingAlgorithm algorithm);
 
+static ScalerEngine* findScaler(int algorithm)
+{
+	for (unsigned int i = 0; i < SCALER_COUNT; i++)
+		if (scalers[i].algorithm == algorithm)
+			return &scalers[i];
+	return NULL;
+}
+
 void _frame_Init()
 {
 	tempBitmap = NULL;
-	currentAlgorithm = ScalingAlgorithm::None;
+	currentScaler = &scalers[0];
+
+	if (paletteCache == NULL)
+		paletteCache = new PaletteEntry[PALETTE_CACHE_SIZE];
+	for (int i = 0; i < PALETTE_CACHE_SIZE; i++)
+		paletteCache[i].valid = false;
+	paletteClock = 0;
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	tickFrequency = frequency.QuadPart;
 
 	for(int j = 0; j < 32; j++)
 	{
@@ -26,6 +96,37 @@ void _frame_Init()
 	}
 }
 
+static unsigned int* findPalette(VDLClut* clut, int lineCount)
+{
+	PaletteEntry* victim = &paletteCache[0];
+	for (int i = 0; i < PALETTE_CACHE_SIZE; i++)
+	{
+		PaletteEntry* entry = &paletteCache[i];
+		if (entry->valid && memcmp(&entry->clut, clut, sizeof(VDLClut)) == 0)
+		{
+			entry->lastUse = ++paletteClock;
+			return entry->rgb;
+		}
+		if (!entry->valid || (victim->valid && entry->lastUse < victim->lastUse))
+			victim = entry;
+	}
+
+	if (lineCount < PALETTE_MIN_LINES)
+		return NULL;
+
+	memcpy(&victim->clut, clut, sizeof(VDLClut));
+	for (unsigned int pixel = 0; pixel < 32768; pixel++)
+	{
+		victim->rgb[pixel] =
+			clut->xCLUTB[pixel & 0x1F]
+			| (clut->xCLUTG[(pixel >> 5) & 0x1F] << 8)
+			| (clut->xCLUTR[(pixel >> 10) & 0x1F] << 16);
+	}
+	victim->valid = true;
+	victim->lastUse = ++paletteClock;
+	return victim->rgb;
+}
+
 void Get_Frame_Bitmap(
 	VDLFrame* sourceFrame,
 	void* destinationBitmap,
@@ -56,17 +157,34 @@ void Get_Frame_Bitmap(
 	// Destination will be directly changed if there is no scaling algorithm.
 	// Otherwise we extract to a temporary buffer.
 	byte* destPtr;
-	if (currentAlgorithm == ScalingAlgorithm::None)
+	if (currentScaler->scale == NULL)
 		destPtr = (byte*)destinationBitmap;
 	else
 		destPtr = (byte*)tempBitmap;
 
 	VDLFrame* framePtr = sourceFrame;
+
+	// Count the lines using each CLUT set, to decide which are worth expanding.
+	unsigned short clutLines[240];
+	memset(clutLines, 0, sizeof(clutLines));
+	for (int line = 0; line < copyHeight; line++)
+		clutLines[framePtr->lines[line].xCLUTSET]++;
+
+	unsigned int currentSet = 0xFFFFFFFF;
+	VDLClut* clut = NULL;
+	unsigned int* palette = NULL;
+
 	for (int line = 0; line < copyHeight; line++)
 	{
 		VDLLine* linePtr = &framePtr->lines[line];
 		short* srcPtr = (short*)linePtr;
 		bool allowFixedClut = (linePtr->xOUTCONTROLL & 0x2000000) > 0;
+		if (linePtr->xCLUTSET != currentSet)
+		{
+			currentSet = linePtr->xCLUTSET;
+			clut = &framePtr->cluts[currentSet];
+			palette = findPalette(clut, clutLines[currentSet]);
+		}
 		for (int pix = 0; pix < copyWidth; pix++)
 		{
 			byte bPart = 0;
@@ -84,11 +202,18 @@ void Get_Frame_Bitmap(
 				gPart = FIXED_CLUTG[((*srcPtr) >> 5) & 0x1F];
 				rPart = FIXED_CLUTR[(*srcPtr) >> 10 & 0x1F];
 			}
+			else if (palette != NULL)
+			{
+				unsigned int rgb = palette[(*srcPtr) & 0x7FFF];
+				bPart = (byte)rgb;
+				gPart = (byte)(rgb >> 8);
+				rPart = (byte)(rgb >> 16);
+			}
 			else
 			{
-				bPart = (byte)(linePtr->xCLUTB[(*srcPtr) & 0x1F]);
-				gPart = linePtr->xCLUTG[((*srcPtr) >> 5) & 0x1F];
-				rPart = linePtr->xCLUTR[(*srcPtr) >> 10 & 0x1F];
+				bPart = clut->xCLUTB[(*srcPtr) & 0x1F];
+				gPart = clut->xCLUTG[((*srcPtr) >> 5) & 0x1F];
+				rPart = clut->xCLUTR[(*srcPtr) >> 10 & 0x1F];
 			}
 			*destPtr++ = bPart;
 			*destPtr++ = gPart;
@@ -115,24 +240,17 @@ void Get_Frame_Bitmap(
 		}
 	}
 
-	int cropAdjust = 1;
-	switch (currentAlgorithm)
+	int cropAdjust = currentScaler->factor;
+	if (currentScaler->scale != NULL)
 	{
-	case ScalingAlgorithm::None:
-		// Nothing left to do
-		break;
-	case ScalingAlgorithm::HQ2X:
-		hq2x_32((uint32_t*)tempBitmap, (uint32_t*)destinationBitmap, copyWidth, copyHeight);
-		cropAdjust = 2;
-		break;
-	case ScalingAlgorithm::HQ3X:
-		hq3x_32((uint32_t*)tempBitmap, (uint32_t*)destinationBitmap, copyWidth, copyHeight);
-		cropAdjust = 3;
-		break;
-	case ScalingAlgorithm::HQ4X:
-		hq4x_32((uint32_t*)tempBitmap, (uint32_t*)destinationBitmap, copyWidth, copyHeight);
-		cropAdjust = 4;
-		break;
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+		currentScaler->scale((uint32_t*)tempBitmap, (uint32_t*)destinationBitmap, copyWidth, copyHeight);
+		QueryPerformanceCounter(&end);
+
+		currentScaler->frames++;
+		currentScaler->pixels += (LONGLONG)copyWidth * copyHeight * cropAdjust * cropAdjust;
+		currentScaler->ticks += end.QuadPart - start.QuadPart;
 	}
 
 	bitmapCrop->top *= cropAdjust;
@@ -146,35 +264,54 @@ void Get_Frame_Bitmap(
 
 void setCurrentAlgorithm(ScalingAlgorithm algorithm)
 {
+	ScalerEngine* engine = findScaler(algorithm);
+	if (engine == NULL)
+		engine = &scalers[0];
+
+	if (engine == currentScaler)
+		return;
+
 	//////////////////
 	// De-initialize current (if necessary).
-	if (
-		((currentAlgorithm == ScalingAlgorithm::HQ2X)
-		|| (currentAlgorithm == ScalingAlgorithm::HQ3X)
-		|| (currentAlgorithm == ScalingAlgorithm::HQ4X))
-		&& algorithm != ScalingAlgorithm::HQ2X
-		&& algorithm != ScalingAlgorithm::HQ3X
-		&& algorithm != ScalingAlgorithm::HQ4X )
+	if (currentScaler->destroy != NULL && currentScaler->destroy != engine->destroy)
+		currentScaler->destroy();
+	if (currentScaler->scale != NULL && engine->scale == NULL)
 	{
-		delete tempBitmap;
-		hqxDestroy();
+		delete[] (unsigned char*)tempBitmap;
+		tempBitmap = NULL;
 	}
 
 	//////////////////
-	// Initialize current (if necessary).
-
-	if (
-		((algorithm == ScalingAlgorithm::HQ2X)
-		|| (algorithm == ScalingAlgorithm::HQ3X)
-		|| (algorithm == ScalingAlgorithm::HQ4X))
-		&& currentAlgorithm != ScalingAlgorithm::HQ2X
-		&& currentAlgorithm != ScalingAlgorithm::HQ3X
-		&& currentAlgorithm != ScalingAlgorithm::HQ4X )
-	{
-		hqxInit();
+	// Initialize new (if necessary).
+	if (engine->init != NULL && engine->init != currentScaler->init)
+		engine->init();
+	if (engine->scale != NULL && tempBitmap == NULL)
 		tempBitmap = new unsigned char[1280*960*4];
-	}
 
-	// Accept new current algorithm.
-	currentAlgorithm = algorithm;
+	// Accept new current algorithm, starting its throughput figures afresh.
+	engine->frames = 0;
+	engine->pixels = 0;
+	engine->ticks = 0;
+	currentScaler = engine;
+}
+
+bool _frame_GetScalerInfo(ScalerInfo* info)
+{
+	ScalerEngine* engine = findScaler(info->scalingAlgorithm);
+	if (engine == NULL)
+		return false;
+
+	strncpy(info->name, engine->name, sizeof(info->name) - 1);
+	info->name[sizeof(info->name) - 1] = 0;
+	info->factor = engine->factor;
+	info->frames = engine->frames;
+	info->averageMilliseconds = 0;
+	info->megapixelsPerSecond = 0;
+	if (engine->frames > 0 && engine->ticks > 0 && tickFrequency > 0)
+	{
+		double seconds = (double)engine->ticks / tickFrequency;
+		info->averageMilliseconds = seconds * 1000 / engine->frames;
+		info->megapixelsPerSecond = engine->pixels / seconds / 1000000;
+	}
+	return true;
 }
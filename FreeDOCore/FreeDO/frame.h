@@ -19,4 +19,7 @@ void Get_Frame_Bitmap(
 	int* resultingWidth,
 	int* resultingHeight);
 
+// Fills in info for info->scalingAlgorithm; false if there is no such scaler.
+bool _frame_GetScalerInfo(ScalerInfo* info);
+
 #endif 
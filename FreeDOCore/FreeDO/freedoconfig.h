@@ -46,9 +46,19 @@ Felix Lazarev
 	#define RESSCALE        HightResMode
 	#define DEBUG_CORE
 	#define _T(a) (a)
+
+	// Interlocked primitives used by the lock-free frame handoff.
+	typedef long LONG;
+	#define InterlockedExchange(target,value)       __atomic_exchange_n((target),(value),__ATOMIC_SEQ_CST)
 #endif
 
 #include "types.h"
 
+// Uncomment to build the traced DSP engine: every ALU op is checked for
+// operand conflicts and every instruction is logged to DSP_TRACE_FILE.
+// The normal build carries no debug code in the DSP loop at all.
+//#define DSP_TRACE
+#define DSP_TRACE_FILE	"dsptrace.log"
+
 
 #endif // FREEDOCONFIG_H
@@ -31,17 +31,23 @@ struct VDLLine
 //VDLP Line - one VDLP line per patent
 {
 	unsigned short line[320*4];//,line2[320*2*16];
-	unsigned char xCLUTB[32];
-	unsigned char xCLUTG[32];
-	unsigned char xCLUTR[32];
+	unsigned int xCLUTSET;          // index into VDLFrame::cluts
 	unsigned int xOUTCONTROLL;
 	unsigned int xCLUTDMA;
 	unsigned int xBACKGROUND;
 };
+struct VDLClut
+{
+	unsigned char xCLUTB[32];
+	unsigned char xCLUTG[32];
+	unsigned char xCLUTR[32];
+};
 struct VDLFrame
 {
 	VDLLine lines[240*4];
 	unsigned int srcw,srch;
+	unsigned int clutcount;         // CLUT sets emitted this frame, one per change
+	VDLClut cluts[240];
 };
 
 struct BitmapCrop
@@ -73,7 +79,51 @@ enum ScalingAlgorithm
 	None = 0,
 	HQ2X = 1,
 	HQ3X = 2,
-	HQ4X = 3
+	HQ4X = 3,
+	NEAREST2X = 4,
+	BILINEAR2X = 5,
+	XBR2X = 6
+};
+
+struct ScalerInfo
+{
+	int scalingAlgorithm;        // in
+	char name[16];
+	int factor;
+	unsigned int frames;         // frames scaled since the scaler was selected
+	double averageMilliseconds;
+	double megapixelsPerSecond;  // output pixels
+};
+
+struct SampleBlock
+{
+	unsigned int* samples;       // same layout as EXT_PUSH_SAMPLE, valid only inside the callback
+	int count;
+};
+
+struct DiscSectorRequest
+{
+	unsigned int sector;
+	void* buffer;                // 2048 bytes
+};
+
+struct DiscCompressRequest
+{
+	const char* source;          // any image FDP_DISC_OPEN accepts
+	const char* target;
+};
+
+struct SectorTraceRequest
+{
+	const char* tracePath;       // may be NULL
+	const char* profilePath;     // may be NULL
+	unsigned int bootSeconds;    // how much of the start of the trace goes into the profile
+};
+
+struct StateBuffer
+{
+	void* data;
+	unsigned int length;         // bytes of data that hold the state
 };
 
 #pragma pack(pop)
@@ -81,28 +131,29 @@ enum ScalingAlgorithm
 #define EXT_READ_ROMS           1
 #define EXT_READ_NVRAM          2
 #define EXT_WRITE_NVRAM         3
-#define EXT_SWAPFRAME           5       //frame swap (in mutlithreaded) or frame draw(single treaded)
-#define EXT_PUSH_SAMPLE         6       //sends sample to the buffer
+#define EXT_SWAPFRAME           5       //frame done, datum is the finished frame (valid only inside the callback)
+#define EXT_PUSH_SAMPLE         6       //sends sample to the buffer (no longer sent, see EXT_PUSH_SAMPLES)
 #define EXT_GET_PBUSLEN         7
 #define EXT_GETP_PBUSDATA       8
 #define EXT_KPRINT              9
 #define EXT_DEBUG_PRINT         10
 #define EXT_FRAMETRIGGER_MT     12      //multitasking
-#define EXT_READ2048            14      //for XBUS Plugin
+#define EXT_READ2048            14      //for XBUS Plugin, reads the sector named by the EXT_ON_SECTOR just before it
 #define EXT_GET_DISC_SIZE       15
-#define EXT_ON_SECTOR           16
+#define EXT_ON_SECTOR           16      //may come from the core's read-ahead thread, always paired with EXT_READ2048
 #define EXT_ARM_SYNC            17
+#define EXT_PUSH_SAMPLES        18      //datum is a SampleBlock, sent per AUDIO_BLOCK_SAMPLES and at the end of a frame
 typedef void* (__stdcall *_ext_Interface)(int, void*);
 
 #define FDP_FREEDOCORE_VERSION  0
 #define FDP_INIT                1    //set ext_interface
 #define FDP_DESTROY             2
 #define FDP_DO_EXECFRAME        3       //execute 1/60 of second
-#define FDP_DO_FRAME_MT         4      //multitasking
+#define FDP_DO_FRAME_MT         4      //multitasking, copies the newest finished frame to datum
 #define FDP_DO_EXECFRAME_MT     5      //multitasking
 #define FDP_DO_LOAD             6       //load state from buffer, returns !NULL if everything went smooth
-#define FDP_GET_SAVE_SIZE       7       //return size of savestatemachine
-#define FDP_DO_SAVE             8       //save state to buffer
+#define FDP_GET_SAVE_SIZE       7       //return size of savestatemachine (room for the largest state, full or incremental)
+#define FDP_DO_SAVE             8       //save state to buffer, returns the length
 #define FDP_GETP_NVRAM          9       //returns ptr to NVRAM 32K
 #define FDP_GETP_RAMS           10       //returns ptr to RAM 3M
 #define FDP_GETP_ROMS           11       //returns ptr to ROM 2M
@@ -115,6 +166,27 @@ typedef void* (__stdcall *_ext_Interface)(int, void*);
 #define FDP_GET_FRAME_BITMAP    18
 #define FDP_GET_BIOS_TYPE		19
 #define FDP_SET_ANVIL			20
+#define FDP_GETP_FRAME          21      //returns ptr to the newest finished frame, owned by the caller until the next call
+#define FDP_GET_SCALER_INFO     22      //fills ScalerInfo at datum, returns !NULL if the scaler exists
+#define FDP_CAPTURE_START       23      //start streaming frames to the file named by datum, returns !NULL on success
+#define FDP_CAPTURE_STOP        24      //flush and close the capture, returns the number of dropped frames
+#define FDP_AUDIO_SET_RATE      25      //datum is the host output rate in Hz, 0 turns the resampled output off
+#define FDP_AUDIO_READ          26      //datum is a SampleBlock to fill with up to count resampled samples, returns the count read
+#define FDP_AUDIO_GET_BUFFERED  27      //returns the number of resampled samples waiting to be read
+#define FDP_AUDIO_WAIT          28      //blocks until at most datum samples are buffered (0 = default latency), returns the count
+#define FDP_AUDIO_CAPTURE_START 29      //start recording DSP output to the WAV (or .flac) file named by datum, returns !NULL on success
+#define FDP_AUDIO_CAPTURE_STOP  30      //finish and close the recording, returns the number of dropped samples
+#define FDP_DISC_OPEN           31      //map the disc image (.iso, BIN/CUE or .4doz) named by datum and read sectors from it, returns !NULL on success; call while the core is not running
+#define FDP_DISC_CLOSE          32      //unmap the disc image, back to EXT_READ2048; call while the core is not running
+#define FDP_DISC_READ           33      //datum is a DiscSectorRequest, copies one sector of the open image, returns !NULL on success
+#define FDP_DISC_COMPRESS       34      //datum is a DiscCompressRequest, writes source as a .4doz image, returns !NULL on success
+#define FDP_SET_CD_TIMING       35      //datum is one of CD_TIMING_*, may be changed at any time; returns NULL, changing nothing, for any other value
+#define FDP_SECTOR_TRACE_START  36      //start recording the sectors the drive reads; call right after FDP_INIT, returns !NULL on success
+#define FDP_SECTOR_TRACE_STOP   37      //datum is a SectorTraceRequest, writes the trace and boot profile, returns !NULL if the profile was written
+#define FDP_SECTOR_PRELOAD      38      //read the sectors of the boot profile named by datum ahead of time; call after FDP_INIT, returns the number of sectors
+#define FDP_SET_SAVE_BASE       39      //start tracking RAM changes against a copy of the current RAM, returns the base's id
+#define FDP_DO_SAVE_INCREMENTAL 40      //save state to buffer (FDP_GET_SAVE_SIZE bytes) with only the RAM pages changed since the base, returns the length, 0 without a base; FDP_DO_LOAD takes it back while the base is current
+#define FDP_DO_LOAD_BUFFER      41      //datum is a StateBuffer, like FDP_DO_LOAD but never reads past length; returns !NULL if the state loaded, and changes nothing if not
 
 #define FIX_BIT_TIMING_1        (0x00000001)
 #define FIX_BIT_TIMING_2        (0x00000002)
@@ -126,6 +198,10 @@ typedef void* (__stdcall *_ext_Interface)(int, void*);
 #define FIX_BIT_GRAPHICS_STEP_Y (0x00080000) // Preserve Y coordinate rather than X between CELs.
 #define BIOS_ANVIL (0x40)
 
+#define CD_TIMING_TURBO         0       // sectors are there as soon as they are asked for
+#define CD_TIMING_1X            1       // seek, then 75 sectors a second
+#define CD_TIMING_2X            2       // seek, then 150 sectors a second
+
 #ifdef __MSVC__
 
 #ifdef FREEDOCORE_EXPORTS
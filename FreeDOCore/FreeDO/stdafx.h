@@ -21,6 +21,7 @@ extern int unknownflag11;
 extern int HightResMode;
 extern int jw;
 extern int cnbfix;
+extern int cdtiming;
 
 #define DEBUG_CORE
 
@@ -101,6 +101,19 @@ struct VDLDatum
 static VDLDatum vdl;
 static unsigned char * vram;
 
+// Scan-out triple buffer. The emulation thread scans into frames[scanidx],
+// the display owns frames[displayidx], and a finished frame is handed over
+// through sharedidx with an interlocked exchange (no locks, no tearing).
+#define FRAME_FRESH   4
+#define FRAME_INDEX   3
+static VDLFrame *frames[3];
+static volatile LONG sharedidx;
+static int scanidx, displayidx;
+
+// Set whenever the VDL touches the CLUT; the next visible line then checks
+// whether it really changed and, if so, emits a new CLUT set into the frame.
+static bool clutdirty=true;
+
 unsigned int _vdl_SaveSize()
 {
         return sizeof(VDLDatum);
@@ -112,6 +125,7 @@ void _vdl_Save(void *buff)
 void _vdl_Load(void *buff)
 {
         memcpy(&vdl,buff,sizeof(VDLDatum));
+        clutdirty=true;
 }
 
 #define CLUTB vdl.CLUTB
@@ -186,6 +200,7 @@ __inline void VDLExec()
 
 				        if(!(cmd&VDL_CONTROL))
 					{	//color value
+						clutdirty=true;
 
 						unsigned int coloridx=(cmd&VDL_PEN_MASK)>>VDL_PEN_SHIFT;
 						if((cmd&VDL_RGBCTL_MASK)==VDL_FULLRGB)
@@ -224,6 +239,7 @@ __inline void VDLExec()
                                         else if((unsigned int)cmd==0xffffffff)
 					{
 						if(ifgnorflag)continue;
+						clutdirty=true;
 						for(unsigned int j=0;j<32;j++)
 						{
 							CLUTB[j]=CLUTG[j]=CLUTR[j]=((j&0x1f)<<3)|((j>>2)&7);
@@ -260,6 +276,7 @@ void _vdl_DoLineNew(int line2x, VDLFrame *frame)
 
 	if(line==0)
 	{
+                frame->clutcount=0;
                 doloadclut=true;
                 linedelay=0;
 		CURRENTVDL=HEADVDL;
@@ -306,19 +323,23 @@ void _vdl_DoLineNew(int line2x, VDLFrame *frame)
                                 i=320;
                                 while(i--)*dst++=*(unsigned short*)(src++);
                         }
-                        memcpy(frame->lines[(y<<RESSCALE)].xCLUTB,CLUTB,32);
-                        memcpy(frame->lines[(y<<RESSCALE)].xCLUTG,CLUTG,32);
-                        memcpy(frame->lines[(y<<RESSCALE)].xCLUTR,CLUTR,32);
-                        if(RESSCALE)
+                }
+                if(clutdirty || !frame->clutcount)
+                {
+                        if(!frame->clutcount || memcmp(frame->cluts[frame->clutcount-1].xCLUTB,CLUTB,32*3))
                         {
-                                memcpy(frame->lines[(y<<RESSCALE)+1].xCLUTB,frame->lines[(y<<RESSCALE)].xCLUTB,32*3);
+                                memcpy(frame->cluts[frame->clutcount].xCLUTB,CLUTB,32*3);
+                                frame->clutcount++;
                         }
+                        clutdirty=false;
                 }
+                frame->lines[(y<<RESSCALE)].xCLUTSET=frame->clutcount-1;
                 frame->lines[(y<<RESSCALE)].xOUTCONTROLL=OUTCONTROLL;
                 frame->lines[(y<<RESSCALE)].xCLUTDMA=CLUTDMA.raw;
                 frame->lines[(y<<RESSCALE)].xBACKGROUND=BACKGROUND;
                 if(RESSCALE)
                 {
+                        frame->lines[(y<<RESSCALE)+1].xCLUTSET=frame->clutcount-1;
                         frame->lines[(y<<RESSCALE)+1].xOUTCONTROLL=OUTCONTROLL;
                         frame->lines[(y<<RESSCALE)+1].xCLUTDMA=CLUTDMA.raw;
                         frame->lines[(y<<RESSCALE)+1].xBACKGROUND=BACKGROUND;
@@ -380,6 +401,62 @@ void _vdl_Init(unsigned char *vramstart)
 	{
 		CLUTB[i]=CLUTG[i]=CLUTR[i]=((i&0x1f)<<3)|((i>>2)&7);
 	}
+	clutdirty=true;
+
+	for(int i=0;i<3;i++)
+	{
+		if(!frames[i])frames[i]=new VDLFrame;
+		memset(frames[i],0,sizeof(VDLFrame));
+	}
+	scanidx=0;
+	sharedidx=1;
+	displayidx=2;
+}
+
+void _vdl_Destroy()
+{
+	for(int i=0;i<3;i++)
+	{
+		delete frames[i];
+		frames[i]=NULL;
+	}
+}
+
+VDLFrame* _vdl_ScanFrame()
+{
+	return frames[scanidx];
+}
+
+// Emulation side: hands the finished frame over and takes back a free one.
+VDLFrame* _vdl_SwapFrame()
+{
+ VDLFrame *done=frames[scanidx];
+
+	done->srcw=320;
+	done->srch=240;
+	scanidx=InterlockedExchange(&sharedidx,scanidx|FRAME_FRESH)&FRAME_INDEX;
+	return done;
+}
+
+// Display side: returns the newest finished frame. It stays untouched by the
+// emulation thread until the next call.
+VDLFrame* _vdl_GetDisplayFrame()
+{
+	if(sharedidx&FRAME_FRESH)
+		displayidx=InterlockedExchange(&sharedidx,displayidx)&FRAME_INDEX;
+
+	return frames[displayidx];
+}
+
+void _vdl_CopyDisplayFrame(VDLFrame *frame)
+{
+ VDLFrame *src=_vdl_GetDisplayFrame();
+
+	memcpy(frame->lines,src->lines,sizeof(VDLLine)*(240<<RESSCALE));
+	frame->srcw=src->srcw;
+	frame->srch=src->srch;
+	frame->clutcount=src->clutcount;
+	memcpy(frame->cluts,src->cluts,sizeof(VDLClut)*src->clutcount);
 }
 
 unsigned int vmreadw(unsigned int addr)
@@ -35,6 +35,12 @@ Felix Lazarev
 
         void _vdl_DoLineNew(int line, VDLFrame *frame);
 
+        void _vdl_Destroy();
+        VDLFrame* _vdl_ScanFrame();
+        VDLFrame* _vdl_SwapFrame();
+        VDLFrame* _vdl_GetDisplayFrame();
+        void _vdl_CopyDisplayFrame(VDLFrame *frame);
+
         unsigned int _vdl_SaveSize();
         void _vdl_Save(void *buff);
         void _vdl_Load(void *buff);